@@ -18,9 +18,11 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <dirent.h>
 #include <boost/algorithm/string.hpp> // for case-insensitive string compare
 #include <boost/program_options.hpp>
 #include <camoto/gamegraphics.hpp>
@@ -371,16 +373,16 @@ void map2dToPng(const gm::Map2D& map, const gm::TilesetCollection& allTilesets,
 		}
 	}
 
-	for (auto& layer : map.layers()) {
+	for (auto& layer : map.layerView()) {
 		// Figure out the layer size (in tiles) and the tile size
 		gg::Point layerSize, tileSize;
-		getLayerDims(map, *layer, &layerSize, &tileSize);
+		getLayerDims(map, layer, &layerSize, &tileSize);
 
 		// Prepare tileset
 		std::vector<CachedTile> cache;
 
 		// Run through all items in the layer and render them one by one
-		for (auto& t : layer->items()) {
+		for (auto& t : layer.itemView()) {
 			CachedTile thisTile;
 			unsigned int tileCode = t.code;
 
@@ -397,7 +399,7 @@ void map2dToPng(const gm::Map2D& map, const gm::TilesetCollection& allTilesets,
 				// Tile hasn't been cached yet, load it from the tileset
 				gm::Map2D::Layer::ImageFromCodeInfo imgType;
 				try {
-					imgType = layer->imageFromCode(t, allTilesets);
+					imgType = layer.imageFromCode(t, allTilesets);
 				} catch (const std::exception& e) {
 					std::cerr << "Error loading image: " << e.what() << std::endl;
 					imgType.type = gm::Map2D::Layer::ImageFromCodeInfo::ImageType::Unknown;
@@ -456,6 +458,80 @@ void map2dToPng(const gm::Map2D& map, const gm::TilesetCollection& allTilesets,
 	return;
 }
 
+/// Add a file to the list, or if it's a directory, every file inside it.
+void addLintTargets(const std::string& path, std::vector<std::string>& out)
+{
+	DIR *dir = opendir(path.c_str());
+	if (!dir) {
+		// Not a directory, so check it as a map
+		out.push_back(path);
+		return;
+	}
+	std::vector<std::string> entries;
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != NULL) {
+		std::string name = entry->d_name;
+		if ((name.compare(".") == 0) || (name.compare("..") == 0)) continue;
+		entries.push_back(path + "/" + name);
+	}
+	closedir(dir);
+
+	// Sort so the output doesn't depend on the order of the directory entries
+	std::sort(entries.begin(), entries.end());
+	for (auto& e : entries) addLintTargets(e, out);
+	return;
+}
+
+/// Check a list of maps (or directories of maps) and print any problems.
+/**
+ * @return RET_OK if every map is fine, RET_NONCRITICAL_FAILURE otherwise.
+ */
+int lintMaps(const std::vector<std::string>& targets, const std::string& type,
+	unsigned int jobs, bool bScript)
+{
+	std::vector<std::string> filenames;
+	for (auto& t : targets) addLintTargets(t, filenames);
+
+	auto issues = gm::lint(filenames, type, jobs);
+	for (auto& i : issues) {
+		if (bScript) {
+			std::cout << "file=" << i.filename
+				<< ";type=" << i.mapType
+				<< ";issue=" << (unsigned int)i.type
+				<< ";layer=" << i.layer
+				<< ";item=" << i.index
+				<< ";x=" << i.pos.x
+				<< ";y=" << i.pos.y
+				<< ";code=" << i.code
+				<< ";max=" << i.maxCount
+				<< ";message=" << i.message << "\n";
+		} else {
+			std::cout << i.filename;
+			if (!i.mapType.empty()) std::cout << " [" << i.mapType << "]";
+			switch (i.type) {
+				case gm::LintIssue::Type::OutOfBounds:
+				case gm::LintIssue::Type::NotPermitted:
+				case gm::LintIssue::Type::TooMany:
+					std::cout << ": layer " << i.layer + 1 << ", item " << i.index
+						<< " at " << i.pos.x << "," << i.pos.y << " (code 0x"
+						<< std::hex << i.code << std::dec << ")";
+					break;
+				case gm::LintIssue::Type::TooManyCodes:
+					std::cout << ": layer " << i.layer + 1;
+					break;
+				default:
+					break;
+			}
+			std::cout << ": " << i.message << "\n";
+		}
+	}
+	if (!bScript) {
+		std::cout << "Checked " << filenames.size() << " file(s), found "
+			<< issues.size() << " problem(s)." << std::endl;
+	}
+	return issues.empty() ? RET_OK : RET_NONCRITICAL_FAILURE;
+}
+
 int main(int iArgC, char *cArgV[])
 {
 #ifdef __GLIBCXX__
@@ -491,6 +567,11 @@ int main(int iArgC, char *cArgV[])
 			"force open even if the map is not in the given format")
 		("list-types",
 			"list supported file types")
+		("lint,l",
+			"check every map given (files or directories) for problems, instead "
+			"of running actions on a single map")
+		("jobs,j", po::value<unsigned int>(),
+			"number of maps to check at once with --lint (default one per CPU)")
 	;
 
 	po::options_description poHidden("Hidden parameters");
@@ -507,6 +588,9 @@ int main(int iArgC, char *cArgV[])
 	po::variables_map mpArgs;
 
 	std::string strFilename, strType;
+	std::vector<std::string> lintTargets;
+	unsigned int lintJobs = 0;
+	bool bLint = false; // check many maps instead of opening one?
 	std::map<gm::ImagePurpose, gm::Map::GraphicsFilename> manualGfx;
 
 	bool bScript = false; // show output suitable for script parsing?
@@ -518,15 +602,10 @@ int main(int iArgC, char *cArgV[])
 		// Parse the global command line options
 		for (auto& i : pa.options) {
 			if (i.string_key.empty()) {
-				// If we've already got an map filename, complain that a second one
-				// was given (probably a typo.)
-				if (!strFilename.empty()) {
-					std::cerr << "Error: unexpected extra parameter (multiple map "
-						"filenames given?!)" << std::endl;
-					return 1;
-				}
 				assert(i.value.size() > 0);  // can't have no values with no name!
-				strFilename = i.value[0];
+				// Keep every filename in case --lint is given later on
+				lintTargets.push_back(i.value[0]);
+				if (strFilename.empty()) strFilename = i.value[0];
 			} else if (i.string_key.compare("help") == 0) {
 				std::cout <<
 					"Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>\n"
@@ -582,6 +661,16 @@ int main(int iArgC, char *cArgV[])
 				(i.string_key.compare("force") == 0)
 			) {
 				bForceOpen = true;
+			} else if (
+				(i.string_key.compare("l") == 0) ||
+				(i.string_key.compare("lint") == 0)
+			) {
+				bLint = true;
+			} else if (
+				(i.string_key.compare("j") == 0) ||
+				(i.string_key.compare("jobs") == 0)
+			) {
+				lintJobs = strtoul(i.value[0].c_str(), NULL, 10);
 			} else if (
 				(i.string_key.compare("list-types") == 0)
 			) {
@@ -637,6 +726,14 @@ int main(int iArgC, char *cArgV[])
 			std::cerr << "Error: no game map filename given" << std::endl;
 			return RET_BADARGS;
 		}
+		if (bLint) return lintMaps(lintTargets, strType, lintJobs, bScript);
+
+		// If we've got more than one map filename, complain (probably a typo.)
+		if (lintTargets.size() > 1) {
+			std::cerr << "Error: unexpected extra parameter (multiple map "
+				"filenames given?!)" << std::endl;
+			return 1;
+		}
 		std::cout << "Opening " << strFilename << " as type "
 			<< (strType.empty() ? "<autodetect>" : strType) << std::endl;
 
@@ -933,7 +1030,7 @@ finishTesting:
 					gg::Point layerSize, tileSize;
 					getLayerDims(*map2d, *layer, &layerSize, &tileSize);
 
-					auto items = layer->items();
+					auto items = layer->itemView();
 					auto t = items.begin();
 					unsigned int numItems = items.size();
 					if (t != items.end()) {
@@ -1019,6 +1116,9 @@ finishTesting:
 			// Ignore --force/-f
 			} else if (i.string_key.compare("force") == 0) {
 			} else if (i.string_key.compare("f") == 0) {
+			// Ignore --jobs/-j
+			} else if (i.string_key.compare("jobs") == 0) {
+			} else if (i.string_key.compare("j") == 0) {
 
 			}
 		} // for (all command line elements)
@@ -79,10 +79,19 @@ Additional information is available from the Camoto homepage
 }
 
 // These are all in the camoto::gamemaps namespace
+#include <camoto/gamemaps/arena.hpp>
 #include <camoto/gamemaps/map.hpp>
 #include <camoto/gamemaps/maptype.hpp>
 #include <camoto/gamemaps/manager.hpp>
 #include <camoto/gamemaps/map2d.hpp>
 #include <camoto/gamemaps/util.hpp>
+#include <camoto/gamemaps/journal.hpp>
+#include <camoto/gamemaps/lint.hpp>
+#include <camoto/gamemaps/diff.hpp>
+#include <camoto/gamemaps/fingerprint.hpp>
+#include <camoto/gamemaps/native.hpp>
+#include <camoto/gamemaps/cache.hpp>
+#include <camoto/gamemaps/actrinfo-cosmo.hpp>
+#include <camoto/gamemaps/rle-wordresc.hpp>
 
 #endif // _CAMOTO_GAMEMAPS_HPP_
@@ -0,0 +1,128 @@
+/**
+ * @file  camoto/gamemaps/actrinfo-cosmo.hpp
+ * @brief Actor information from Cosmo's Cosmic Adventures ACTRINFO.MNI.
+ *
+ * This file format is fully documented on the ModdingWiki:
+ *   http://www.shikadi.net/moddingwiki/ACTRINFO.MNI
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _CAMOTO_GAMEMAPS_ACTRINFO_COSMO_HPP_
+#define _CAMOTO_GAMEMAPS_ACTRINFO_COSMO_HPP_
+
+#include <memory>
+#include <vector>
+#include <camoto/stream.hpp>
+#include <camoto/gamemaps/map.hpp>
+
+#ifndef CAMOTO_GAMEMAPS_API
+#define CAMOTO_GAMEMAPS_API
+#endif
+
+namespace camoto {
+namespace gamemaps {
+
+/// Size information for each actor listed in ACTRINFO.MNI.
+/**
+ * Only the parts of the file needed to lay out actors on the map are kept,
+ * namely the height of each actor's first frame and the number of frames.
+ *
+ * Once loaded the data never changes, so a single instance can be shared
+ * between any number of levels opened with openCosmo().
+ */
+class CAMOTO_GAMEMAPS_API ActorInfo_Cosmo
+{
+	public:
+		/// Load the actor info from ACTRINFO.MNI.
+		/**
+		 * The whole file is loaded with a single read and parsed from memory.
+		 *
+		 * @param content
+		 *   ACTRINFO.MNI data.
+		 *
+		 * @throw stream::error
+		 *   The file is truncated or an offset points past the end of the file.
+		 */
+		ActorInfo_Cosmo(stream::input& content);
+
+		/// Parse actor info already loaded into memory.
+		/**
+		 * @param data
+		 *   Content of ACTRINFO.MNI.
+		 *
+		 * @param len
+		 *   Number of bytes at data.
+		 *
+		 * @throw stream::error
+		 *   The data is truncated or an offset points past the end of it.
+		 */
+		ActorInfo_Cosmo(const uint8_t *data, unsigned long len);
+
+		/// Number of actors in the file.
+		unsigned int size() const;
+
+		/// Height of the actor's first frame, in tiles.
+		/**
+		 * @param index
+		 *   Actor index, must be less than size().
+		 */
+		unsigned int height(unsigned int index) const;
+
+		/// Number of frames the actor has.
+		/**
+		 * @param index
+		 *   Actor index, must be less than size().
+		 */
+		unsigned int frameCount(unsigned int index) const;
+
+	private:
+		void parse(const uint8_t *data, unsigned long len);
+
+		/// Height of each actor's first frame, in tiles
+		std::vector<unsigned int> heights;
+
+		/// Number of frames in each actor
+		std::vector<unsigned int> frames;
+};
+
+/// Open a Cosmo level using actor info that has already been loaded.
+/**
+ * This is the same as opening the level through the map2d-cosmo MapType, but
+ * instead of parsing the Extra1 supplementary stream each time, the given
+ * actor info is used.  Tools that open many levels from the same episode can
+ * load ACTRINFO.MNI once and pass the same instance to every call.
+ *
+ * @param content
+ *   Level data.
+ *
+ * @param actorInfo
+ *   Actor info for the episode the level belongs to.
+ *
+ * @return The opened level, a Map2D.
+ *
+ * @throw stream::error
+ *   The level data is truncated or invalid.
+ */
+CAMOTO_GAMEMAPS_API std::unique_ptr<Map> openCosmo(
+	std::unique_ptr<stream::inout> content,
+	std::shared_ptr<const ActorInfo_Cosmo> actorInfo);
+
+} // namespace gamemaps
+} // namespace camoto
+
+#endif // _CAMOTO_GAMEMAPS_ACTRINFO_COSMO_HPP_
@@ -0,0 +1,191 @@
+/**
+ * @file  camoto/gamemaps/arena.hpp
+ * @brief Memory arena that maps can be loaded into and released all at once.
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _CAMOTO_GAMEMAPS_ARENA_HPP_
+#define _CAMOTO_GAMEMAPS_ARENA_HPP_
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#ifndef CAMOTO_GAMEMAPS_API
+#define CAMOTO_GAMEMAPS_API
+#endif
+
+namespace camoto {
+namespace gamemaps {
+
+/// Memory that maps can be loaded into, and released all at once.
+/**
+ * Pass an arena to MapType::openInArena() or MapType::createInArena() and
+ * the map's item lists, its packed grid layers and the temporary buffers used
+ * while parsing it are carved out of a few large blocks instead of being
+ * allocated one at a time.  Memory is never handed back to the arena; it is all released
+ * together when the arena is destroyed.  This suits maps that are opened,
+ * inspected and thrown away, as they don't leave the heap fragmented.
+ *
+ * The rest of the map, such as the Map and Layer objects themselves, their
+ * attributes, any text in items and the list returned by Layer::items(),
+ * still comes from the heap.
+ *
+ * @note Every map opened in the arena must be destroyed before the arena.
+ *   This includes snapshots of those maps, and other maps sharing their
+ *   items through restoreSnapshot().
+ *
+ * An arena can be used from several threads at once.
+ */
+class CAMOTO_GAMEMAPS_API MapArena
+{
+	public:
+		/// Makes an arena the one used by maps opened on this thread.
+		/**
+		 * MapType::openInArena() and MapType::createInArena() do this for the
+		 * arena they are given.  It only needs to be used directly by code that
+		 * builds item lists outside of those functions.
+		 */
+		class CAMOTO_GAMEMAPS_API Scope
+		{
+			public:
+				Scope(MapArena& arena);
+				~Scope();
+
+				Scope(const Scope&) = delete;
+				Scope& operator=(const Scope&) = delete;
+
+			private:
+				MapArena *previous; ///< Arena to restore once this scope ends
+		};
+
+		/// Create an empty arena.
+		/**
+		 * @param blockSize
+		 *   Size of each block requested from the heap, in bytes.  Requests
+		 *   larger than this get a block of their own.
+		 */
+		explicit MapArena(std::size_t blockSize = 64 * 1024);
+
+		/// Release all the memory in the arena.
+		~MapArena();
+
+		MapArena(const MapArena&) = delete;
+		MapArena& operator=(const MapArena&) = delete;
+
+		/// Get memory from the arena.
+		/**
+		 * @param bytes
+		 *   Number of bytes required.
+		 *
+		 * @param alignment
+		 *   Required alignment of the memory, which must be a power of two no
+		 *   larger than alignof(std::max_align_t).
+		 *
+		 * @return Pointer to the memory, which stays valid until the arena is
+		 *   destroyed.
+		 *
+		 * @throw std::bad_alloc
+		 *   There wasn't enough memory to add another block to the arena.
+		 */
+		void *allocate(std::size_t bytes, std::size_t alignment);
+
+		/// Total size of the blocks obtained from the heap, in bytes.
+		std::size_t size() const;
+
+		/// Get the arena used by maps opened on this thread.
+		/**
+		 * @return The arena, or a null pointer if maps are using the heap.
+		 */
+		static MapArena *current();
+
+	private:
+		mutable std::mutex lock;   ///< Guards everything below
+		std::size_t blockSize;     ///< Size of each new block
+		std::vector<void *> blocks; ///< Every block obtained so far
+		char *next;                ///< Next free byte in the current block
+		std::size_t remaining;     ///< Free bytes left in the current block
+		std::size_t total;         ///< Value for size()
+};
+
+/// Standard allocator that takes its memory from a MapArena.
+/**
+ * With no arena, memory comes from the heap as with std::allocator.  A
+ * default-constructed allocator uses MapArena::current().
+ */
+template <class T>
+class ArenaAllocator
+{
+	public:
+		typedef T value_type;
+
+		ArenaAllocator()
+			:	arena(MapArena::current())
+		{
+		}
+
+		ArenaAllocator(MapArena *arena)
+			:	arena(arena)
+		{
+		}
+
+		template <class U>
+		ArenaAllocator(const ArenaAllocator<U>& other)
+			:	arena(other.arena)
+		{
+		}
+
+		T *allocate(std::size_t n)
+		{
+			if (this->arena) {
+				return static_cast<T *>(this->arena->allocate(n * sizeof(T),
+					alignof(T)));
+			}
+			return static_cast<T *>(::operator new(n * sizeof(T)));
+		}
+
+		void deallocate(T *p, std::size_t n)
+		{
+			// Arena memory is only released with the arena itself
+			if (!this->arena) ::operator delete(p);
+			return;
+		}
+
+		MapArena *arena; ///< Arena to use, or a null pointer for the heap
+};
+
+template <class T, class U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+	return a.arena == b.arena;
+}
+
+template <class T, class U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+	return a.arena != b.arena;
+}
+
+/// std::vector taking its memory from MapArena::current() by default.
+template <class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+} // namespace gamemaps
+} // namespace camoto
+
+#endif // _CAMOTO_GAMEMAPS_ARENA_HPP_
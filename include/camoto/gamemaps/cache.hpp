@@ -0,0 +1,135 @@
+/**
+ * @file  camoto/gamemaps/cache.hpp
+ * @brief On-disk cache of decoded maps.
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _CAMOTO_GAMEMAPS_CACHE_HPP_
+#define _CAMOTO_GAMEMAPS_CACHE_HPP_
+
+#include <memory>
+#include <string>
+#include <camoto/stream.hpp>
+#include <camoto/suppitem.hpp>
+#include <camoto/gamemaps/maptype.hpp>
+#include <camoto/gamemaps/map2d.hpp>
+
+#ifndef CAMOTO_GAMEMAPS_API
+#define CAMOTO_GAMEMAPS_API
+#endif
+
+namespace camoto {
+namespace gamemaps {
+
+/// Keeps decoded copies of maps in a directory, so they open faster next time.
+/**
+ * Each map opened through the cache is saved in the native interchange format
+ * (see saveNative()), under a name made from a hash of the map file, its
+ * supplementary files, the map format and the library version.  Opening the
+ * same files again reads the native copy instead of parsing the original
+ * format.
+ *
+ * New entries are written to a temporary file and renamed into place, so
+ * several processes can share one cache directory without seeing partly
+ * written entries.  Once the directory grows past its size limit, the least
+ * recently used entries are deleted, along with any temporary files left
+ * behind by processes that stopped part way through writing one.
+ *
+ * The maps returned have their grid layers packed (see packLayers()), so a
+ * whole collection can be kept open without using much memory.
+ *
+ * @note The cache is only for reading map content: the size, attributes,
+ *   graphics filenames and the items in each layer.  Every map it returns is
+ *   a native copy, whether or not it was already cached, so it can't draw its
+ *   tiles (imageFromCode() always reports an unknown image), and it doesn't
+ *   know the original format's placement rules, so validate() only checks
+ *   the layer bounds and availableItems() is empty.  Tools that need those,
+ *   such as editors and renderers, must open the map through its MapType.
+ */
+class CAMOTO_GAMEMAPS_API MapCache
+{
+	public:
+		/// Use a cache directory.
+		/**
+		 * @param path
+		 *   Directory to keep the cached maps in.  It is created if it doesn't
+		 *   exist, but its parent must.
+		 *
+		 * @param maxSize
+		 *   Total size, in bytes, the cached maps may take up before the oldest
+		 *   are removed.  Zero means no limit.
+		 */
+		MapCache(const std::string& path, stream::len maxSize);
+
+		/// Open a map, from the cache if possible.
+		/**
+		 * @param type
+		 *   Format of the map.
+		 *
+		 * @param content
+		 *   Map file.  It is only used to open the map on a cache miss, and is
+		 *   never written to.
+		 *
+		 * @param suppData
+		 *   Supplementary files needed by the format, as for MapType::open().
+		 *
+		 * @param hit
+		 *   Optional.  Set to true if the map came from the cache, false if it
+		 *   was parsed from content (and has now been added to the cache.)
+		 *
+		 * @return Read-only native copy of the map, the same whether it came
+		 *   from the cache or not.  See the note on MapCache for what this
+		 *   copy can be used for.
+		 *
+		 * @throw stream::error
+		 *   The map could not be opened, or it can't be stored in the native
+		 *   format.  Problems reading or writing the cache directory itself are
+		 *   not reported; the map is just parsed as normal instead.
+		 */
+		std::shared_ptr<const Map2D> open(const MapType& type,
+			std::unique_ptr<stream::inout> content, SuppData& suppData,
+			bool *hit = nullptr);
+
+		/// Delete every entry in the cache, and any temporary files.
+		void clear();
+
+		/// Get the total size of the files in the cache, in bytes.
+		/**
+		 * This includes any temporary files, whether they are still being
+		 * written or have been abandoned.
+		 */
+		stream::len size() const;
+
+	private:
+		/// Tidy up the cache directory.
+		/**
+		 * Abandoned temporary files are always deleted.  Then the oldest
+		 * entries are deleted until the cache is within maxSize.
+		 *
+		 * @param keep
+		 *   Entry that has just been added, which is never deleted.
+		 */
+		void evict(const std::string& keep);
+
+		std::string path;      ///< Cache directory, ending with a slash
+		stream::len maxSize;   ///< Size limit, 0 for none
+};
+
+} // namespace gamemaps
+} // namespace camoto
+
+#endif // _CAMOTO_GAMEMAPS_CACHE_HPP_
@@ -0,0 +1,120 @@
+/**
+ * @file  camoto/gamemaps/diff.hpp
+ * @brief Compare two versions of a map and apply the differences.
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _CAMOTO_GAMEMAPS_DIFF_HPP_
+#define _CAMOTO_GAMEMAPS_DIFF_HPP_
+
+#include <memory>
+#include <vector>
+#include <camoto/gamemaps/map2d.hpp>
+
+#ifndef CAMOTO_GAMEMAPS_API
+#define CAMOTO_GAMEMAPS_API
+#endif
+
+namespace camoto {
+namespace gamemaps {
+
+/// Differences between two versions of a map, as produced by diff().
+/**
+ * Only cells and attributes that differ are stored, along with both their old
+ * and new content, so a patch can be checked against the map it is applied
+ * to and can be reversed with inverse().  Patches are applied with
+ * EditJournal::applyPatch(), or applyPatch() when no undo is needed.
+ */
+struct CAMOTO_GAMEMAPS_API MapPatch {
+	/// One cell whose items differ.
+	struct Cell {
+		unsigned int layer;  ///< Index into Map2D::layers()
+		Point pos;           ///< Cell position, in the layer's tiles
+		std::vector<Map2D::Layer::Item> before; ///< Items in the old version
+		std::vector<Map2D::Layer::Item> after;  ///< Items in the new version
+	};
+
+	/// One attribute whose value differs.
+	struct AttributeChange {
+		unsigned int index;  ///< Index into Map::attributes()
+		Attribute before;    ///< Attribute in the old version
+		Attribute after;     ///< Attribute in the new version
+	};
+
+	std::vector<Cell> cells;                   ///< Changed cells, by layer then row
+	std::vector<AttributeChange> attributes;   ///< Changed attributes
+
+	/// Are the two versions the same?
+	bool empty() const;
+
+	/// Get a patch that undoes this one.
+	MapPatch inverse() const;
+};
+
+/// Find the differences between two versions of a map.
+/**
+ * Both maps must be in the same format, or at least have the same layers and
+ * attributes.  Layers whose items are in the same order in both maps (the
+ * usual case for grid layers, where every cell has an item) are compared item
+ * by item in a single pass.  Other layers are sorted by position and merged.
+ *
+ * @param from
+ *   Old version of the map.
+ *
+ * @param to
+ *   New version of the map.
+ *
+ * @return A patch that turns from into to.
+ *
+ * @throw camoto::error
+ *   The maps have a different number of layers or attributes.
+ */
+CAMOTO_GAMEMAPS_API MapPatch diff(const Map2D& from, const Map2D& to);
+
+/// Apply a patch directly to a map.
+/**
+ * This is a shortcut for EditJournal::applyPatch() when no undo history is
+ * needed.
+ *
+ * @param map
+ *   Map to change.  It must still match the "before" side of the patch.
+ *
+ * @param patch
+ *   Changes to make, usually from diff().
+ *
+ * @throw camoto::error
+ *   The map no longer matches the version the patch was made from.  The map
+ *   is left unchanged.
+ */
+CAMOTO_GAMEMAPS_API void applyPatch(std::shared_ptr<Map2D> map,
+	const MapPatch& patch);
+
+/// Do two items have the same content, ignoring their position?
+/**
+ * Only the fields selected by each item's type are compared, so leftover
+ * values in unused fields don't count as a difference.
+ */
+CAMOTO_GAMEMAPS_API bool sameContent(const Map2D::Layer::Item& a,
+	const Map2D::Layer::Item& b);
+
+/// Do two attributes hold the same value?
+CAMOTO_GAMEMAPS_API bool sameValue(const Attribute& a, const Attribute& b);
+
+} // namespace gamemaps
+} // namespace camoto
+
+#endif // _CAMOTO_GAMEMAPS_DIFF_HPP_
@@ -0,0 +1,115 @@
+/**
+ * @file  camoto/gamemaps/fingerprint.hpp
+ * @brief Content hashes of layers and maps.
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _CAMOTO_GAMEMAPS_FINGERPRINT_HPP_
+#define _CAMOTO_GAMEMAPS_FINGERPRINT_HPP_
+
+#include <stdint.h>
+#include <vector>
+#include <camoto/gamemaps/map2d.hpp>
+
+#ifndef CAMOTO_GAMEMAPS_API
+#define CAMOTO_GAMEMAPS_API
+#endif
+
+namespace camoto {
+namespace gamemaps {
+
+/// Running hash of the items in one layer.
+/**
+ * Each item is hashed on its own, from its position, code and whichever
+ * extra fields its type selects, and the item hashes are summed.  This makes
+ * the result independent of the order of the items in the layer, and means
+ * an item can be taken out of the hash again without visiting the rest of
+ * the layer.
+ *
+ * The hash only depends on the map content, so it is the same on every
+ * platform and every run and can be stored alongside the map.  It is not
+ * cryptographic, so it shouldn't be trusted with maps from untrusted sources
+ * where a deliberate collision would matter.
+ */
+class CAMOTO_GAMEMAPS_API LayerHash
+{
+	public:
+		/// Start with an empty layer.
+		LayerHash();
+
+		/// Add an item to the hash.
+		void add(const Map2D::Layer::Item& item);
+
+		/// Take an item previously passed to add() back out of the hash.
+		void remove(const Map2D::Layer::Item& item);
+
+		/// Get the final hash value.
+		/**
+		 * @param layerSize
+		 *   Size of the layer, in tiles, as returned by getLayerDims().  Two
+		 *   layers with the same items but a different size get different
+		 *   hashes.
+		 */
+		uint64_t value(const Point& layerSize) const;
+
+	private:
+		uint64_t sum;    ///< Sum of the hashes of every item
+		uint64_t count;  ///< Number of items added
+};
+
+/// Get the fingerprint of a single layer.
+/**
+ * @param map
+ *   Map containing the layer.
+ *
+ * @param layer
+ *   Index into Map2D::layers().
+ *
+ * @return A 64-bit hash of the layer content.  Layers with the same items in
+ *   a different order have the same fingerprint.
+ */
+CAMOTO_GAMEMAPS_API uint64_t fingerprint(const Map2D& map,
+	unsigned int layer);
+
+/// Get the fingerprint of a whole map.
+/**
+ * This covers the content of every layer, in order, plus the values of the
+ * map's attributes.  It doesn't include the map format, so the caller should
+ * keep that alongside the fingerprint if maps in different formats are
+ * stored together.
+ */
+CAMOTO_GAMEMAPS_API uint64_t fingerprint(const Map2D& map);
+
+/// Combine layer fingerprints and attributes into a map fingerprint.
+/**
+ * This is the last step of fingerprint(const Map2D&), for callers such as
+ * EditJournal that already have the layer fingerprints.
+ *
+ * @param layers
+ *   Fingerprint of each layer, in the same order as Map2D::layers().
+ *
+ * @param attributes
+ *   Map attributes, from Map::attributes().
+ */
+CAMOTO_GAMEMAPS_API uint64_t combineFingerprints(
+	const std::vector<uint64_t>& layers,
+	const std::vector<Attribute>& attributes);
+
+} // namespace gamemaps
+} // namespace camoto
+
+#endif // _CAMOTO_GAMEMAPS_FINGERPRINT_HPP_
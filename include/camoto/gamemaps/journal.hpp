@@ -0,0 +1,403 @@
+/**
+ * @file  camoto/gamemaps/journal.hpp
+ * @brief Undo/redo journal for edits made to a Map2D.
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _CAMOTO_GAMEMAPS_JOURNAL_HPP_
+#define _CAMOTO_GAMEMAPS_JOURNAL_HPP_
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <camoto/gamemaps/diff.hpp>
+#include <camoto/gamemaps/fingerprint.hpp>
+#include <camoto/gamemaps/map2d.hpp>
+
+#ifndef CAMOTO_GAMEMAPS_API
+#define CAMOTO_GAMEMAPS_API
+#endif
+
+namespace camoto {
+namespace gamemaps {
+
+/// Make changes to a map, keeping enough information to undo and redo them.
+/**
+ * Each edit stores only what is needed to reverse it (e.g. the old and new
+ * tile code), so undoing or redoing an edit takes time proportional to the
+ * size of the edit rather than the size of the map.
+ *
+ * Edits made between beginGroup() and endGroup() are undone and redone as a
+ * single step, e.g. for a brush stroke covering many cells.  Making a new
+ * edit discards anything that could have been redone.
+ *
+ * Every edit, undo and redo is reported to the map's observers (see
+ * Map2D::addObserver()), with each group sent as a single batch.
+ *
+ * While a journal is in use, all changes to the map should be made through
+ * it.  If the map's items are changed some other way, call clear() before
+ * using the journal again, otherwise undo will put the wrong items back.
+ * The journal's own lookup indices are rebuilt automatically when a layer's
+ * items have been replaced or fetched with Layer::items() since the journal
+ * last used them, such as by restoreSnapshot(), packLayers() or remapCodes(),
+ * but edits made through a reference to the items kept from before the
+ * journal's last edit can't be detected.
+ *
+ * @note Removing an item moves the last item in the layer into its place, so
+ *   item indices other than the one removed can change.  The order of items
+ *   in a layer has no meaning, so this doesn't affect the map itself.
+ */
+class CAMOTO_GAMEMAPS_API EditJournal
+{
+	public:
+		typedef Map2D::Layer::Item Item;
+
+		/// A rectangular block of items copied out of a layer.
+		struct Region {
+			/// Width and height of the block, in tiles.
+			Point size;
+
+			/// Items in the block, positioned relative to its top-left corner.
+			std::vector<Item> items;
+		};
+
+		/// Start a journal for the given map.
+		/**
+		 * @param map
+		 *   Map to edit.
+		 */
+		EditJournal(std::shared_ptr<Map2D> map);
+
+		/// Start a group of edits that will be undone as one.
+		/**
+		 * Groups can be nested, in which case the outermost group is the one
+		 * that counts.
+		 */
+		void beginGroup();
+
+		/// Finish the group started by beginGroup().
+		void endGroup();
+
+		/// Set the tile code at a given location.
+		/**
+		 * If there is already an item at pos, its code is changed.  Otherwise a
+		 * new item is added.
+		 *
+		 * @param layer
+		 *   Index of the layer to change.
+		 *
+		 * @param pos
+		 *   Location of the cell, in the layer's tile units.
+		 *
+		 * @param code
+		 *   New tile code.  INVALID_TILECODE removes the item at pos instead.
+		 */
+		void setCell(unsigned int layer, const Point& pos, unsigned int code);
+
+		/// Add an item to a layer.
+		/**
+		 * @return Index of the new item in Map2D::Layer::items().
+		 */
+		std::size_t insertItem(unsigned int layer, const Item& item);
+
+		/// Remove an item from a layer.
+		/**
+		 * @param layer
+		 *   Index of the layer to change.
+		 *
+		 * @param index
+		 *   Index of the item in Map2D::Layer::items().  The last item in the
+		 *   layer takes over this index.
+		 */
+		void removeItem(unsigned int layer, std::size_t index);
+
+		/// Move an item to a new location.
+		void moveItem(unsigned int layer, std::size_t index, const Point& pos);
+
+		/// List every cell containing an item with the given code.
+		/**
+		 * The first call for a layer builds an index of every code in it, which
+		 * is then kept up to date as edits are made through the journal, so
+		 * later queries take time proportional to the number of matches.
+		 *
+		 * Every query first checks whether the layer's items have been replaced
+		 * or fetched with Layer::items() since the index was built, and if so
+		 * builds it again.  This covers restoreSnapshot(), packLayers(),
+		 * remapCodes() and edits made through a reference from items() fetched
+		 * since the journal's last query.  It doesn't cover edits made through
+		 * a reference kept from before that query, or layers not created by
+		 * this library, so these must be followed by clear().  The same applies to
+		 * countCode(), codeUsage(), replaceCode(), fingerprint() and
+		 * applyPatch().
+		 *
+		 * @param layer
+		 *   Index of the layer to search.
+		 *
+		 * @param code
+		 *   Tile code to look for.
+		 *
+		 * @return Positions of matching cells, sorted by row then column.  A cell
+		 *   is only listed once, even if it has several matching items.
+		 */
+		std::vector<Point> findCode(unsigned int layer, unsigned int code);
+
+		/// Count the items in a layer with the given code.
+		std::size_t countCode(unsigned int layer, unsigned int code);
+
+		/// Count the items in a layer using each code.
+		/**
+		 * @return A map from each code in use to the number of items using it.
+		 */
+		std::map<unsigned int, std::size_t> codeUsage(unsigned int layer);
+
+		/// Change every item with one code to another code, as one undo step.
+		/**
+		 * Items where tilePermittedAt() rejects the new code are left alone.
+		 *
+		 * @param layer
+		 *   Index of the layer to change.
+		 *
+		 * @param from
+		 *   Code to replace.
+		 *
+		 * @param to
+		 *   New code.
+		 *
+		 * @return The number of items changed.
+		 */
+		std::size_t replaceCode(unsigned int layer, unsigned int from,
+			unsigned int to);
+
+		/// Get the fingerprint of one layer.
+		/**
+		 * This gives the same value as camoto::gamemaps::fingerprint(), but
+		 * after the first call for a layer the hash is updated as each edit is
+		 * made, instead of being recalculated from every item.  Changes made
+		 * outside the journal are picked up as described for findCode().
+		 *
+		 * @param layer
+		 *   Index of the layer.
+		 */
+		uint64_t fingerprint(unsigned int layer);
+
+		/// Get the fingerprint of the whole map, including its attributes.
+		uint64_t fingerprint();
+
+		/// Copy the items in a rectangle.
+		/**
+		 * This does not change the map.  Like the other region functions it
+		 * takes time proportional to the area of the rectangle, not the number
+		 * of items in the layer.
+		 *
+		 * @param layer
+		 *   Index of the layer to copy from.
+		 *
+		 * @param pos
+		 *   Top-left cell of the rectangle.
+		 *
+		 * @param size
+		 *   Width and height of the rectangle, in tiles.  Any part of the
+		 *   rectangle outside the layer is left out of the copy.
+		 *
+		 * @return The items, with pos relative to the top-left of the rectangle.
+		 */
+		Region copyRegion(unsigned int layer, const Point& pos, const Point& size);
+
+		/// Place a copied block into a layer, as a single undo step.
+		/**
+		 * Items that tilePermittedAt() rejects at their new location are
+		 * skipped, as is anything that would fall outside the layer.
+		 *
+		 * @param layer
+		 *   Index of the layer to change.
+		 *
+		 * @param pos
+		 *   Cell where the top-left corner of the block will go.
+		 *
+		 * @param region
+		 *   Block to paste, usually from copyRegion().
+		 *
+		 * @param transparent
+		 *   true to leave cells alone where the block has no items, false to
+		 *   empty them so the result matches the block exactly.
+		 *
+		 * @throw stream::error
+		 *   The block's width or height is zero or negative.
+		 */
+		void pasteRegion(unsigned int layer, const Point& pos,
+			const Region& region, bool transparent);
+
+		/// Set every permitted cell in a rectangle to the same code.
+		/**
+		 * @param code
+		 *   Tile code to use.  INVALID_TILECODE clears the area instead.
+		 *
+		 * @throw camoto::error
+		 *   The tile has an instance limit (see tilePermittedAt()), and the
+		 *   ones already in the layer plus those the fill would add come to more
+		 *   than the limit.  Nothing is changed.
+		 */
+		void fillRegion(unsigned int layer, const Point& pos, const Point& size,
+			unsigned int code);
+
+		/// Remove every item in a rectangle.
+		void clearRegion(unsigned int layer, const Point& pos, const Point& size);
+
+		/// Move a block of items, replacing whatever was at the destination.
+		/**
+		 * This is the same as copying the block, clearing it, and pasting it
+		 * (without transparency) at pos + offset, as one undo step.
+		 */
+		void shiftRegion(unsigned int layer, const Point& pos, const Point& size,
+			const Point& offset);
+
+		/// Change a numeric or enum attribute.
+		void setAttribute(unsigned int index, int value);
+
+		/// Change a text or filename attribute.
+		void setAttribute(unsigned int index, const std::string& value);
+
+		/// Apply a patch from diff() as one undo step.
+		/**
+		 * Every cell and attribute in the patch is checked against its
+		 * "before" content first, so a patch that no longer fits is rejected
+		 * without changing anything.  Items are written as they appear in the
+		 * patch, without checking Map2D::Layer::tilePermittedAt().
+		 *
+		 * @throw camoto::error
+		 *   The map doesn't match the version the patch was made from.
+		 */
+		void applyPatch(const MapPatch& patch);
+
+		/// Is there anything to undo?
+		bool canUndo() const;
+
+		/// Is there anything to redo?
+		bool canRedo() const;
+
+		/// Reverse the most recent edit or group of edits.
+		void undo();
+
+		/// Repeat the most recently undone edit or group of edits.
+		void redo();
+
+		/// Forget all undo and redo history.
+		void clear();
+
+	private:
+		/// One reversible change.
+		struct Op {
+			enum class Kind {
+				Code,      ///< Item code changed from codeOld to codeNew
+				Insert,    ///< item was appended to the layer
+				Remove,    ///< item was removed from index
+				Move,      ///< Item moved from posOld to posNew
+				Attribute, ///< Attribute index changed (values in attr*)
+			};
+			Kind kind;
+			unsigned int layer;
+			std::size_t index;
+			unsigned int codeOld, codeNew;
+			Point posOld, posNew;
+			std::shared_ptr<const Item> item;
+			int attrIntOld, attrIntNew;
+			std::shared_ptr<const std::pair<std::string, std::string>> attrText;
+		};
+
+		/// Item indices at each location, per layer.
+		typedef std::unordered_map<unsigned long long, std::vector<std::size_t>>
+			CellIndex;
+
+		/// Positions (see rowKey() in journal.cpp) of each code, per layer.
+		typedef std::unordered_map<unsigned int, std::multiset<unsigned long long>>
+			CodeIndex;
+
+		/// Record an edit that has already been applied.
+		void record(Op op);
+
+		/// Apply an op forwards (redo == true) or in reverse.
+		void apply(const Op& op, bool redo);
+
+		/// Low-level item changes that keep the cell index up to date.
+		std::size_t doInsert(unsigned int layer, const Item& item);
+		Item doRemove(unsigned int layer, std::size_t index);
+		void doMove(unsigned int layer, std::size_t index, const Point& pos);
+		void doInsertAt(unsigned int layer, std::size_t index, const Item& item);
+
+		/// A layer's items, read and changed without lending them out.
+		class Items;
+
+		/// Get a layer's items, resetting the indices if they are out of date.
+		Items items(unsigned int layer);
+		CellIndex *cellIndex(unsigned int layer);
+		CodeIndex *codeIndex(unsigned int layer);
+		LayerHash *layerHash(unsigned int layer);
+
+		/// Keep the code index and layer hash up to date, if they exist.
+		void itemAdded(unsigned int layer, const Item& item);
+		void itemRemoved(unsigned int layer, const Item& item);
+
+		/// Change an item's code and record it so it can be undone.
+		void changeCode(unsigned int layer, std::size_t index, unsigned int code);
+
+		/// Change an item's code without recording it.
+		void doSetCode(unsigned int layer, std::size_t index, unsigned int code);
+
+		/// Trim a rectangle to the bounds of a layer.
+		/**
+		 * @return false if nothing is left.
+		 */
+		bool clip(unsigned int layer, Point *pos, Point *size);
+
+		/// Remove every item at one cell.
+		void clearCell(unsigned int layer, const Point& pos);
+
+		/// Tell the map's observers that one cell has changed.
+		void cellChanged(unsigned int layer, const Point& pos);
+
+		void setAttributeValue(unsigned int index, const Op& op, bool useNew);
+
+		std::shared_ptr<Map2D> map;
+		std::vector<std::shared_ptr<Map2D::Layer>> layers;
+
+		/// Cell indices for layers used with setCell(), built on first use.
+		std::vector<std::unique_ptr<CellIndex>> cells;
+
+		/// Code indices for layers used with findCode() etc., built on first use.
+		std::vector<std::unique_ptr<CodeIndex>> codes;
+
+		/// Running hashes for layers used with fingerprint(), built on first use.
+		std::vector<std::unique_ptr<LayerHash>> hashes;
+
+		/// Item list generation (see SharedItems) each layer's indices match.
+		std::vector<unsigned long> generations;
+
+		std::vector<Op> undoOps;           ///< Edits that can be undone
+		std::vector<std::size_t> undoGroups; ///< Start of each group in undoOps
+		std::vector<Op> redoOps;           ///< Edits that can be redone
+		std::vector<std::size_t> redoGroups; ///< Start of each group in redoOps
+		unsigned int groupDepth;           ///< Nesting level of beginGroup()
+		bool groupStarted;                 ///< Current group has an entry in undoGroups
+};
+
+} // namespace gamemaps
+} // namespace camoto
+
+#endif // _CAMOTO_GAMEMAPS_JOURNAL_HPP_
@@ -0,0 +1,123 @@
+/**
+ * @file  camoto/gamemaps/lint.hpp
+ * @brief Check collections of map files for problems.
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _CAMOTO_GAMEMAPS_LINT_HPP_
+#define _CAMOTO_GAMEMAPS_LINT_HPP_
+
+#include <string>
+#include <vector>
+#include <camoto/gamemaps/map2d.hpp>
+
+#ifndef CAMOTO_GAMEMAPS_API
+#define CAMOTO_GAMEMAPS_API
+#endif
+
+namespace camoto {
+namespace gamemaps {
+
+/// One problem found in a map file by lint().
+struct LintIssue {
+	enum class Type {
+		Unreadable,    ///< The file could not be opened or read
+		UnknownFormat, ///< No map handler recognised the file
+		NotInstance,   ///< The handler's isInstance() rejected the file
+		MissingSupp,   ///< A supplemental file could not be opened
+		Truncated,     ///< The file ended before all the map data was read
+		OpenFailed,    ///< The handler threw an error opening the file
+		OutOfBounds,   ///< An item is positioned outside its layer
+		NotPermitted,  ///< tilePermittedAt() rejects an item at its position
+		TooMany,       ///< More items with this code than the game allows
+		TooManyCodes,  ///< A layer uses more different codes than it can store
+	};
+	Type type;
+
+	/// Map file the problem was found in.
+	std::string filename;
+
+	/// Code of the map handler used, or empty if none could be chosen.
+	std::string mapType;
+
+	/// Human-readable description of the problem.
+	std::string message;
+
+	/// For item problems, index into Map2D::layers().
+	unsigned int layer;
+
+	/// For item problems, index into Map2D::Layer::itemView().
+	std::size_t index;
+
+	/// For item problems, the item's position in tiles.
+	Point pos;
+
+	/// For item problems, the item's tile code.
+	unsigned int code;
+
+	/// For TooMany and TooManyCodes, the limit that was exceeded.
+	unsigned int maxCount;
+};
+
+/// Check one map file for problems.
+/**
+ * The file and any supplemental files are read into memory and the map is
+ * opened from there, so the files on disk are never modified.
+ *
+ * Files that don't look like maps are reported at the isInstance() stage,
+ * which is where format handlers reject out-of-range tile codes and most
+ * truncated files.  Maps that open are then checked with validate() and
+ * Map2D::Layer::uniqueCodes().
+ *
+ * @param filename
+ *   Map file to check.
+ *
+ * @param type
+ *   Code of the map handler to use (see MapType::code()), or an empty string
+ *   to pick one automatically.
+ *
+ * @return All the problems found, or an empty list if the map is fine.
+ */
+CAMOTO_GAMEMAPS_API std::vector<LintIssue> lint(const std::string& filename,
+	const std::string& type);
+
+/// Check many map files for problems at the same time.
+/**
+ * Each file is checked by lint(const std::string&, const std::string&) on a pool of worker threads.  Results are
+ * returned in the same order as the filenames, no matter which thread
+ * finished first.
+ *
+ * @param filenames
+ *   Map files to check.
+ *
+ * @param type
+ *   Same as for lint(const std::string&, const std::string&), applied to
+ *   every file.
+ *
+ * @param threads
+ *   Number of worker threads to use, or zero to use one per CPU.
+ *
+ * @return The problems found in every file.
+ */
+CAMOTO_GAMEMAPS_API std::vector<LintIssue> lint(
+	const std::vector<std::string>& filenames, const std::string& type,
+	unsigned int threads);
+
+} // namespace gamemaps
+} // namespace camoto
+
+#endif // _CAMOTO_GAMEMAPS_LINT_HPP_
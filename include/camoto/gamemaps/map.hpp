@@ -108,7 +108,11 @@ typedef std::map<ImagePurpose, std::shared_ptr<gamegraphics::Tileset>> TilesetCo
 /**
  * This class represents a map file.  Its functions are used to edit the map.
  *
- * @note Multithreading: Only call one function in this class at a time.
+ * @note Multithreading: Any number of threads may call const functions on
+ *   the same map at once, provided no thread is calling a non-const function
+ *   (such as flush(), or editing via a non-const layer) at the same time.
+ *   Non-const functions must only be called while no other thread is using
+ *   the map.  This also applies to Map2D and its layers.
  */
 class Map: public HasAttributes
 {
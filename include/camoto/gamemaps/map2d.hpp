@@ -21,6 +21,7 @@
 #ifndef _CAMOTO_GAMEMAPS_MAP2D_HPP_
 #define _CAMOTO_GAMEMAPS_MAP2D_HPP_
 
+#include <memory>
 #include <vector>
 #include <map>
 #include <camoto/enum-ops.hpp>
@@ -33,12 +34,95 @@ namespace gamemaps {
 
 using gamegraphics::Point;
 
+/// Read-only, non-owning view over a contiguous list of elements.
+/**
+ * This allows a caller to walk through a list stored inside a map or layer
+ * without the list having to be copied first.  The view is only valid while
+ * the underlying list is not modified, so it should not be kept around.
+ */
+template <class T>
+class ConstView
+{
+	public:
+		typedef T value_type;
+		typedef const T* const_iterator;
+
+		ConstView()
+			:	first(nullptr),
+				last(nullptr)
+		{
+		}
+
+		template <class Alloc>
+		ConstView(const std::vector<T, Alloc>& v)
+			:	first(v.data()),
+				last(v.data() + v.size())
+		{
+		}
+
+		const_iterator begin() const { return this->first; }
+		const_iterator end() const { return this->last; }
+		std::size_t size() const { return this->last - this->first; }
+		bool empty() const { return this->first == this->last; }
+		const T& operator[](std::size_t i) const { return this->first[i]; }
+
+	private:
+		const T *first;
+		const T *last;
+};
+
+/// Read-only, non-owning view over a list of shared pointers.
+/**
+ * Same as ConstView, but each element is dereferenced on access, so the caller
+ * gets a const reference to the object itself.  This avoids touching the
+ * shared_ptr reference counts when iterating.
+ */
+template <class T>
+class ConstPtrView
+{
+	public:
+		class const_iterator
+		{
+			public:
+				const_iterator(const std::shared_ptr<T> *p)
+					:	p(p)
+				{
+				}
+
+				const T& operator*() const { return **this->p; }
+				const T* operator->() const { return this->p->get(); }
+				const_iterator& operator++() { this->p++; return *this; }
+				bool operator==(const const_iterator& b) const { return this->p == b.p; }
+				bool operator!=(const const_iterator& b) const { return this->p != b.p; }
+
+			private:
+				const std::shared_ptr<T> *p;
+		};
+
+		ConstPtrView(const std::vector<std::shared_ptr<T>>& v)
+			:	first(v.data()),
+				last(v.data() + v.size())
+		{
+		}
+
+		const_iterator begin() const { return this->first; }
+		const_iterator end() const { return this->last; }
+		std::size_t size() const { return this->last - this->first; }
+		bool empty() const { return this->first == this->last; }
+		const T& operator[](std::size_t i) const { return *this->first[i]; }
+
+	private:
+		const std::shared_ptr<T> *first;
+		const std::shared_ptr<T> *last;
+};
+
 /// 2D grid-based Map.
 class Map2D: virtual public Map
 {
 	public:
 		class Layer;
 		class Path;
+		class Observer;
 
 		/// Capabilities this map supports.
 		enum class Caps {
@@ -118,6 +202,16 @@ class Map2D: virtual public Map
 		virtual std::vector<std::shared_ptr<Map2D::Layer>> layers() = 0;
 		virtual std::vector<std::shared_ptr<const Map2D::Layer>> layers() const = 0;
 
+		/// Get read-only access to the map's layers without copying the list.
+		/**
+		 * Unlike layers(), no vector is constructed and no shared pointers are
+		 * copied, so this is the preferred way for renderers and other read-only
+		 * code to walk through the layers.
+		 *
+		 * @return A view of each layer, in the same order as layers().
+		 */
+		virtual ConstPtrView<Map2D::Layer> layerView() const = 0;
+
 		/// Get a list of paths in the level.
 		/**
 		 * A path is a series of points/vectors defining a travel route.  Unlike
@@ -157,7 +251,8 @@ class Map2D: virtual public Map
 		 * show through to this background image.
 		 *
 		 * @param tileset
-		 *   List of tilesets, same as passed to Map2DLayer::imageFromCode().
+		 *   List of tilesets, same as passed to Map2DLayer::imageFromCode().  The
+		 *   same threading rules apply.
 		 *
 		 * @param outImage
 		 *   On return, contains the image to draw.  An empty pointer is returned
@@ -173,10 +268,90 @@ class Map2D: virtual public Map
 		 */
 		virtual Background background(const TilesetCollection& tileset)
 			const = 0;
+
+		/// Part of the map that has been changed.
+		struct Change {
+			enum class Type {
+				Items,     ///< Items in the area have been added, removed or changed
+				Attribute, ///< A map attribute has been given a new value
+			};
+			Type type;
+
+			/// Index into layers() of the layer that changed, for Type::Items.
+			unsigned int layer;
+
+			/// Top-left corner of the changed area, in the layer's tile units.
+			Point pos;
+
+			/// Width and height of the changed area, in the layer's tile units.
+			Point size;
+
+			/// Index into attributes(), for Type::Attribute.
+			unsigned int attribute;
+		};
+
+		/// Ask to be told about changes made to the map.
+		/**
+		 * Only a weak reference is kept, so the observer is dropped automatically
+		 * once the caller releases it.  Observers are called on whichever thread
+		 * made the change, as part of the function that made it.
+		 *
+		 * @param observer
+		 *   Instance whose Observer::mapChanged() will be called after each
+		 *   change or group of changes.
+		 */
+		virtual void addObserver(std::shared_ptr<Observer> observer) = 0;
+
+		/// Stop notifying an observer previously passed to addObserver().
+		virtual void removeObserver(const Observer *observer) = 0;
+
+		/// Hold change notifications until endUpdate() is called.
+		/**
+		 * Calls can be nested.  Once the outermost endUpdate() is reached, all
+		 * the changes made in between are sent to observers in one call, with
+		 * neighbouring areas on the same layer merged together.
+		 */
+		virtual void beginUpdate() = 0;
+
+		/// Send any changes held since beginUpdate().
+		virtual void endUpdate() = 0;
+
+		/// Report a change to the observers.
+		/**
+		 * Changes to attributes are reported by the map itself, but the map is
+		 * unaware of edits made directly to Layer::items(), so the code making
+		 * those edits must call this function.  EditJournal does this for you.
+		 *
+		 * @param change
+		 *   Details of the area that has changed.
+		 */
+		virtual void changed(const Change& change) = 0;
 };
 
 IMPLEMENT_ENUM_OPERATORS(Map2D::Caps);
 
+/// Interface for code that needs to know when a map has changed.
+/**
+ * A renderer can use this to redraw only the affected part of the screen,
+ * and a cache or spatial index can update just the cells that changed.
+ */
+class Map2D::Observer
+{
+	public:
+		inline virtual ~Observer() {};
+
+		/// One or more parts of the map have changed.
+		/**
+		 * @param map
+		 *   The map that has changed.
+		 *
+		 * @param changes
+		 *   List of changed areas.  Areas may overlap.
+		 */
+		virtual void mapChanged(const Map2D& map,
+			const std::vector<Change>& changes) = 0;
+};
+
 /// A map is made up of multiple layers.
 class Map2D::Layer
 {
@@ -250,11 +425,22 @@ class Map2D::Layer
 		 * @return Vector of all tiles.  The tiles are in any order.  The vector is
 		 *   returned by reference, so elements can be added and removed to add or
 		 *   remove tiles from the layer.  Make sure any potential additions are
-		 *   allowed by tilePermittedAt() first.
+		 *   allowed by tilePermittedAt() first.  The reference must not be kept
+		 *   across a call to snapshot(), as it may still point at the list the
+		 *   snapshot is now using.
 		 */
 		virtual std::vector<Item>& items() = 0;
 		virtual std::vector<Item> items() const = 0;
 
+		/// Get read-only access to all tiles in the layer without copying them.
+		/**
+		 * This is the same list as items(), however the const items() has to
+		 * return a copy of every item, while this function does not.
+		 *
+		 * @return A view of all tiles, valid until the layer is next modified.
+		 */
+		virtual ConstView<Item> itemView() const = 0;
+
 		/// Return value from imageFromCode()
 		struct ImageFromCodeInfo {
 			/// Image types
@@ -287,6 +473,12 @@ class Map2D::Layer
 		 *   Camoto Studio reads this information from XML files distributed
 		 *   with the application, for example.
 		 *
+		 *   Tilesets read their underlying files on demand, both here and when
+		 *   the returned image is converted, so they are not safe to share
+		 *   between threads.  When calling this function from multiple threads,
+		 *   give each thread its own TilesetCollection, or serialise access to
+		 *   a shared one.  The layer itself may be shared.
+		 *
 		 * @param outImgType
 		 *   On return, an ImageType code indicating what image to display.
 		 *
@@ -321,6 +513,66 @@ class Map2D::Layer
 		virtual bool tilePermittedAt(const Item& item, const Point& pos,
 			unsigned int *maxCount) const = 0;
 
+		/// Check every cell in a rectangle with tilePermittedAt().
+		/**
+		 * Region operations use this to check a whole block at once, which some
+		 * layers can do much faster than one cell at a time.
+		 *
+		 * @param item
+		 *   Item to check, as for tilePermittedAt().  Its pos is ignored.
+		 *
+		 * @param pos
+		 *   Top-left cell of the rectangle, in tiles.
+		 *
+		 * @param size
+		 *   Width and height of the rectangle, in tiles.
+		 *
+		 * @param permitted
+		 *   On return, one entry per cell in row-major order (size.x * size.y
+		 *   entries), true where tilePermittedAt() would return true.
+		 *
+		 * @param maxCount
+		 *   On return, same as for tilePermittedAt().
+		 */
+		virtual void tilePermittedIn(const Item& item, const Point& pos,
+			const Point& size, std::vector<bool> *permitted,
+			unsigned int *maxCount) const = 0;
+
+		/// Check a list of items with tilePermittedAt(), each at its own pos.
+		/**
+		 * This is used by validate() to check a whole layer with a single call.
+		 * Formats whose rules can be applied to many items at once may override
+		 * it.
+		 *
+		 * @param items
+		 *   Items to check, usually from itemView().
+		 *
+		 * @param permitted
+		 *   On return, one entry per item, true if the item is permitted at its
+		 *   current position.
+		 *
+		 * @param maxCount
+		 *   On return, one entry per item, set to the instance limit for that
+		 *   item as returned by tilePermittedAt().
+		 */
+		virtual void itemsPermitted(ConstView<Item> items,
+			std::vector<bool> *permitted, std::vector<unsigned int> *maxCount)
+			const = 0;
+
+		/// Count how many different tile codes are used in the layer.
+		/**
+		 * Some formats store a per-level table of the tiles in use, which limits
+		 * how many different tiles can appear in a single level.  This allows an
+		 * editor to warn the user before a flush() fails because of this.
+		 *
+		 * @param maxCount
+		 *   On return, set to the maximum number of different tile codes this
+		 *   layer can store.  A value of zero means unlimited.
+		 *
+		 * @return The number of different tile codes currently in the layer.
+		 */
+		virtual unsigned int uniqueCodes(unsigned int *maxCount) const = 0;
+
 		/// Get the palette to use with this layer.
 		/**
 		 * Some tilesets don't have a palette, so in this case the palette to use
@@ -342,9 +594,13 @@ class Map2D::Layer
 		 * Items are copied (i.e. with the copy constructor) if they are to be
 		 * inserted into a layer.
 		 *
-		 * @return Vector of all items.
+		 * The list is built once and does not change, so this is cheap enough to
+		 * call every time the list is displayed.
+		 *
+		 * @return Reference to a vector of all items.  The reference remains
+		 *   valid for as long as the layer exists.
 		 */
-		virtual std::vector<Item> availableItems() const = 0;
+		virtual const std::vector<Item>& availableItems() const = 0;
 };
 
 IMPLEMENT_ENUM_OPERATORS(Map2D::Layer::Caps);
@@ -27,6 +27,7 @@
 #include <vector>
 #include <camoto/stream.hpp>
 #include <camoto/suppitem.hpp>
+#include <camoto/gamemaps/arena.hpp>
 #include <camoto/gamemaps/map.hpp>
 
 /// Main namespace
@@ -102,6 +103,25 @@ class MapType
 		virtual std::unique_ptr<Map> create(std::unique_ptr<stream::inout> content,
 			SuppData& suppData) const = 0;
 
+		/// Create a blank map in this format, in a memory arena.
+		/**
+		 * Same as create(), but the map's item lists come from the given arena.
+		 * The Map and Layer objects, attributes and any list lent out by
+		 * Layer::items() still come from the heap (see MapArena).
+		 *
+		 * This has its own name rather than overloading create(), as format
+		 * handlers override create() and would hide an overload.
+		 *
+		 * @param arena
+		 *   Arena to use, which must outlive the map.
+		 */
+		std::unique_ptr<Map> createInArena(std::unique_ptr<stream::inout> content,
+			SuppData& suppData, MapArena& arena) const
+		{
+			MapArena::Scope scope(arena);
+			return this->create(std::move(content), suppData);
+		}
+
 		/// Open a map file.
 		/**
 		 * @pre Recommended that isInstance() has returned > #DefinitelyNo.
@@ -122,6 +142,25 @@ class MapType
 		virtual std::unique_ptr<Map> open(std::unique_ptr<stream::inout> content,
 			SuppData& suppData) const = 0;
 
+		/// Open a map file in a memory arena.
+		/**
+		 * Same as open(), but the map's item lists come from the given arena.
+		 * The Map and Layer objects, attributes and any list lent out by
+		 * Layer::items() still come from the heap (see MapArena).
+		 *
+		 * This has its own name rather than overloading open(), as format
+		 * handlers override open() and would hide an overload.
+		 *
+		 * @param arena
+		 *   Arena to use, which must outlive the map.
+		 */
+		std::unique_ptr<Map> openInArena(std::unique_ptr<stream::inout> content,
+			SuppData& suppData, MapArena& arena) const
+		{
+			MapArena::Scope scope(arena);
+			return this->open(std::move(content), suppData);
+		}
+
 		/// Write a map out to a file in this format.
 		/**
 		 * @param map
@@ -0,0 +1,65 @@
+/**
+ * @file  camoto/gamemaps/native.hpp
+ * @brief Save any map in the library's own interchange format.
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _CAMOTO_GAMEMAPS_NATIVE_HPP_
+#define _CAMOTO_GAMEMAPS_NATIVE_HPP_
+
+#include <camoto/stream.hpp>
+#include <camoto/gamemaps/map2d.hpp>
+
+#ifndef CAMOTO_GAMEMAPS_API
+#define CAMOTO_GAMEMAPS_API
+#endif
+
+namespace camoto {
+namespace gamemaps {
+
+/// Code of the native interchange format, for MapManager::getMapTypeByCode().
+#define CAMOTO_NATIVE_MAPTYPE "map2d-native"
+
+/// Write a map out in the native interchange format.
+/**
+ * The native format is a versioned, little-endian container with a table of
+ * section offsets at the start of the file, so it can be read without any of
+ * the quirks of the original game formats.  It holds the map's size and caps,
+ * graphics filenames, attributes, paths and every layer along with its list
+ * of available items.  Layers that are mostly full of plain tiles are stored
+ * as a dense grid of 32-bit codes, others as a table of items.
+ *
+ * The file only holds the map content.  Game-specific rules such as which
+ * image to draw for each code, or where a tile may be placed, stay with the
+ * original format, so a map opened from a native file draws every tile as
+ * "unknown" and allows any item anywhere.
+ *
+ * @param map
+ *   Map to save.  It can be in any format.
+ *
+ * @param output
+ *   Stream to write to.  It is truncated to the length of the new data.
+ *
+ * @throw stream::error
+ *   The map is too large to store, or there was an I/O error.
+ */
+CAMOTO_GAMEMAPS_API void saveNative(const Map2D& map, stream::output& output);
+
+} // namespace gamemaps
+} // namespace camoto
+
+#endif // _CAMOTO_GAMEMAPS_NATIVE_HPP_
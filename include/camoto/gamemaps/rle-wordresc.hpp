@@ -0,0 +1,115 @@
+/**
+ * @file  camoto/gamemaps/rle-wordresc.hpp
+ * @brief RLE codec used by Word Rescue levels.
+ *
+ * This file format is fully documented on the ModdingWiki:
+ *   http://www.shikadi.net/moddingwiki/Word_Rescue
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _CAMOTO_GAMEMAPS_RLE_WORDRESC_HPP_
+#define _CAMOTO_GAMEMAPS_RLE_WORDRESC_HPP_
+
+#include <vector>
+#include <camoto/stream.hpp>
+
+#ifndef CAMOTO_GAMEMAPS_API
+#define CAMOTO_GAMEMAPS_API
+#endif
+
+namespace camoto {
+namespace gamemaps {
+
+/// Decode a block of Word Rescue RLE data.
+/**
+ * This and the other functions here only need the raw data, so they can be
+ * used to convert levels in bulk without opening them as maps.
+ *
+ * The data is a list of (count, code) byte pairs.  Each pair fills the next
+ * count cells with code.
+ *
+ * Decoding stops when either the output is full or the input runs out.  If
+ * the last run is longer than the space left in the output, it is cut short.
+ *
+ * @param in
+ *   RLE data to decode.
+ *
+ * @param lenIn
+ *   Number of bytes available at in.
+ *
+ * @param out
+ *   Buffer to write the decoded cells to.
+ *
+ * @param lenOut
+ *   Number of cells in out.  Nothing is written past this point.
+ *
+ * @param lenConsumed
+ *   On return, set to the number of bytes at in that were used.
+ *
+ * @return Number of cells written to out.  This is less than lenOut if the
+ *   input ran out first.
+ */
+unsigned long CAMOTO_GAMEMAPS_API rleDecodeWR(const uint8_t *in, unsigned long lenIn,
+	uint8_t *out, unsigned long lenOut, unsigned long *lenConsumed);
+
+/// Read and decode Word Rescue RLE data from a stream.
+/**
+ * The rest of the stream is read in a single operation, then the stream
+ * pointer is moved back to just after the last byte used.
+ *
+ * @param content
+ *   Stream to read from, at the start of the RLE data.
+ *
+ * @param out
+ *   Buffer to write the decoded cells to.  Its size sets how many cells are
+ *   decoded.
+ *
+ * @return Number of cells written to out.  This is less than out.size() if
+ *   the stream ran out first.
+ */
+unsigned long CAMOTO_GAMEMAPS_API rleReadWR(stream::input& content, std::vector<uint8_t>& out);
+
+/// RLE-encode a block of data in Word Rescue format.
+/**
+ * @param in
+ *   Data to encode.  Can be empty, in which case nothing is written.
+ *
+ * @param out
+ *   The encoded data is appended here.
+ *
+ * @return Number of bytes appended to out.
+ */
+unsigned long CAMOTO_GAMEMAPS_API rleEncodeWR(const std::vector<uint8_t>& in,
+	std::vector<uint8_t>& out);
+
+/// RLE-encode data in Word Rescue format and write it to a stream.
+/**
+ * @param output
+ *   Stream to write to.
+ *
+ * @param data
+ *   Data to encode.  Can be empty, in which case nothing is written.
+ *
+ * @return Number of bytes written.
+ */
+unsigned long CAMOTO_GAMEMAPS_API rleWriteWR(stream::output& output,
+	const std::vector<uint8_t>& data);
+
+} // namespace gamemaps
+} // namespace camoto
+
+#endif // _CAMOTO_GAMEMAPS_RLE_WORDRESC_HPP_
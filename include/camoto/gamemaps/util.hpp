@@ -21,6 +21,9 @@
 #ifndef _CAMOTO_GAMEMAPS_UTIL_HPP_
 #define _CAMOTO_GAMEMAPS_UTIL_HPP_
 
+#include <functional>
+#include <map>
+#include <set>
 #include <camoto/gamemaps/map2d.hpp>
 
 #ifndef CAMOTO_GAMEMAPS_API
@@ -48,6 +51,202 @@ namespace gamemaps {
 void CAMOTO_GAMEMAPS_API getLayerDims(const Map2D& map, const Map2D::Layer& layer,
 	Point *layerSize, Point *tileSize);
 
+/// Take a read-only snapshot of a map as it is now.
+/**
+ * No items are copied when the snapshot is taken.  The snapshot shares the
+ * map's item lists, and a layer's list is only copied the first time that
+ * layer is modified afterwards.  Later changes to the map are not seen by
+ * the snapshot.
+ *
+ * The snapshot can be read by other threads while the original map continues
+ * to be edited, e.g. to render a preview or validate the map.  Taking the
+ * snapshot counts as reading the map, so it must be done on the thread doing
+ * the editing (or while nothing is being edited.)
+ *
+ * @param map
+ *   Map to take a snapshot of.  It is kept alive for as long as the snapshot
+ *   is, as the snapshot still uses it to draw tiles.
+ *
+ * @return A read-only map.  Calling flush() on it will throw an exception;
+ *   to save it, use restoreSnapshot() to copy it into a writable map.
+ *
+ * @note Any reference previously obtained from Map2D::Layer::items() must not
+ *   be used to modify the layer after a snapshot has been taken.  Call items()
+ *   again instead, so the snapshot's copy is left untouched.
+ */
+CAMOTO_GAMEMAPS_API std::shared_ptr<const Map2D> snapshot(
+	std::shared_ptr<const Map2D> map);
+
+/// Copy a map's content into another map of the same format.
+/**
+ * This replaces the items in every layer, along with the attributes and any
+ * map or layer sizes that can be changed.  Item lists are shared rather than
+ * copied where possible, so this is fast even for large maps.
+ *
+ * It can be used to roll a map back to a snapshot, or to save a snapshot to
+ * different files by opening a second copy of the map on the new files,
+ * restoring the snapshot into it and then calling flush() on it.
+ *
+ * @param dest
+ *   Map to modify.
+ *
+ * @param src
+ *   Map or snapshot to copy from.  It must have the same layers and
+ *   attributes as dest.
+ *
+ * @throw camoto::error
+ *   The two maps have a different number of layers or attributes.
+ */
+void CAMOTO_GAMEMAPS_API restoreSnapshot(Map2D& dest, const Map2D& src);
+
+/// Hold a map's grid layers in compressed form, to save memory.
+/**
+ * Each layer that is a plain grid of tile codes (with or without gaps) has
+ * its items replaced with a run-length or bit-packed copy of the codes,
+ * whichever is smaller.  Layers that hold anything else, such as sprites with
+ * extra fields or items out of order, are left as they are.
+ *
+ * Every MapType packs the maps it opens, so this is only needed for maps
+ * that have since been edited, or had their items read, and are to be kept
+ * loaded without being changed again.
+ *
+ * The map still works as normal through the Layer interface.  The first time
+ * a layer's items are read they are rebuilt and the packed copy is dropped,
+ * so a layer never holds both.  The same happens as soon as the layer is
+ * modified.
+ *
+ * Layers whose items have been fetched with Layer::items() are packed too.
+ * This takes back the list that items() returned, so any reference to it
+ * must not be used afterwards.  Call items() again to get the rebuilt list.
+ *
+ * @param map
+ *   Map to compress.  An EditJournal attached to it can still be used, as it
+ *   rebuilds its indices for any layer that was packed.
+ *
+ * @return Number of layers that were packed.
+ */
+unsigned int CAMOTO_GAMEMAPS_API packLayers(Map2D& map);
+
+/// Problem with an item's placement, found by validate().
+struct PlacementProblem {
+	enum class Type {
+		NotPermitted, ///< tilePermittedAt() rejects the item at its position
+		TooMany,      ///< More items with this code than maxCount allows
+		OutOfBounds,  ///< Item is positioned outside the layer
+	};
+	Type type;
+
+	/// Index into Map2D::layers() of the layer containing the item.
+	unsigned int layer;
+
+	/// Index of the item in Map2D::Layer::itemView().
+	std::size_t index;
+
+	/// Position of the item, in tiles.
+	Point pos;
+
+	/// Tile code of the item.
+	unsigned int code;
+
+	/// For TooMany, how many of these items the layer may hold.
+	unsigned int maxCount;
+};
+
+/// Check the placement of every item in a layer.
+/**
+ * Each item is checked against the layer's bounds and tilePermittedAt() (via
+ * a single call to itemsPermitted()), and the number of items using each
+ * code is counted so that instance limits can be enforced.  Every problem is
+ * reported, not just the first.
+ *
+ * When there are too many items with the same code, the first maxCount of
+ * them (in item order) are accepted and only the extra ones are reported.
+ *
+ * @param map
+ *   Map containing the layer.
+ *
+ * @param layer
+ *   Index into map.layers() of the layer to check.
+ *
+ * @return A list of problems, which is empty if the layer is valid.
+ */
+CAMOTO_GAMEMAPS_API std::vector<PlacementProblem> validate(const Map2D& map,
+	unsigned int layer);
+
+/// Check the placement of every item in every layer.
+/**
+ * @return The problems from validate() for each layer in turn.
+ */
+CAMOTO_GAMEMAPS_API std::vector<PlacementProblem> validate(const Map2D& map);
+
+/// Outcome of remapCodes() and transformCodes().
+struct RemapResult {
+	/// Number of items whose code was changed.
+	std::size_t changed;
+
+	/// Codes found in the layer(s) that the table or function didn't cover.
+	/// Items with these codes are left as they are.
+	std::set<unsigned int> unmapped;
+};
+
+/// Change the code of every item in a layer using a lookup table.
+/**
+ * This is intended for moving a map to a different tileset, or normalising
+ * codes across a collection of maps.  Compact tables are expanded into a flat
+ * array so each item needs only a single indexed load.  All the new codes are
+ * worked out before the layer is touched, so a layer that doesn't change is
+ * never copied away from a snapshot sharing it.
+ *
+ * Observers are told about each layer that changes.  Any EditJournal in use
+ * on the map must be clear()ed afterwards.
+ *
+ * @param map
+ *   Map to change.
+ *
+ * @param layer
+ *   Index into map.layers() of the layer to change.
+ *
+ * @param table
+ *   New code for each old code.  Items with INVALID_TILECODE are skipped.
+ *
+ * @return Number of items changed and any codes missing from the table.
+ */
+CAMOTO_GAMEMAPS_API RemapResult remapCodes(Map2D& map, unsigned int layer,
+	const std::map<unsigned int, unsigned int>& table);
+
+/// Change the code of every item in every layer using a lookup table.
+/**
+ * Same as remapCodes(Map2D&, unsigned int, const std::map&) for each layer
+ * in turn, with the results combined.
+ */
+CAMOTO_GAMEMAPS_API RemapResult remapCodes(Map2D& map,
+	const std::map<unsigned int, unsigned int>& table);
+
+/// Function used by transformCodes() to work out a new code.
+/**
+ * @param code
+ *   Existing code.
+ *
+ * @param newCode
+ *   On return, the code to use instead.
+ *
+ * @return true if newCode was set, false if the code is not handled (it will
+ *   be reported as unmapped.)
+ */
+typedef std::function<bool(unsigned int code, unsigned int *newCode)>
+	CodeTransform;
+
+/// Change the code of every item in a layer by calling a function.
+/**
+ * Use this instead of remapCodes() when the new code can be calculated, e.g.
+ * to move codes from one tileset index to another.  The function is called
+ * once for each distinct code in the layer, not once per item.
+ *
+ * @return Number of items changed and any codes the function didn't handle.
+ */
+CAMOTO_GAMEMAPS_API RemapResult transformCodes(Map2D& map, unsigned int layer,
+	const CodeTransform& fn);
+
 } // namespace gamemaps
 } // namespace camoto
 
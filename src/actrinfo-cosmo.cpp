@@ -0,0 +1,110 @@
+/**
+ * @file  actrinfo-cosmo.cpp
+ * @brief Actor information from Cosmo's Cosmic Adventures ACTRINFO.MNI.
+ *
+ * This file format is fully documented on the ModdingWiki:
+ *   http://www.shikadi.net/moddingwiki/ACTRINFO.MNI
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <cassert>
+#include <camoto/gamemaps/actrinfo-cosmo.hpp>
+
+/// Size of each frame record in ACTRINFO.MNI, in bytes
+#define CCA_ACTRINFO_FRAME_LEN 8
+
+namespace camoto {
+namespace gamemaps {
+
+/// Read a little-endian 16-bit value from memory.
+static inline unsigned int readU16LE(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+/// Convert a word offset from the FAT into a byte offset in the file.
+/**
+ * The game loads the file in lots of 65535 bytes, into memory blocks of 65536
+ * bytes.  This means after every 65535 bytes a padding byte appears in memory,
+ * which the offsets include but the file does not, so it has to be taken out.
+ */
+static inline unsigned long fileOffset(unsigned int wordOffset)
+{
+	unsigned long offset = wordOffset * 2;
+	return offset - offset / 65536;
+}
+
+ActorInfo_Cosmo::ActorInfo_Cosmo(stream::input& content)
+{
+	auto lenContent = content.size();
+	std::vector<uint8_t> data(lenContent);
+	content.seekg(0, stream::start);
+	content.read(data.data(), lenContent);
+	this->parse(data.data(), lenContent);
+}
+
+ActorInfo_Cosmo::ActorInfo_Cosmo(const uint8_t *data, unsigned long len)
+{
+	this->parse(data, len);
+}
+
+unsigned int ActorInfo_Cosmo::size() const
+{
+	return this->heights.size();
+}
+
+unsigned int ActorInfo_Cosmo::height(unsigned int index) const
+{
+	assert(index < this->heights.size());
+	return this->heights[index];
+}
+
+unsigned int ActorInfo_Cosmo::frameCount(unsigned int index) const
+{
+	assert(index < this->frames.size());
+	return this->frames[index];
+}
+
+void ActorInfo_Cosmo::parse(const uint8_t *data, unsigned long len)
+{
+	if (len < 2) throw stream::error("Actor info FAT truncated");
+
+	// The first offset points just past the FAT, so it doubles as the number
+	// of entries in it.
+	unsigned int numImages = readU16LE(data);
+	if (len < numImages * 2) throw stream::error("Actor info FAT truncated");
+
+	this->heights.reserve(numImages);
+	this->frames.reserve(numImages);
+	for (unsigned int i = 0; i < numImages; i++) {
+		unsigned long offset = fileOffset(readU16LE(data + i * 2));
+		unsigned long nextOffset = (i == numImages - 1)
+			? len : fileOffset(readU16LE(data + (i + 1) * 2));
+		if (offset + 2 > len) {
+			throw stream::error("Actor info offset is past the end of the file");
+		}
+		this->heights.push_back(readU16LE(data + offset));
+		this->frames.push_back(
+			(nextOffset > offset) ? (nextOffset - offset) / CCA_ACTRINFO_FRAME_LEN : 0
+		);
+	}
+	return;
+}
+
+} // namespace gamemaps
+} // namespace camoto
@@ -0,0 +1,102 @@
+/**
+ * @file  arena.cpp
+ * @brief Memory arena that maps can be loaded into and released all at once.
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <stdint.h>
+#include <camoto/gamemaps/arena.hpp>
+
+namespace camoto {
+namespace gamemaps {
+
+/// Arena used by maps opened on this thread, or nullptr for the heap.
+static thread_local MapArena *currentArena = nullptr;
+
+MapArena::Scope::Scope(MapArena& arena)
+	:	previous(currentArena)
+{
+	currentArena = &arena;
+}
+
+MapArena::Scope::~Scope()
+{
+	currentArena = this->previous;
+}
+
+MapArena::MapArena(std::size_t blockSize)
+	:	blockSize(blockSize),
+		next(nullptr),
+		remaining(0),
+		total(0)
+{
+}
+
+MapArena::~MapArena()
+{
+	for (auto b : this->blocks) ::operator delete(b);
+}
+
+/// Number of bytes needed to bring p up to the given alignment.
+static std::size_t padding(const char *p, std::size_t alignment)
+{
+	return (alignment - ((uintptr_t)p & (alignment - 1))) & (alignment - 1);
+}
+
+void *MapArena::allocate(std::size_t bytes, std::size_t alignment)
+{
+	assert((alignment & (alignment - 1)) == 0);
+	std::lock_guard<std::mutex> guard(this->lock);
+
+	std::size_t pad = padding(this->next, alignment);
+	if (this->next && (pad + bytes <= this->remaining)) {
+		char *p = this->next + pad;
+		this->next = p + bytes;
+		this->remaining -= pad + bytes;
+		return p;
+	}
+
+	// The heap already aligns blocks for any type, so no padding is needed
+	std::size_t size = std::max(bytes, this->blockSize);
+	this->blocks.reserve(this->blocks.size() + 1);
+	char *block = static_cast<char *>(::operator new(size));
+	this->blocks.push_back(block);
+	this->total += size;
+
+	// A large request gets its own block, so the current one keeps its space
+	if (bytes >= this->blockSize) return block;
+
+	this->next = block + bytes;
+	this->remaining = size - bytes;
+	return block;
+}
+
+std::size_t MapArena::size() const
+{
+	std::lock_guard<std::mutex> guard(this->lock);
+	return this->total;
+}
+
+MapArena *MapArena::current()
+{
+	return currentArena;
+}
+
+} // namespace gamemaps
+} // namespace camoto
@@ -0,0 +1,257 @@
+/**
+ * @file  cache.cpp
+ * @brief On-disk cache of decoded maps.
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <utime.h>
+#include <camoto/stream_file.hpp>
+#include <camoto/stream_string.hpp>
+#include <camoto/util.hpp>
+#include <camoto/gamemaps/cache.hpp>
+#include <camoto/gamemaps/manager.hpp>
+#include <camoto/gamemaps/native.hpp>
+#include <camoto/gamemaps/util.hpp>
+#include "hash.hpp"
+
+#ifndef PACKAGE_VERSION
+#define PACKAGE_VERSION "unknown"
+#endif
+
+/// Filename extension of cache entries.
+#define CACHE_EXT ".c2d"
+
+/// Added to an entry's filename while it is being written.
+#define CACHE_TEMP ".tmp"
+
+/// Temporary files untouched for this many seconds have been abandoned.
+#define CACHE_TEMP_MAX_AGE (60 * 60)
+
+namespace camoto {
+namespace gamemaps {
+
+/// One file in the cache directory.
+struct CacheEntry {
+	std::string filename;
+	stream::len size;
+	time_t lastUsed;
+	bool temp;         ///< Entry still being written, or abandoned
+};
+
+/// Does the filename belong to a cache entry?
+static bool isEntry(const std::string& name)
+{
+	auto lenExt = sizeof(CACHE_EXT) - 1;
+	return (name.length() > lenExt)
+		&& (name.compare(name.length() - lenExt, lenExt, CACHE_EXT) == 0);
+}
+
+/// Does the filename belong to a temporary file for a new entry?
+static bool isTemp(const std::string& name)
+{
+	return name.find(CACHE_EXT CACHE_TEMP) != std::string::npos;
+}
+
+/// List the entries and temporary files in the cache directory.
+static std::vector<CacheEntry> listEntries(const std::string& path)
+{
+	std::vector<CacheEntry> entries;
+	DIR *dir = opendir(path.c_str());
+	if (!dir) return entries;
+	struct dirent *d;
+	while ((d = readdir(dir)) != NULL) {
+		std::string name = d->d_name;
+		bool temp = isTemp(name);
+		if (!temp && !isEntry(name)) continue;
+		struct stat st;
+		if (stat((path + name).c_str(), &st) != 0) continue;
+		entries.push_back({path + name, (stream::len)st.st_size, st.st_mtime,
+			temp});
+	}
+	closedir(dir);
+	return entries;
+}
+
+/// Read a whole file into memory.
+static std::string readFile(const std::string& filename)
+{
+	stream::input_file file(filename);
+	return file.read(file.size());
+}
+
+/// Open a map from native format data.
+/**
+ * @return The map, or a null pointer if the data isn't a Map2D.
+ *
+ * @throw stream::error
+ *   The data is invalid.
+ */
+static std::shared_ptr<Map2D> openNative(const std::string& data)
+{
+	auto content = std::make_unique<stream::string>();
+	content->write(data);
+	SuppData none;
+	auto native = MapManager::byCode(CAMOTO_NATIVE_MAPTYPE);
+	auto map = std::shared_ptr<Map>(native->open(std::move(content), none));
+	return std::dynamic_pointer_cast<Map2D>(map);
+}
+
+/// Add a whole stream to a hash, leaving it at the start for reading.
+static void hashStream(ByteHash& hash, stream::input& content)
+{
+	content.seekg(0, stream::start);
+	auto data = content.read(content.size());
+	content.seekg(0, stream::start);
+	hash.add(data);
+	return;
+}
+
+MapCache::MapCache(const std::string& path, stream::len maxSize)
+	:	path(path),
+		maxSize(maxSize)
+{
+	if (this->path.empty()) this->path = ".";
+	if (this->path.back() != '/') this->path += '/';
+	if ((mkdir(this->path.c_str(), 0777) != 0) && (errno != EEXIST)) {
+		throw stream::error(createString("Unable to create cache directory "
+			<< path << ": " << strerror(errno)));
+	}
+}
+
+std::shared_ptr<const Map2D> MapCache::open(const MapType& type,
+	std::unique_ptr<stream::inout> content, SuppData& suppData, bool *hit)
+{
+	ByteHash key;
+	key.add(PACKAGE_VERSION);
+	key.add(type.code());
+	hashStream(key, *content);
+	for (auto& s : suppData) {
+		key.add(suppToString(s.first));
+		hashStream(key, *s.second);
+	}
+	std::string filename = this->path + key.hex() + CACHE_EXT;
+
+	try {
+		auto map2d = openNative(readFile(filename));
+		if (map2d) {
+			// Mark the entry as recently used, so it's evicted last
+			utime(filename.c_str(), NULL);
+			if (hit) *hit = true;
+			return map2d;
+		}
+	} catch (const stream::error&) {
+		// Missing or unreadable entry, parse the original instead
+	}
+
+	if (hit) *hit = false;
+	std::string encoded;
+	{
+		auto map = std::shared_ptr<Map>(type.open(std::move(content), suppData));
+		auto original = std::dynamic_pointer_cast<Map2D>(map);
+		if (!original) {
+			throw stream::error("This map format can't be cached.");
+		}
+		stream::string native;
+		saveNative(*original, native);
+		encoded = std::move(native.data);
+	}
+
+	// Write the entry under a unique name and then move it into place, so
+	// other processes never see a partly written file.
+	static std::atomic<unsigned int> counter(0);
+	std::string temp = createString(filename << CACHE_TEMP << getpid() << "-"
+		<< counter++);
+	try {
+		{
+			stream::output_file file(temp, true);
+			file.write(encoded);
+			file.flush();
+		}
+		if (std::rename(temp.c_str(), filename.c_str()) != 0) {
+			std::remove(temp.c_str());
+		}
+		this->evict(filename);
+	} catch (const stream::error&) {
+		// The cache is only an optimisation, so carry on without it
+		std::remove(temp.c_str());
+	}
+
+	// Return the native copy even on a miss, so callers get the same kind of
+	// map either way.
+	return openNative(encoded);
+}
+
+void MapCache::clear()
+{
+	for (auto& e : listEntries(this->path)) std::remove(e.filename.c_str());
+	return;
+}
+
+stream::len MapCache::size() const
+{
+	stream::len total = 0;
+	for (auto& e : listEntries(this->path)) total += e.size;
+	return total;
+}
+
+void MapCache::evict(const std::string& keep)
+{
+	auto entries = listEntries(this->path);
+
+	// Temporary files still being written by other processes are left alone,
+	// but they count towards the total.
+	time_t abandoned = time(NULL) - CACHE_TEMP_MAX_AGE;
+	stream::len total = 0;
+	for (auto& e : entries) {
+		if (e.temp && (e.lastUsed < abandoned)) {
+			if (std::remove(e.filename.c_str()) == 0) continue;
+		}
+		total += e.size;
+	}
+	if ((this->maxSize == 0) || (total <= this->maxSize)) return;
+
+	// Oldest first
+	std::sort(entries.begin(), entries.end(),
+		[](const CacheEntry& a, const CacheEntry& b) {
+			if (a.lastUsed != b.lastUsed) return a.lastUsed < b.lastUsed;
+			return a.filename < b.filename;
+		}
+	);
+	for (auto& e : entries) {
+		if (total <= this->maxSize) break;
+		if (e.temp || (e.filename == keep)) continue;
+		if (std::remove(e.filename.c_str()) == 0) total -= e.size;
+	}
+	return;
+}
+
+} // namespace gamemaps
+} // namespace camoto
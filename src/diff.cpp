@@ -0,0 +1,292 @@
+/**
+ * @file  diff.cpp
+ * @brief Compare two versions of a map and apply the differences.
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <unordered_set>
+#include <camoto/util.hpp>
+#include <camoto/gamemaps/diff.hpp>
+#include <camoto/gamemaps/journal.hpp>
+
+namespace camoto {
+namespace gamemaps {
+
+typedef Map2D::Layer::Item Item;
+
+/// Key used to group items by cell, in row order.
+static inline unsigned long long rowKey(const Point& pos)
+{
+	return ((unsigned long long)(uint32_t)pos.y << 32) | (uint32_t)pos.x;
+}
+
+/// Items found at one location, in either version of a layer.
+typedef std::vector<const Item *> CellItems;
+
+/// Do both versions of a cell hold the same items, in any order?
+static bool sameCell(const CellItems& a, const CellItems& b)
+{
+	if (a.size() != b.size()) return false;
+	if (a.size() == 1) return sameContent(*a[0], *b[0]);
+	return std::is_permutation(a.begin(), a.end(), b.begin(),
+		[](const Item *x, const Item *y) {
+			return sameContent(*x, *y);
+		}
+	);
+}
+
+/// Add a changed cell to the patch.
+static void addCell(MapPatch *patch, unsigned int layer, const Point& pos,
+	const CellItems& before, const CellItems& after)
+{
+	MapPatch::Cell cell;
+	cell.layer = layer;
+	cell.pos = pos;
+	cell.before.reserve(before.size());
+	for (auto i : before) cell.before.push_back(*i);
+	cell.after.reserve(after.size());
+	for (auto i : after) cell.after.push_back(*i);
+	patch->cells.push_back(std::move(cell));
+	return;
+}
+
+/// Get the item indices of a layer, sorted into row order.
+static std::vector<std::size_t> sortedByCell(const ConstView<Item>& items)
+{
+	std::vector<std::size_t> order(items.size());
+	for (std::size_t i = 0; i < order.size(); i++) order[i] = i;
+	std::stable_sort(order.begin(), order.end(),
+		[&items](std::size_t a, std::size_t b) {
+			return rowKey(items[a].pos) < rowKey(items[b].pos);
+		}
+	);
+	return order;
+}
+
+/// Compare two layers whose items are in the same order.
+/**
+ * Most grid layers are loaded cell by cell, so the same map will have the
+ * same item at the same index in both versions and a single pass will find
+ * the differences.  The cells that differ are then gathered in full, in case
+ * they hold more than one item.
+ *
+ * @return false if the item positions don't line up, in which case nothing
+ *   is added to the patch and diffSorted() must be used instead.
+ */
+static bool diffAligned(MapPatch *patch, unsigned int layer,
+	const ConstView<Item>& from, const ConstView<Item>& to)
+{
+	if (from.size() != to.size()) return false;
+	auto count = from.size();
+	for (std::size_t i = 0; i < count; i++) {
+		if (
+			(from[i].pos.x != to[i].pos.x)
+			|| (from[i].pos.y != to[i].pos.y)
+		) return false;
+	}
+
+	std::vector<unsigned long long> changed;
+	for (std::size_t i = 0; i < count; i++) {
+		if (!sameContent(from[i], to[i])) changed.push_back(rowKey(from[i].pos));
+	}
+	if (changed.empty()) return true;
+
+	std::sort(changed.begin(), changed.end());
+	changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+	// Collect every item in the changed cells, which for a plain grid is just
+	// the one item that differed.
+	std::vector<CellItems> before(changed.size()), after(changed.size());
+	std::unordered_set<unsigned long long> wanted(changed.begin(),
+		changed.end());
+	for (std::size_t i = 0; i < count; i++) {
+		auto key = rowKey(from[i].pos);
+		if (!wanted.count(key)) continue;
+		auto slot = std::lower_bound(changed.begin(), changed.end(), key)
+			- changed.begin();
+		before[slot].push_back(&from[i]);
+		after[slot].push_back(&to[i]);
+	}
+	for (std::size_t c = 0; c < changed.size(); c++) {
+		// Items may only have been reordered within the cell
+		if (sameCell(before[c], after[c])) continue;
+		addCell(patch, layer, before[c][0]->pos, before[c], after[c]);
+	}
+	return true;
+}
+
+/// Compare two layers by sorting both into row order and merging them.
+static void diffSorted(MapPatch *patch, unsigned int layer,
+	const ConstView<Item>& from, const ConstView<Item>& to)
+{
+	auto orderFrom = sortedByCell(from);
+	auto orderTo = sortedByCell(to);
+
+	auto a = orderFrom.begin(), aEnd = orderFrom.end();
+	auto b = orderTo.begin(), bEnd = orderTo.end();
+	CellItems before, after;
+	while ((a != aEnd) || (b != bEnd)) {
+		// Work on whichever cell comes first in either layer
+		Point pos;
+		if ((b == bEnd) || ((a != aEnd)
+			&& (rowKey(from[*a].pos) <= rowKey(to[*b].pos)))
+		) {
+			pos = from[*a].pos;
+		} else {
+			pos = to[*b].pos;
+		}
+		auto key = rowKey(pos);
+
+		before.clear();
+		while ((a != aEnd) && (rowKey(from[*a].pos) == key)) {
+			before.push_back(&from[*a++]);
+		}
+		after.clear();
+		while ((b != bEnd) && (rowKey(to[*b].pos) == key)) {
+			after.push_back(&to[*b++]);
+		}
+		if (!sameCell(before, after)) addCell(patch, layer, pos, before, after);
+	}
+	return;
+}
+
+bool MapPatch::empty() const
+{
+	return this->cells.empty() && this->attributes.empty();
+}
+
+MapPatch MapPatch::inverse() const
+{
+	MapPatch inv;
+	inv.cells.reserve(this->cells.size());
+	for (auto& c : this->cells) {
+		MapPatch::Cell r;
+		r.layer = c.layer;
+		r.pos = c.pos;
+		r.before = c.after;
+		r.after = c.before;
+		inv.cells.push_back(std::move(r));
+	}
+	inv.attributes.reserve(this->attributes.size());
+	for (auto& a : this->attributes) {
+		MapPatch::AttributeChange r;
+		r.index = a.index;
+		r.before = a.after;
+		r.after = a.before;
+		inv.attributes.push_back(std::move(r));
+	}
+	return inv;
+}
+
+MapPatch diff(const Map2D& from, const Map2D& to)
+{
+	auto layersFrom = from.layers();
+	auto layersTo = to.layers();
+	if (layersFrom.size() != layersTo.size()) {
+		throw camoto::error(createString("Can't compare a map with "
+			<< layersFrom.size() << " layers to one with " << layersTo.size()
+			<< " layers."));
+	}
+	auto& attrFrom = from.attributes();
+	auto& attrTo = to.attributes();
+	if (attrFrom.size() != attrTo.size()) {
+		throw camoto::error("Can't compare maps with different attributes.");
+	}
+
+	MapPatch patch;
+	for (unsigned int l = 0; l < layersFrom.size(); l++) {
+		auto itemsFrom = layersFrom[l]->itemView();
+		auto itemsTo = layersTo[l]->itemView();
+		if (!diffAligned(&patch, l, itemsFrom, itemsTo)) {
+			diffSorted(&patch, l, itemsFrom, itemsTo);
+		}
+	}
+
+	for (unsigned int i = 0; i < attrFrom.size(); i++) {
+		if (attrFrom[i].type != attrTo[i].type) {
+			throw camoto::error("Can't compare maps with different attributes.");
+		}
+		if (sameValue(attrFrom[i], attrTo[i])) continue;
+		MapPatch::AttributeChange a;
+		a.index = i;
+		a.before = attrFrom[i];
+		a.after = attrTo[i];
+		patch.attributes.push_back(std::move(a));
+	}
+	return patch;
+}
+
+void applyPatch(std::shared_ptr<Map2D> map, const MapPatch& patch)
+{
+	EditJournal journal(map);
+	journal.applyPatch(patch);
+	return;
+}
+
+bool sameContent(const Item& a, const Item& b)
+{
+	if ((a.type != b.type) || (a.code != b.code)) return false;
+	if (a.type & Item::Type::Player) {
+		if (a.playerNumber != b.playerNumber) return false;
+		if (a.playerFacingLeft != b.playerFacingLeft) return false;
+	}
+	if (a.type & Item::Type::Text) {
+		if (a.textFont != b.textFont) return false;
+		if (a.textContent != b.textContent) return false;
+	}
+	if (a.type & Item::Type::Movement) {
+		if (a.movementFlags != b.movementFlags) return false;
+		if (a.movementFlags & Item::MovementFlags::DistanceLimit) {
+			if (
+				(a.movementDistLeft != b.movementDistLeft)
+				|| (a.movementDistRight != b.movementDistRight)
+				|| (a.movementDistUp != b.movementDistUp)
+				|| (a.movementDistDown != b.movementDistDown)
+			) return false;
+		}
+		if (a.movementFlags & Item::MovementFlags::SpeedLimit) {
+			if (
+				(a.movementSpeedX != b.movementSpeedX)
+				|| (a.movementSpeedY != b.movementSpeedY)
+			) return false;
+		}
+	}
+	if (a.type & Item::Type::Blocking) {
+		if (a.blockingFlags != b.blockingFlags) return false;
+	}
+	if (a.type & Item::Type::Flags) {
+		if (a.generalFlags != b.generalFlags) return false;
+	}
+	return true;
+}
+
+bool sameValue(const Attribute& a, const Attribute& b)
+{
+	if (a.type != b.type) return false;
+	switch (a.type) {
+		case Attribute::Type::Integer: return a.integerValue == b.integerValue;
+		case Attribute::Type::Enum: return a.enumValue == b.enumValue;
+		case Attribute::Type::Filename: return a.filenameValue == b.filenameValue;
+		case Attribute::Type::Text: return a.textValue == b.textValue;
+		case Attribute::Type::Image: return a.imageIndex == b.imageIndex;
+	}
+	return false;
+}
+
+} // namespace gamemaps
+} // namespace camoto
@@ -0,0 +1,166 @@
+/**
+ * @file  fingerprint.cpp
+ * @brief Content hashes of layers and maps.
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <camoto/gamemaps/fingerprint.hpp>
+#include <camoto/gamemaps/util.hpp>
+#include "hash.hpp"
+
+namespace camoto {
+namespace gamemaps {
+
+typedef Map2D::Layer::Item Item;
+
+/// Starting value for every hash, so an empty input doesn't hash to zero.
+#define FP_SEED 0x9E3779B97F4A7C15ULL
+
+/// Add one value to a hash, where the order of values matters.
+static inline uint64_t feed(uint64_t h, uint64_t v)
+{
+	return mix(h ^ mix(v + FP_SEED));
+}
+
+/// Pack a point into one value, so it can be fed in a single step.
+static inline uint64_t packPoint(const Point& pt)
+{
+	return ((uint64_t)(uint32_t)pt.x << 32) | (uint32_t)pt.y;
+}
+
+/// Add a string to a hash, one byte at a time (FNV-1a) so it's portable.
+static uint64_t feed(uint64_t h, const std::string& s)
+{
+	uint64_t fnv = 0xCBF29CE484222325ULL;
+	for (unsigned char c : s) {
+		fnv ^= c;
+		fnv *= 0x100000001B3ULL;
+	}
+	return feed(feed(h, s.length()), fnv);
+}
+
+/// Hash one item, including its position.
+static uint64_t hashItem(const Item& item)
+{
+	auto type = (unsigned int)item.type;
+	uint64_t h = feed(FP_SEED, packPoint(item.pos));
+	h = feed(h, ((uint64_t)type << 32) | item.code);
+	if (item.type & Item::Type::Player) {
+		h = feed(h, ((uint64_t)item.playerNumber << 1)
+			| (item.playerFacingLeft ? 1 : 0));
+	}
+	if (item.type & Item::Type::Text) {
+		h = feed(h, item.textFont);
+		h = feed(h, item.textContent);
+	}
+	if (item.type & Item::Type::Movement) {
+		h = feed(h, (unsigned int)item.movementFlags);
+		if (item.movementFlags & Item::MovementFlags::DistanceLimit) {
+			h = feed(h, ((uint64_t)item.movementDistLeft << 32)
+				| item.movementDistRight);
+			h = feed(h, ((uint64_t)item.movementDistUp << 32)
+				| item.movementDistDown);
+		}
+		if (item.movementFlags & Item::MovementFlags::SpeedLimit) {
+			h = feed(h, ((uint64_t)item.movementSpeedX << 32)
+				| item.movementSpeedY);
+		}
+	}
+	if (item.type & Item::Type::Blocking) {
+		h = feed(h, (unsigned int)item.blockingFlags);
+	}
+	if (item.type & Item::Type::Flags) {
+		h = feed(h, (unsigned int)item.generalFlags);
+	}
+	return h;
+}
+
+LayerHash::LayerHash()
+	:	sum(0),
+		count(0)
+{
+}
+
+void LayerHash::add(const Item& item)
+{
+	this->sum += hashItem(item);
+	this->count++;
+	return;
+}
+
+void LayerHash::remove(const Item& item)
+{
+	this->sum -= hashItem(item);
+	this->count--;
+	return;
+}
+
+uint64_t LayerHash::value(const Point& layerSize) const
+{
+	uint64_t h = feed(FP_SEED, packPoint(layerSize));
+	h = feed(h, this->count);
+	return feed(h, this->sum);
+}
+
+uint64_t fingerprint(const Map2D& map, unsigned int layer)
+{
+	auto layers = map.layers();
+	if (layer >= layers.size()) {
+		throw camoto::error("Tried to fingerprint a layer that doesn't exist.");
+	}
+	auto& l = *layers[layer];
+	LayerHash hash;
+	for (auto& i : l.itemView()) hash.add(i);
+
+	Point layerSize, tileSize;
+	getLayerDims(map, l, &layerSize, &tileSize);
+	return hash.value(layerSize);
+}
+
+uint64_t fingerprint(const Map2D& map)
+{
+	auto count = map.layers().size();
+	std::vector<uint64_t> layers;
+	layers.reserve(count);
+	for (unsigned int l = 0; l < count; l++) {
+		layers.push_back(fingerprint(map, l));
+	}
+	return combineFingerprints(layers, map.attributes());
+}
+
+uint64_t combineFingerprints(const std::vector<uint64_t>& layers,
+	const std::vector<Attribute>& attributes)
+{
+	uint64_t h = feed(FP_SEED, layers.size());
+	for (auto l : layers) h = feed(h, l);
+
+	h = feed(h, attributes.size());
+	for (auto& a : attributes) {
+		h = feed(h, (unsigned int)a.type);
+		switch (a.type) {
+			case Attribute::Type::Integer: h = feed(h, (uint32_t)a.integerValue); break;
+			case Attribute::Type::Enum: h = feed(h, a.enumValue); break;
+			case Attribute::Type::Filename: h = feed(h, a.filenameValue); break;
+			case Attribute::Type::Text: h = feed(h, a.textValue); break;
+			case Attribute::Type::Image: h = feed(h, (uint32_t)a.imageIndex); break;
+		}
+	}
+	return h;
+}
+
+} // namespace gamemaps
+} // namespace camoto
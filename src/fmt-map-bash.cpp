@@ -25,7 +25,9 @@
 #include <cassert>
 #include <cctype>
 #include <cerrno>
-#include <set>
+#include <climits>
+#include <numeric>
+#include <unordered_map>
 #include <camoto/iostream_helpers.hpp>
 #include <camoto/util.hpp> // make_unique
 #include "map-core.hpp"
@@ -75,12 +77,37 @@ static const char *validTypes[] = {
 
 using namespace camoto::gamegraphics;
 
+/// Range of cells in a layer file that need to be written out.
+struct CellSpan
+{
+	unsigned long begin = ULONG_MAX; ///< First cell to write
+	unsigned long end = 0;           ///< One past the last cell to write
+
+	/// Extend the span to cover the given cell.
+	void add(unsigned long i)
+	{
+		this->begin = std::min(this->begin, i);
+		this->end = std::max(this->end, i + 1);
+	}
+
+	bool empty() const
+	{
+		return this->begin >= this->end;
+	}
+
+	void clear()
+	{
+		this->begin = ULONG_MAX;
+		this->end = 0;
+	}
+};
+
 class Layer_Bash_Background: public Map2DCore::LayerCore
 {
 	public:
 		Layer_Bash_Background(std::unique_ptr<stream::inout> content,
 			unsigned long* mapWidth, unsigned long* mapHeight,
-			std::vector<uint16_t>* bgdata)
+			ArenaVector<uint16_t>* bgdata)
 			:	content(std::move(content))
 		{
 			// Read the background layer
@@ -127,6 +154,13 @@ class Layer_Bash_Background: public Map2DCore::LayerCore
 				}
 				if (lenBG < 2) break;
 			}
+
+			// A short file or a header that doesn't match what we would write means
+			// the first save can't just patch the cells that changed.
+			this->rewriteAll = (bgdata->size() < lenLayer)
+				|| (unknown != this->mapStripe());
+			bgdata->resize(lenLayer, MB_DEFAULT_BGTILE);
+
 			*mapWidth = this->mapWidth;
 			*mapHeight = this->mapHeight;
 		}
@@ -134,7 +168,7 @@ class Layer_Bash_Background: public Map2DCore::LayerCore
 		// Populate an array with the tile codes
 		void populate(std::vector<uint16_t>* tiles)
 		{
-			for (auto& i : this->items()) {
+			for (auto& i : this->itemView()) {
 				if (
 					(i.pos.x >= (signed long)this->mapWidth)
 					|| (i.pos.y >= (signed long)this->mapHeight)
@@ -146,24 +180,41 @@ class Layer_Bash_Background: public Map2DCore::LayerCore
 			return;
 		}
 
-		// Write a tile code array to the underlying file
-		void flush(const std::vector<uint16_t>& tiles)
+		/// Write part of a tile code array to the underlying file.
+		/**
+		 * @param tiles
+		 *   Tile codes for the whole layer, with attribute flags merged in.
+		 *
+		 * @param span
+		 *   Cells that have changed since the last write.  Only these are written,
+		 *   unless the file on disk can't be patched in place, in which case the
+		 *   whole file is rewritten.
+		 */
+		void flush(const ArenaVector<uint16_t>& tiles, CellSpan span)
 		{
-			this->content->truncate(2*4 + tiles.size()*2);
-			this->content->seekp(0, stream::start);
-			uint16_t mapStripe = this->mapHeight * (MB_TILE_WIDTH * MB_TILE_HEIGHT)
-				+ this->mapWidth;
-			uint16_t mapWidthBytes = this->mapWidth * 2; // 2 == sizeof(uint16_t)
-			uint16_t mapPixelWidth = this->mapWidth * MB_TILE_WIDTH;
-			uint16_t mapPixelHeight = this->mapHeight * MB_TILE_HEIGHT;
-			*this->content
-				<< u16le(mapStripe)
-				<< u16le(mapWidthBytes)
-				<< u16le(mapPixelWidth)
-				<< u16le(mapPixelHeight)
-			;
-			for (auto& i : tiles) {
-				*this->content << u16le(i);
+			stream::len lenFile = 2*4 + tiles.size()*2;
+			if (this->rewriteAll || (this->content->size() != lenFile)) {
+				this->content->truncate(lenFile);
+				this->content->seekp(0, stream::start);
+				uint16_t mapWidthBytes = this->mapWidth * 2; // 2 == sizeof(uint16_t)
+				uint16_t mapPixelWidth = this->mapWidth * MB_TILE_WIDTH;
+				uint16_t mapPixelHeight = this->mapHeight * MB_TILE_HEIGHT;
+				*this->content
+					<< u16le(this->mapStripe())
+					<< u16le(mapWidthBytes)
+					<< u16le(mapPixelWidth)
+					<< u16le(mapPixelHeight)
+				;
+				span.begin = 0;
+				span.end = tiles.size();
+				this->rewriteAll = false;
+			} else if (span.empty()) {
+				return;
+			} else {
+				this->content->seekp(2*4 + span.begin*2, stream::start);
+			}
+			for (auto i = span.begin; i < span.end; i++) {
+				*this->content << u16le(tiles[i]);
 			}
 			this->content->flush();
 			return;
@@ -201,26 +252,39 @@ class Layer_Bash_Background: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> items;
-			for (unsigned int i = 0; i <= MB_MAX_VALID_BG_TILECODE; i++) {
-				// The default tile actually has an image, so don't exclude it
-				if (i == MB_DEFAULT_BGTILE) continue;
-
-				items.emplace_back();
-				auto& t = items.back();
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i;
-			}
-			return items;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> items;
+				for (unsigned int i = 0; i <= MB_MAX_VALID_BG_TILECODE; i++) {
+					// The default tile actually has an image, so don't exclude it
+					if (i == MB_DEFAULT_BGTILE) continue;
+
+					items.emplace_back();
+					auto& t = items.back();
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i;
+				}
+				return items;
+			}();
+			return available;
 		}
 
 	private:
+		/// Value of the first header field, as the game expects it.
+		uint16_t mapStripe() const
+		{
+			return this->mapHeight * (MB_TILE_WIDTH * MB_TILE_HEIGHT)
+				+ this->mapWidth;
+		}
+
 		std::unique_ptr<stream::inout> content;
 		unsigned long mapWidth;
 		unsigned long mapHeight;
+
+		/// Set if the next flush must write the whole file, not just changes.
+		bool rewriteAll;
 };
 
 class Layer_Bash_Foreground: public Map2DCore::LayerCore
@@ -228,7 +292,7 @@ class Layer_Bash_Foreground: public Map2DCore::LayerCore
 	public:
 		Layer_Bash_Foreground(std::unique_ptr<stream::inout> content,
 			unsigned long mapWidth, unsigned long mapHeight,
-			std::vector<uint8_t>* fgdata)
+			ArenaVector<uint8_t>* fgdata)
 			:	content(std::move(content)),
 				mapWidth(mapWidth),
 				mapHeight(mapHeight)
@@ -243,6 +307,7 @@ class Layer_Bash_Foreground: public Map2DCore::LayerCore
 			fgdata->resize(lenLayer, MB_DEFAULT_FGTILE);
 			auto fg = fgdata->data();
 			this->content->read(fg, std::min(lenLayer, lenFG));
+			this->rewriteAll = lenFG != lenLayer;
 			for (unsigned int y = 0; y < this->mapHeight; y++) {
 				for (unsigned int x = 0; x < this->mapWidth; x++) {
 					uint8_t code = *fg++;
@@ -260,9 +325,9 @@ class Layer_Bash_Foreground: public Map2DCore::LayerCore
 
 		// Populate an array with the tile codes
 		void populate(std::vector<uint8_t>* tiles,
-			std::set<std::string>* usedSprites)
+			std::vector<bool>* usedSprites)
 		{
-			for (auto& i : this->items()) {
+			for (auto& i : this->itemView()) {
 				if (
 					(i.pos.x >= (signed long)this->mapWidth)
 					|| (i.pos.y >= (signed long)this->mapHeight)
@@ -275,17 +340,34 @@ class Layer_Bash_Foreground: public Map2DCore::LayerCore
 			return;
 		}
 
-		// Write a tile code array to the underlying file
-		void flush(const std::vector<uint8_t>& tiles)
+		/// Write the changed part of a tile code array to the underlying file.
+		/**
+		 * @param tiles
+		 *   Tile codes for the whole layer.
+		 *
+		 * @param span
+		 *   Cells that differ from what is currently in the file.
+		 */
+		void flush(const ArenaVector<uint8_t>& tiles, CellSpan span)
 		{
-			this->content->truncate(2 + tiles.size());
-			this->content->seekp(0, stream::start);
-			uint16_t mapWidthBytes = this->mapWidth;
-			*this->content
-				<< u16le(mapWidthBytes)
-			;
+			stream::len lenFile = 2 + tiles.size();
+			if (this->rewriteAll || (this->content->size() != lenFile)) {
+				this->content->truncate(lenFile);
+				this->content->seekp(0, stream::start);
+				uint16_t mapWidthBytes = this->mapWidth;
+				*this->content
+					<< u16le(mapWidthBytes)
+				;
+				span.begin = 0;
+				span.end = tiles.size();
+				this->rewriteAll = false;
+			} else if (span.empty()) {
+				return;
+			} else {
+				this->content->seekp(2 + span.begin, stream::start);
+			}
 			// Only byte-length fields, so can write as a block
-			this->content->write(tiles.data(), tiles.size());
+			this->content->write(tiles.data() + span.begin, span.end - span.begin);
 			this->content->flush();
 			return;
 		}
@@ -346,25 +428,31 @@ class Layer_Bash_Foreground: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> items;
-			for (unsigned int i = 0; i <= MB_MAX_VALID_FG_TILECODE; i++) {
-				if (i == MB_DEFAULT_FGTILE) continue;
-
-				Map2D::Layer::Item t;
-				t.type = Map2D::Layer::Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i;
-				items.push_back(t);
-			}
-			return items;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> items;
+				for (unsigned int i = 0; i <= MB_MAX_VALID_FG_TILECODE; i++) {
+					if (i == MB_DEFAULT_FGTILE) continue;
+
+					Map2D::Layer::Item t;
+					t.type = Map2D::Layer::Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i;
+					items.push_back(t);
+				}
+				return items;
+			}();
+			return available;
 		}
 
 	private:
 		std::unique_ptr<stream::inout> content;
 		unsigned long mapWidth;
 		unsigned long mapHeight;
+
+		/// Set if the file was short, so the next flush must write all of it.
+		bool rewriteAll;
 };
 
 class Layer_Bash_Sprite: public Map2DCore::LayerCore
@@ -409,16 +497,10 @@ class Layer_Bash_Sprite: public Map2DCore::LayerCore
 							break;
 						}
 						// Reached end of dep
-						this->spriteDeps.insert(std::make_pair(sprite, dep));
-						if (std::find(this->spriteFilenames.begin(),
-								this->spriteFilenames.end(), sprite) == this->spriteFilenames.end()
-						) {
-							this->spriteFilenames.push_back(sprite);
-						}
-						if (std::find(this->spriteFilenames.begin(),
-								this->spriteFilenames.end(), dep) == this->spriteFilenames.end()
-						) {
-							this->spriteFilenames.push_back(dep);
+						{
+							auto idSprite = this->internSprite(sprite);
+							auto idDep = this->internSprite(dep);
+							this->spriteDeps[idSprite].push_back(idDep);
 						}
 						sprite.clear();
 						dep.clear();
@@ -431,6 +513,16 @@ class Layer_Bash_Sprite: public Map2DCore::LayerCore
 			assert(sprite.empty());
 			assert(dep.empty());
 
+			// The SGL file lists sprites in name order, so work that order out once
+			// rather than sorting names every time the map is saved.
+			this->spriteOrder.resize(this->spriteFilenames.size());
+			std::iota(this->spriteOrder.begin(), this->spriteOrder.end(), 0);
+			std::sort(this->spriteOrder.begin(), this->spriteOrder.end(),
+				[this](unsigned int a, unsigned int b) {
+					return this->spriteFilenames[a] < this->spriteFilenames[b];
+				}
+			);
+
 			// Read the sprite layer
 			stream::pos lenSpr = this->content->size();
 			this->content->seekg(2, stream::start); // skip unknown field
@@ -455,11 +547,9 @@ class Layer_Bash_Sprite: public Map2DCore::LayerCore
 				this->content->seekg(22, stream::cur); // skip padding
 				std::string filename;
 				*this->content >> nullPadded(filename, lenEntry - (4+4+4+2+4+4+22));
-				auto it = std::find(this->spriteFilenames.begin(),
-					this->spriteFilenames.end(), filename);
-				if (it != this->spriteFilenames.end()) {
-					t.code = BASH_SPRITE_OFFSET
-						+ std::distance(this->spriteFilenames.begin(), it);
+				auto it = this->spriteIDs.find(filename);
+				if (it != this->spriteIDs.end()) {
+					t.code = BASH_SPRITE_OFFSET + it->second;
 				} else {
 					std::cout << "ERROR: Encounted Monster Bash sprite with unexpected "
 						"name \"" << filename << "\" - unable to add to map.\n";
@@ -467,30 +557,49 @@ class Layer_Bash_Sprite: public Map2DCore::LayerCore
 				}
 				lenSpr -= lenEntry;
 			}
+
+			// Every sprite listed in the SGL file can be placed
+			for (unsigned int i = 0; i < this->spriteFilenames.size(); i++) {
+				this->available.emplace_back();
+				auto& t = this->available.back();
+				t.type = Item::Type::Default;
+				t.pos = {0, 0};
+				t.code = BASH_SPRITE_OFFSET + i;
+			}
 		}
 
-		void flush(std::set<std::string>& usedSprites)
+		/// Write the sprite layer and the list of sprites it needs.
+		/**
+		 * @param usedSprites
+		 *   One entry per sprite ID, set to true for any sprite that must be
+		 *   listed in the SGL file on top of those placed in this layer.  On
+		 *   return every sprite written to the SGL file is marked.
+		 */
+		void flush(std::vector<bool>& usedSprites)
 		{
-			// Write the sprite layer
+			auto numSprites = this->spriteFilenames.size();
+			usedSprites.resize(numSprites, false);
 
 			// These sprites must always be present in a level
-			auto extraSprites = this->spriteDeps.equal_range("*");
-			for (auto i = extraSprites.first; i != extraSprites.second; i++) {
-				usedSprites.insert(i->second);
+			auto always = this->spriteIDs.find("*");
+			if (always != this->spriteIDs.end()) {
+				for (auto dep : this->spriteDeps[always->second]) {
+					usedSprites[dep] = true;
+				}
 			}
 
-			auto items = this->items();
+			auto items = this->itemView();
 
 			// Figure out how much data we have to write
 			stream::len lenTotal = 2;
 			for (auto& i : items) {
 				if (i.code < BASH_SPRITE_OFFSET) continue;
 				unsigned int code = i.code - BASH_SPRITE_OFFSET;
-				if (code >= this->spriteFilenames.size()) {
+				if (code >= numSprites) {
 					std::cerr << "ERROR: Tried to write out-of-range sprite to Monster Bash map\n";
 					continue;
 				}
-				std::string filename = this->spriteFilenames[code];
+				auto& filename = this->spriteFilenames[code];
 				int lenFilename = filename.length() + 2; // need two terminating nulls
 				stream::len lenEntry = 4+4+4+2+4+4+22+lenFilename;
 				lenTotal += lenEntry;
@@ -504,7 +613,9 @@ class Layer_Bash_Sprite: public Map2DCore::LayerCore
 			// Write the data
 			for (auto& i : items) {
 				if (i.code < BASH_SPRITE_OFFSET) continue;
-				std::string filename = this->spriteFilenames[i.code - BASH_SPRITE_OFFSET];
+				unsigned int code = i.code - BASH_SPRITE_OFFSET;
+				if (code >= numSprites) continue;
+				auto& filename = this->spriteFilenames[code];
 				int lenFilename = filename.length() + 2; // need two terminating nulls
 				uint32_t lenEntry = 4+4+4+2+4+4+22+lenFilename;
 				*this->content
@@ -518,25 +629,27 @@ class Layer_Bash_Sprite: public Map2DCore::LayerCore
 					<< nullPadded(filename, lenFilename);
 				;
 
-				usedSprites.insert(filename);
+				usedSprites[code] = true;
 
 				// Add any dependent sprites to the list
-				auto extraSprites = this->spriteDeps.equal_range(filename);
-				for (auto i = extraSprites.first; i != extraSprites.second; i++) {
-					usedSprites.insert(i->second);
+				for (auto dep : this->spriteDeps[code]) {
+					usedSprites[dep] = true;
 				}
 			}
 			this->content->flush();
 			assert(this->content->tellp() == lenTotal);
 
 			// Write out a list of all required sprites
-			this->contentSGL->truncate(usedSprites.size() * 31);
+			stream::len numUsed =
+				std::count(usedSprites.begin(), usedSprites.end(), true);
+			this->contentSGL->truncate(numUsed * 31);
 			this->contentSGL->seekp(0, stream::start);
-			for (auto& i : usedSprites) {
-				*this->contentSGL << nullPadded(i, 31);
+			for (auto id : this->spriteOrder) {
+				if (!usedSprites[id]) continue;
+				*this->contentSGL << nullPadded(this->spriteFilenames[id], 31);
 			}
 			this->contentSGL->flush();
-			assert(this->contentSGL->tellp() == usedSprites.size() * 31);
+			assert(this->contentSGL->tellp() == numUsed * 31);
 			return;
 		}
 
@@ -571,13 +684,13 @@ class Layer_Bash_Sprite: public Map2DCore::LayerCore
 				ret.type = ImageFromCodeInfo::ImageType::Unknown;
 				return ret;
 			}
-			if (item.code - BASH_SPRITE_OFFSET > this->spriteFilenames.size()) {
+			if (item.code - BASH_SPRITE_OFFSET >= this->spriteFilenames.size()) {
 				// Out of range somehow
 				ret.type = ImageFromCodeInfo::ImageType::Unknown;
 				return ret;
 			}
 
-			auto img = this->spriteFilenames[item.code - BASH_SPRITE_OFFSET];
+			auto& img = this->spriteFilenames[item.code - BASH_SPRITE_OFFSET];
 			auto& images = t->second->files();
 			for (auto& i : images) {
 				if (i->strName.compare(img) == 0) {
@@ -600,29 +713,42 @@ class Layer_Bash_Sprite: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> items;
-			for (unsigned int i = 0; i < this->spriteFilenames.size(); i++) {
-				items.emplace_back();
-				auto& t = items.back();
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = BASH_SPRITE_OFFSET + i;
-			}
-			return items;
+			return this->available;
 		}
 
 	private:
+		/// Get the ID for a sprite name, adding it to the table if it's new.
+		unsigned int internSprite(const std::string& name)
+		{
+			auto ins = this->spriteIDs.emplace(name, this->spriteFilenames.size());
+			if (ins.second) {
+				this->spriteFilenames.push_back(name);
+				this->spriteDeps.emplace_back();
+			}
+			return ins.first->second;
+		}
+
 		std::unique_ptr<stream::inout> content; // sprite layer
 		std::unique_ptr<stream::inout> contentSGL; // sprite filename list
 
-		/// List of sprites and which additional sprites they require (can have
-		/// multiple entries for each sprite)
-		std::multimap<std::string, std::string> spriteDeps;
-
-		/// Unique list of all known sprite names
+		/// Unique list of all known sprite names, indexed by sprite ID.  Item
+		/// codes are these IDs plus BASH_SPRITE_OFFSET.
 		std::vector<std::string> spriteFilenames;
+
+		/// Reverse lookup from sprite name to index in spriteFilenames
+		std::unordered_map<std::string, unsigned int> spriteIDs;
+
+		/// IDs of the additional sprites each sprite requires, indexed by ID.
+		/// The entry for "*" lists sprites every level needs.
+		std::vector<std::vector<unsigned int>> spriteDeps;
+
+		/// Sprite IDs sorted by name, the order they appear in the SGL file
+		std::vector<unsigned int> spriteOrder;
+
+		/// Items returned by availableItems(), one for each sprite filename
+		std::vector<Item> available;
 };
 
 class Layer_Bash_Attribute: virtual public Map2DCore::LayerCore
@@ -631,8 +757,8 @@ class Layer_Bash_Attribute: virtual public Map2DCore::LayerCore
 		Layer_Bash_Attribute(std::unique_ptr<stream::input> contentPropBG,
 			std::unique_ptr<stream::input> contentPropFG,
 			std::unique_ptr<stream::input> contentPropBO,
-			const std::vector<uint16_t>& bgdata,
-			const std::vector<uint8_t>& fgdata,
+			const ArenaVector<uint16_t>& bgdata,
+			const ArenaVector<uint8_t>& fgdata,
 			unsigned long mapWidth, unsigned long mapHeight)
 			:	mapWidth(mapWidth),
 				mapHeight(mapHeight)
@@ -708,14 +834,16 @@ class Layer_Bash_Attribute: virtual public Map2DCore::LayerCore
 			}
 		}
 
-		void parseValues(stream::input& content, std::vector<uint8_t>* values)
+		void parseValues(stream::input& content, ArenaVector<uint8_t>* values)
 		{
 			auto len = content.size();
 			if (len > 1048576) throw stream::error("Tile property data (<content/> in XML for tile properties) too large.");
-			std::vector<char> data(len, 0);
+			ArenaVector<char> data(len, 0);
 			char *d = data.data();
 			char *start = d, *end = d;
 			content.read(d, len);
+			// Every value takes at least one digit and one separator
+			values->reserve(values->size() + (len + 1) / 2);
 			do {
 				d = end;
 				errno = 0;
@@ -736,14 +864,10 @@ class Layer_Bash_Attribute: virtual public Map2DCore::LayerCore
 			return;
 		}
 
-		// Run through the tile properties for the layers, and update
-		// the flags in the BG layer as needed
-		void populate(std::vector<uint16_t>* bgdata, std::vector<uint8_t>* fgdata)
+		// Populate an array with the attribute flags set explicitly in this layer
+		void populate(uint8_t *atdata)
 		{
-			// Retrieve the attribute tiles
-			auto lenLayer = this->mapWidth * this->mapHeight;
-			std::vector<uint8_t> atdata(lenLayer, 0);
-			for (auto& i : this->items()) {
+			for (auto& i : this->itemView()) {
 				if (
 					(i.pos.x >= (signed long)this->mapWidth)
 					|| (i.pos.y >= (signed long)this->mapHeight)
@@ -753,40 +877,40 @@ class Layer_Bash_Attribute: virtual public Map2DCore::LayerCore
 				// Multiple tiles can go in the same spot, so combine them
 				atdata[i.pos.y * this->mapWidth + i.pos.x] |= i.code;
 			}
+			return;
+		}
 
-			// Merge everything together
-			const auto sizeBG = this->propBG.size();
-			const auto sizeFG = this->propFG.size();
-			const auto sizeBO = this->propBO.size();
-			auto bg = bgdata->data();
-			auto fg = fgdata->data();
-			auto at = atdata.data();
-			while (lenLayer-- > 0) {
-				if (*at) {
-					// There is an item in the attribute layer, so this trumps all the
-					// standard codes.
-					*bg |= *at << 9;
-				} else {
-					// bg has no flags set yet, so just here it's a raw tilecode
-					if (*bg < sizeBG) {
-						*bg |= propBG[*bg] << 9;
-					}
-					// bg now has flags set, so it's no longer a raw tilecode
-
-					// Combine the value from the foreground layer
-					auto& propFGBO = (*fg & 0x80) ? propFG : propBO;
-					auto& sizeFGBO = (*fg & 0x80) ? sizeFG : sizeBO;
-					if ((*fg & 0x7F) < sizeFGBO) {
-						// Set background flags from foreground tile (not a typo, we want to
-						// update *bg)
-						*bg |= propFGBO[*fg & 0x7F] << 9;
-					}
-				}
-				bg++;
-				fg++;
-				at++;
+		/// Work out the background word to write for a single cell.
+		/**
+		 * @param bg
+		 *   Background tile code, without any attribute flags.
+		 *
+		 * @param fg
+		 *   Foreground tile code.
+		 *
+		 * @param at
+		 *   Attribute flags set explicitly in this layer, or 0 to use the
+		 *   standard flags from the tile property tables.
+		 *
+		 * @return bg with the attribute flags merged into the upper bits.
+		 */
+		uint16_t merge(uint16_t bg, uint8_t fg, uint8_t at) const
+		{
+			// An item in the attribute layer trumps all the standard codes.
+			if (at) return bg | (at << 9);
+
+			uint16_t word = bg;
+			if (bg < this->propBG.size()) {
+				word |= this->propBG[bg] << 9;
 			}
-			return;
+
+			// Combine the value from the foreground layer (not a typo, the flags go
+			// into the background word)
+			auto& propFGBO = (fg & 0x80) ? this->propFG : this->propBO;
+			if ((fg & 0x7F) < propFGBO.size()) {
+				word |= propFGBO[fg & 0x7F] << 9;
+			}
+			return word;
 		}
 
 		virtual std::string title() const
@@ -807,57 +931,60 @@ class Layer_Bash_Attribute: virtual public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> items;
-			for (unsigned int i = 0; i < 16; i++) {
-				items.emplace_back();
-				auto& t = items.back();
-				t.type = Item::Type::Blocking;
-				t.pos = {0, 0};
-				t.code = i;
-				t.blockingFlags = Item::BlockingFlags::Default;
-				if (i & 1) t.blockingFlags |= Item::BlockingFlags::BlockLeft;
-				if (i & 2) t.blockingFlags |= Item::BlockingFlags::BlockRight;
-				if (i & 4) t.blockingFlags |= Item::BlockingFlags::BlockTop;
-				if (i & 8) t.blockingFlags |= Item::BlockingFlags::BlockBottom;
-			}
-			{
-				// Interactive (point) item
-				items.emplace_back();
-				auto& t = items.back();
-				t.type = Item::Type::Flags;
-				t.pos = {0, 0};
-				t.code = 16;
-				t.generalFlags = Item::GeneralFlags::Interactive;
-			}
-			{
-				items.emplace_back();
-				auto& t = items.back();
-				t.type = Item::Type::Blocking;
-				t.pos = {0, 0};
-				t.code = 32;
-				t.blockingFlags = Item::BlockingFlags::Default;
-				t.blockingFlags |= Item::BlockingFlags::Slant45;
-			}
-			{
-				// Ladder
-				items.emplace_back();
-				auto& t = items.back();
-				t.type = Item::Type::Movement;
-				t.pos = {0, 0};
-				t.code = 64;
-				t.movementFlags = Item::MovementFlags::DistanceLimit;
-				t.movementDistLeft = 0;
-				t.movementDistRight = 0;
-				t.movementDistUp = Item::DistIndeterminate;
-				t.movementDistDown = Item::DistIndeterminate;
-			}
-			return items;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> items;
+				for (unsigned int i = 0; i < 16; i++) {
+					items.emplace_back();
+					auto& t = items.back();
+					t.type = Item::Type::Blocking;
+					t.pos = {0, 0};
+					t.code = i;
+					t.blockingFlags = Item::BlockingFlags::Default;
+					if (i & 1) t.blockingFlags |= Item::BlockingFlags::BlockLeft;
+					if (i & 2) t.blockingFlags |= Item::BlockingFlags::BlockRight;
+					if (i & 4) t.blockingFlags |= Item::BlockingFlags::BlockTop;
+					if (i & 8) t.blockingFlags |= Item::BlockingFlags::BlockBottom;
+				}
+				{
+					// Interactive (point) item
+					items.emplace_back();
+					auto& t = items.back();
+					t.type = Item::Type::Flags;
+					t.pos = {0, 0};
+					t.code = 16;
+					t.generalFlags = Item::GeneralFlags::Interactive;
+				}
+				{
+					items.emplace_back();
+					auto& t = items.back();
+					t.type = Item::Type::Blocking;
+					t.pos = {0, 0};
+					t.code = 32;
+					t.blockingFlags = Item::BlockingFlags::Default;
+					t.blockingFlags |= Item::BlockingFlags::Slant45;
+				}
+				{
+					// Ladder
+					items.emplace_back();
+					auto& t = items.back();
+					t.type = Item::Type::Movement;
+					t.pos = {0, 0};
+					t.code = 64;
+					t.movementFlags = Item::MovementFlags::DistanceLimit;
+					t.movementDistLeft = 0;
+					t.movementDistRight = 0;
+					t.movementDistUp = Item::DistIndeterminate;
+					t.movementDistDown = Item::DistIndeterminate;
+				}
+				return items;
+			}();
+			return available;
 		}
 
 	private:
-		std::vector<uint8_t> propBG, propFG, propBO;
+		ArenaVector<uint8_t> propBG, propFG, propBO;
 		unsigned long mapWidth;
 		unsigned long mapHeight;
 };
@@ -902,6 +1029,7 @@ class Map_Bash: public MapCore, public Map2DCore
 				"Unknown",
 			};
 			this->content->seekg(0, stream::start);
+			this->v_attributes.reserve(MB_NUM_ATTRIBUTES);
 			for (unsigned int i = 0; i < MB_NUM_ATTRIBUTES; i++) {
 				this->v_attributes.emplace_back();
 				auto& attr = this->v_attributes.back();
@@ -924,15 +1052,12 @@ class Map_Bash: public MapCore, public Map2DCore
 				attr.filenameSpec.push_back(std::string("*.") + validTypes[i]);
 			}
 
-			std::vector<uint16_t> bgdata;
-			std::vector<uint8_t> fgdata;
-
 			// Read each layer
 			auto layerBG = std::make_shared<Layer_Bash_Background>(
 				std::move(contentBG),
 				&this->mapWidth,
 				&this->mapHeight,
-				&bgdata
+				&this->bgdata
 			);
 			this->v_layers.push_back(layerBG);
 
@@ -941,21 +1066,35 @@ class Map_Bash: public MapCore, public Map2DCore
 					std::move(contentFG),
 					this->mapWidth,
 					this->mapHeight,
-					&fgdata
+					&this->fgdata
 				)
 			);
 
-			this->v_layers.push_back(
-				std::make_shared<Layer_Bash_Attribute>(
-					std::move(contentPropBG),
-					std::move(contentPropFG),
-					std::move(contentPropBO),
-					bgdata,
-					fgdata,
-					this->mapWidth,
-					this->mapHeight
-				)
+			auto layerAT = std::make_shared<Layer_Bash_Attribute>(
+				std::move(contentPropBG),
+				std::move(contentPropFG),
+				std::move(contentPropBO),
+				this->bgdata,
+				this->fgdata,
+				this->mapWidth,
+				this->mapHeight
 			);
+			this->v_layers.push_back(layerAT);
+
+			// Merge the attribute flags now, exactly as flush() would, so saving
+			// later on only has to redo the cells that were edited.  Any word that
+			// doesn't match the file gets written out on the first save.
+			auto lenLayer = this->mapWidth * this->mapHeight;
+			this->atdata.resize(lenLayer, 0);
+			layerAT->populate(this->atdata.data());
+			for (unsigned long i = 0; i < lenLayer; i++) {
+				auto word = layerAT->merge(this->bgdata[i] & 0x1FF, this->fgdata[i],
+					this->atdata[i]);
+				if (word != this->bgdata[i]) {
+					this->bgdata[i] = word;
+					this->dirtyBG.add(i);
+				}
+			}
 
 			this->v_layers.push_back(
 				std::make_shared<Layer_Bash_Sprite>(
@@ -1019,30 +1158,54 @@ class Map_Bash: public MapCore, public Map2DCore
 			}
 
 			auto lenLayer = this->mapWidth * this->mapHeight;
-			std::set<std::string> usedSprites;
+			std::vector<bool> usedSprites;
 
 			auto layerBG = dynamic_cast<Layer_Bash_Background*>(this->v_layers[0].get());
 			auto layerFG = dynamic_cast<Layer_Bash_Foreground*>(this->v_layers[1].get());
 			auto layerAT = dynamic_cast<Layer_Bash_Attribute*>(this->v_layers[2].get());
 			auto layerSP = dynamic_cast<Layer_Bash_Sprite*>(this->v_layers[3].get());
 
-			// Populate the background data.  We can't write it yet as it contains
-			// flags which might be changed by tiles in the the foreground layer.
-			std::vector<uint16_t> bgdata(lenLayer, MB_DEFAULT_BGTILE);
-			layerBG->populate(&bgdata);
-
-			// Populate the foreground data.  We can't write this yet either, as the
-			// background data must be written first.
-			std::vector<uint8_t> fgdata(lenLayer, MB_DEFAULT_FGTILE);
-			layerFG->populate(&fgdata, &usedSprites);
-
-			// Run through the tile properties for the foreground layer, and update
-			// the flags in the BG layer as needed
-			layerAT->populate(&bgdata, &fgdata);
+			// Collect the tile codes from each layer.  The attribute flags aren't
+			// merged into the background codes yet, as they might be changed by
+			// tiles in the foreground layer.
+			std::vector<uint16_t> bgcodes(lenLayer, MB_DEFAULT_BGTILE);
+			layerBG->populate(&bgcodes);
+
+			std::vector<uint8_t> fgcodes(lenLayer, MB_DEFAULT_FGTILE);
+			layerFG->populate(&fgcodes, &usedSprites);
+
+			std::vector<uint8_t> atcodes(lenLayer, 0);
+			layerAT->populate(atcodes.data());
+
+			// Only cells where one of the layers has changed since the last save
+			// need their attribute flags worked out again.  The tile property
+			// tables are fixed for the life of the map, so they can't invalidate
+			// any other cells.
+			for (unsigned long i = 0; i < lenLayer; i++) {
+				bool fgChanged = fgcodes[i] != this->fgdata[i];
+				if (fgChanged) {
+					this->fgdata[i] = fgcodes[i];
+					this->dirtyFG.add(i);
+				}
+				if (
+					fgChanged
+					|| (atcodes[i] != this->atdata[i])
+					|| (bgcodes[i] != (this->bgdata[i] & 0x1FF))
+				) {
+					this->atdata[i] = atcodes[i];
+					auto word = layerAT->merge(bgcodes[i], fgcodes[i], atcodes[i]);
+					if (word != this->bgdata[i]) {
+						this->bgdata[i] = word;
+						this->dirtyBG.add(i);
+					}
+				}
+			}
 
-			// Now write the data to the underlying files
-			layerBG->flush(bgdata);
-			layerFG->flush(fgdata);
+			// Now write the changes to the underlying files
+			layerBG->flush(this->bgdata, this->dirtyBG);
+			this->dirtyBG.clear();
+			layerFG->flush(this->fgdata, this->dirtyFG);
+			this->dirtyFG.clear();
 			layerSP->flush(usedSprites);
 
 			return;
@@ -1084,6 +1247,23 @@ class Map_Bash: public MapCore, public Map2DCore
 		std::unique_ptr<stream::inout> content;
 		unsigned long mapWidth;
 		unsigned long mapHeight;
+
+		// These are filled while the map is loaded, so they come from its arena.
+
+		/// Background words as they are in the file, attribute flags included.
+		ArenaVector<uint16_t> bgdata;
+
+		/// Foreground codes as they are in the file.
+		ArenaVector<uint8_t> fgdata;
+
+		/// Attribute layer flags that were merged into bgdata.
+		ArenaVector<uint8_t> atdata;
+
+		/// Cells in bgdata not yet written to the background file.
+		CellSpan dirtyBG;
+
+		/// Cells in fgdata not yet written to the foreground file.
+		CellSpan dirtyFG;
 };
 
 
@@ -1179,7 +1359,7 @@ std::unique_ptr<Map> MapType_Bash::open(
 	if (suppPropFG == suppData.end()) throw stream::error("Missing content for Extra3 (foreground tile properties) supplementary item.");
 	if (suppPropBO == suppData.end()) throw stream::error("Missing content for Extra4 (bonus tile properties) supplementary item.");
 	if (suppDepsSP == suppData.end()) throw stream::error("Missing content for Extra5 (full sprite list) supplementary item.");
-	return std::make_unique<Map_Bash>(
+	return openPacked<Map_Bash>(
 		std::move(content),
 		std::move(suppBG->second),
 		std::move(suppFG->second),
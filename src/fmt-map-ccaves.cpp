@@ -163,72 +163,75 @@ class Layer_CCaves_Background: public Layer_CCaves_Common
 			return Caps::Default;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
-			Item item;
-			for (unsigned int i = 0; i < sizeof(tileMapVine) / sizeof(TILE_MAP_VINE); i++) {
-				TILE_MAP_VINE& m = tileMapVine[i];
-
-				item.type = Item::Type::Default;
-				item.pos = {0, 0}; // required for selections to work
-				item.code = m.tileIndexMid;
-				validItems.push_back(item);
-
-				item.type = Item::Type::Default;
-				item.pos = {0, 0}; // required for selections to work
-				item.code = m.tileIndexEnd;
-				validItems.push_back(item);
-			}
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> validItems;
+				Item item;
+				for (unsigned int i = 0; i < sizeof(tileMapVine) / sizeof(TILE_MAP_VINE); i++) {
+					TILE_MAP_VINE& m = tileMapVine[i];
 
-			for (unsigned int i = 0; i < sizeof(tileMapSign) / sizeof(TILE_MAP_SIGN); i++) {
-				TILE_MAP_SIGN& m = tileMapSign[i];
+					item.type = Item::Type::Default;
+					item.pos = {0, 0}; // required for selections to work
+					item.code = m.tileIndexMid;
+					validItems.push_back(item);
 
-				for (unsigned int j = 0; j < sizeof(m.tileIndexBG) / sizeof(int); j++) {
-					if (m.tileIndexBG[j] == ___________) continue;
 					item.type = Item::Type::Default;
 					item.pos = {0, 0}; // required for selections to work
-					item.code = m.tileIndexBG[j];
-					if (j == 0) setFlags(item, m.flags);
+					item.code = m.tileIndexEnd;
 					validItems.push_back(item);
 				}
-			}
 
-			for (unsigned int i = 0; i < sizeof(tileMap) / sizeof(TILE_MAP); i++) {
-				TILE_MAP& m = tileMap[i];
+				for (unsigned int i = 0; i < sizeof(tileMapSign) / sizeof(TILE_MAP_SIGN); i++) {
+					TILE_MAP_SIGN& m = tileMapSign[i];
 
-				for (unsigned int j = 0; j < sizeof(m.tileIndexBG) / sizeof(int); j++) {
-					if (m.tileIndexBG[j] == ___________) continue;
-					item.type = Item::Type::Default;
-					item.pos = {0, 0}; // required for selections to work
-					if (IS_IBEAM(m.tileIndexBG[j])) {
-						item.code = CCT_IBEAM(ibeam_tile, m.tileIndexBG[j]);
-					} else if (IS_BLOCK(m.tileIndexBG[j])) {
-						item.code = CCT_BLOCK(block_tile, m.tileIndexBG[j]);
-					} else if (m.tileIndexBG[j] == CCT_USCORE) {
-						item.code = underscore_tile;
-					} else {
+					for (unsigned int j = 0; j < sizeof(m.tileIndexBG) / sizeof(int); j++) {
+						if (m.tileIndexBG[j] == ___________) continue;
+						item.type = Item::Type::Default;
+						item.pos = {0, 0}; // required for selections to work
 						item.code = m.tileIndexBG[j];
+						if (j == 0) setFlags(item, m.flags);
+						validItems.push_back(item);
 					}
-					if (j == 0) setFlags(item, m.flags);
-					validItems.push_back(item);
 				}
-			}
 
-			for (unsigned int i = 0; i < sizeof(tileMap4x1) / sizeof(TILE_MAP); i++) {
-				TILE_MAP& m = tileMap4x1[i];
+				for (unsigned int i = 0; i < sizeof(tileMap) / sizeof(TILE_MAP); i++) {
+					TILE_MAP& m = tileMap[i];
 
-				for (unsigned int j = 0; j < sizeof(m.tileIndexBG) / sizeof(int); j++) {
-					if (m.tileIndexBG[j] == ___________) continue;
-					Item item;
-					item.type = Item::Type::Default;
-					item.pos = {0, 0}; // required for selections to work
-					item.code = m.tileIndexBG[j];
-					if (j == 0) setFlags(item, m.flags);
-					validItems.push_back(item);
+					for (unsigned int j = 0; j < sizeof(m.tileIndexBG) / sizeof(int); j++) {
+						if (m.tileIndexBG[j] == ___________) continue;
+						item.type = Item::Type::Default;
+						item.pos = {0, 0}; // required for selections to work
+						if (IS_IBEAM(m.tileIndexBG[j])) {
+							item.code = CCT_IBEAM(ibeam_tile, m.tileIndexBG[j]);
+						} else if (IS_BLOCK(m.tileIndexBG[j])) {
+							item.code = CCT_BLOCK(block_tile, m.tileIndexBG[j]);
+						} else if (m.tileIndexBG[j] == CCT_USCORE) {
+							item.code = underscore_tile;
+						} else {
+							item.code = m.tileIndexBG[j];
+						}
+						if (j == 0) setFlags(item, m.flags);
+						validItems.push_back(item);
+					}
 				}
-			}
-			return validItems;
+
+				for (unsigned int i = 0; i < sizeof(tileMap4x1) / sizeof(TILE_MAP); i++) {
+					TILE_MAP& m = tileMap4x1[i];
+
+					for (unsigned int j = 0; j < sizeof(m.tileIndexBG) / sizeof(int); j++) {
+						if (m.tileIndexBG[j] == ___________) continue;
+						Item item;
+						item.type = Item::Type::Default;
+						item.pos = {0, 0}; // required for selections to work
+						item.code = m.tileIndexBG[j];
+						if (j == 0) setFlags(item, m.flags);
+						validItems.push_back(item);
+					}
+				}
+				return validItems;
+			}();
+			return available;
 		}
 };
 
@@ -253,22 +256,25 @@ class Layer_CCaves_Foreground: public Layer_CCaves_Common
 			return Caps::Default;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
-			Item item;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> validItems;
+				Item item;
 
-			for (unsigned int i = 0; i < sizeof(tileMap) / sizeof(TILE_MAP); i++) {
-				TILE_MAP& m = tileMap[i];
+				for (unsigned int i = 0; i < sizeof(tileMap) / sizeof(TILE_MAP); i++) {
+					TILE_MAP& m = tileMap[i];
 
-				if (m.tileIndexFG != ___________) {
-					item.type = Item::Type::Default;
-					item.pos = {0, 0}; // required for selections to work
-					item.code = m.tileIndexFG;
-					validItems.push_back(item);
+					if (m.tileIndexFG != ___________) {
+						item.type = Item::Type::Default;
+						item.pos = {0, 0}; // required for selections to work
+						item.code = m.tileIndexFG;
+						validItems.push_back(item);
+					}
 				}
-			}
-			return validItems;
+				return validItems;
+			}();
+			return available;
 		}
 };
 
@@ -284,15 +290,16 @@ class Map_CCaves: public MapCore, public Map2DCore
 			this->v_layers.push_back(layerBG);
 			this->v_layers.push_back(layerFG);
 
-			auto& tilesBG = layerBG->items();
-			auto& tilesFG = layerFG->items();
+			// Filled here and handed to the layers at the end, as loading through
+			// items() would stop the layers' items from being shared
+			SharedItems::ItemList tilesBG, tilesFG;
 
 			stream::pos lenMap = this->content->size();
 			this->mapHeight = lenMap / (CC_MAP_WIDTH + 1);
 
 			// Read the background layer
 			this->content->seekg(0, stream::start);
-			std::vector<uint8_t> bgdata(lenMap, CCT_EMPTY);
+			ArenaVector<uint8_t> bgdata(lenMap, CCT_EMPTY);
 			this->content->read(bgdata.data(), lenMap);
 
 			tilesBG.reserve(CC_MAP_WIDTH * this->mapHeight);
@@ -461,6 +468,8 @@ class Map_CCaves: public MapCore, public Map2DCore
 #undef INSERT_TILE
 #undef BGTILE
 #undef SET_NEXT_TILE
+			layerBG->sharedItems(SharedItems(std::move(tilesBG)));
+			layerFG->sharedItems(SharedItems(std::move(tilesFG)));
 		}
 
 		virtual ~Map_CCaves()
@@ -479,7 +488,7 @@ class Map_CCaves: public MapCore, public Map2DCore
 
 		virtual void flush()
 		{
-			assert(this->layers().size() == 2);
+			assert(this->v_layers.size() == 2);
 
 			auto mapSize = this->mapSize();
 
@@ -499,7 +508,7 @@ class Map_CCaves: public MapCore, public Map2DCore
 			std::vector<unsigned int> bgattr(lenBG, CCTF_MV_NONE);
 			std::vector<int> fgsrc(lenBG, -1);
 
-			for (const auto& i : this->v_layers[0]->items()) {
+			for (const auto& i : this->v_layers[0]->itemView()) {
 				if ((i.pos.x >= mapSize.x) || (i.pos.y >= mapSize.y)) {
 					throw stream::error("Background layer has tiles outside map boundary!");
 				}
@@ -534,7 +543,7 @@ class Map_CCaves: public MapCore, public Map2DCore
 				}
 			}
 
-			for (const auto& i : this->v_layers[1]->items()) {
+			for (const auto& i : this->v_layers[1]->itemView()) {
 				if ((i.pos.x >= mapSize.x) || (i.pos.y >= mapSize.y)) {
 					throw stream::error("Foreground layer has tiles outside map boundary!");
 				}
@@ -810,7 +819,7 @@ std::unique_ptr<Map> MapType_CCaves::create(
 std::unique_ptr<Map> MapType_CCaves::open(
 	std::unique_ptr<stream::inout> content, SuppData& suppData) const
 {
-	return std::make_unique<Map_CCaves>(std::move(content));
+	return openPacked<Map_CCaves>(std::move(content));
 }
 
 SuppFilenames MapType_CCaves::getRequiredSupps(stream::input& content,
@@ -119,19 +119,22 @@ class Layer_CComic_Background: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
-			for (unsigned int i = 0; i <= CC_MAX_VALID_TILECODE; i++) {
-				if (i == CC_DEFAULT_BGTILE) continue;
-
-				Item t;
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i;
-				validItems.push_back(t);
-			}
-			return validItems;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> validItems;
+				for (unsigned int i = 0; i <= CC_MAX_VALID_TILECODE; i++) {
+					if (i == CC_DEFAULT_BGTILE) continue;
+
+					Item t;
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i;
+					validItems.push_back(t);
+				}
+				return validItems;
+			}();
+			return available;
 		}
 };
 
@@ -300,7 +303,7 @@ std::unique_ptr<Map> MapType_CComic::open(
 	if (exe == suppData.end()) {
 		throw stream::error("Missing content for layer: Extra1");
 	}
-	return std::make_unique<Map_CComic>(std::move(content), std::move(exe->second));
+	return openPacked<Map_CComic>(std::move(content), std::move(exe->second));
 }
 
 SuppFilenames MapType_CComic::getRequiredSupps(stream::input& content,
@@ -25,6 +25,7 @@
 #include <camoto/iostream_helpers.hpp>
 #include <camoto/util.hpp> // make_unique
 #include <camoto/gamegraphics/image-memory.hpp>
+#include <camoto/gamemaps/actrinfo-cosmo.hpp>
 #include "map-core.hpp"
 #include "map2d-core.hpp"
 #include "fmt-map-cosmo.hpp"
@@ -72,11 +73,10 @@ using namespace camoto::gamegraphics;
 class Layer_Cosmo_Actors: public Map2DCore::LayerCore
 {
 	public:
-		Layer_Cosmo_Actors(stream::input& content, stream::input& actrinfo,
-			stream::pos& lenMap)
+		Layer_Cosmo_Actors(stream::input& content,
+			std::shared_ptr<const ActorInfo_Cosmo> actorInfo, stream::pos& lenMap)
+			:	actorInfo(actorInfo)
 		{
-			this->readActorHeights(actrinfo);
-
 			// Read in the actor layer
 			uint16_t numActorInts;
 			content >> u16le(numActorInts);
@@ -94,9 +94,13 @@ class Layer_Cosmo_Actors: public Map2DCore::LayerCore
 
 				// Sprite coordinates are for the bottom-left tile, but Camoto uses the
 				// top-left, so we have to adjust the sprites based on their height.
+				// Actors without any frames have no height to adjust by.
 				int index = this->actorCodeToTileIndex(t.code);
-				if ((index >= 0) && ((unsigned int)index < this->actorHeight.size())) {
-					t.pos.y -= this->actorHeight[index] - 1;
+				if (
+					(index >= 0) && ((unsigned int)index < this->actorInfo->size())
+					&& (this->actorInfo->frameCount(index) > 0)
+				) {
+					t.pos.y -= this->actorInfo->height(index) - 1;
 				}
 
 				switch (t.code) {
@@ -234,58 +238,21 @@ class Layer_Cosmo_Actors: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
-		{
-			std::vector<Item> validItems;
-			/// @todo Populate proper item list
-			for (int i = 0; i < 10; i++) {
-				validItems.emplace_back();
-				auto& t = validItems.back();
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i + 31;
-			}
-			return validItems;
-		}
-
-		/// Read in the actor info, so we can find the height of each actor
-		void readActorHeights(stream::input& content)
+		virtual const std::vector<Item>& availableItems() const
 		{
-			auto lenContent = content.size();
-			content.seekg(0, stream::start);
-			unsigned int nextOffset;
-			content >> u16le(nextOffset);
-
-			unsigned int numImages = nextOffset;
-			// The file data is loaded in lots of 65535 bytes, into memory blocks of
-			// 65536 bytes.  This means after every 65535 bytes, a padding byte should be
-			// inserted in order for the offsets to add up correctly.  Likewise when
-			// saving data, every 65536th byte should be dropped.
-			nextOffset *= 2;
-			nextOffset -= nextOffset / 65536;
-			if (lenContent < numImages * 2) {
-				throw stream::error("Actor info FAT truncated");
-			}
-			std::vector<stream::pos> offsets;
-			offsets.reserve(numImages);
-			for (unsigned int i = 0; i < numImages; i++) {
-				offsets.push_back(nextOffset);
-				if (i == numImages - 1) {
-					nextOffset = lenContent;
-				} else {
-					content >> u16le(nextOffset);
-					nextOffset *= 2;
-					nextOffset -= nextOffset / 65536;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> validItems;
+				/// @todo Populate proper item list
+				for (int i = 0; i < 10; i++) {
+					validItems.emplace_back();
+					auto& t = validItems.back();
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i + 31;
 				}
-			}
-			// Now read the sizes
-			uint16_t height;
-			for (auto i : offsets) {
-				content.seekg(i, stream::start);
-				content >> u16le(height);
-				this->actorHeight.push_back(height);
-			}
-			return;
+				return validItems;
+			}();
+			return available;
 		}
 
 		/// Convert an actor code from the map file to an actrinfo index.
@@ -301,8 +268,8 @@ class Layer_Cosmo_Actors: public Map2DCore::LayerCore
 		}
 
 	protected:
-		/// Height of each actor frame, in tiles
-		std::vector<unsigned int> actorHeight;
+		/// Size of each actor, possibly shared with other open levels
+		std::shared_ptr<const ActorInfo_Cosmo> actorInfo;
 };
 
 class Layer_Cosmo_Background: public Map2DCore::LayerCore
@@ -342,7 +309,7 @@ class Layer_Cosmo_Background: public Map2DCore::LayerCore
 			unsigned long lenBG = mapSize.x * mapSize.y;
 			std::vector<uint16_t> bg(lenBG, CCA_DEFAULT_BGTILE);
 
-			for (auto& i : this->items()) {
+			for (auto& i : this->itemView()) {
 				if ((i.pos.x >= mapSize.x) || (i.pos.y >= mapSize.y)) {
 					throw stream::error("Layer has tiles outside map boundary!");
 				}
@@ -399,35 +366,159 @@ class Layer_Cosmo_Background: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
-			for (unsigned int i = 0; i < CCA_NUM_SOLID_TILES; i++) {
-				if (i == CCA_DEFAULT_BGTILE) continue;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> validItems;
+				for (unsigned int i = 0; i < CCA_NUM_SOLID_TILES; i++) {
+					if (i == CCA_DEFAULT_BGTILE) continue;
 
-				validItems.emplace_back();
-				auto& t = validItems.back();
+					validItems.emplace_back();
+					auto& t = validItems.back();
 
-				t.type = Map2D::Layer::Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i << 3;
-			}
-			for (unsigned int i = 0; i < CCA_NUM_MASKED_TILES; i++) {
-				validItems.emplace_back();
-				auto& t = validItems.back();
+					t.type = Map2D::Layer::Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i << 3;
+				}
+				for (unsigned int i = 0; i < CCA_NUM_MASKED_TILES; i++) {
+					validItems.emplace_back();
+					auto& t = validItems.back();
 
-				t.type = Map2D::Layer::Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = (CCA_NUM_SOLID_TILES + i * 5) << 3;
-			}
-			return validItems;
+					t.type = Map2D::Layer::Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = (CCA_NUM_SOLID_TILES + i * 5) << 3;
+				}
+				return validItems;
+			}();
+			return available;
 		}
 };
 
+/// Attribute list for Cosmo maps, with all values left at zero.
+/**
+ * The backdrop and song names never change, so the list is built on first use
+ * and shared by every map, which only keeps its own values.
+ */
+static const std::vector<Attribute>& attributeSchemaCosmo()
+{
+	static const std::vector<Attribute> schema = []() -> std::vector<Attribute> {
+		std::vector<Attribute> attrs;
+
+		assert(attrs.size() == ATTR_BACKDROP); // make sure compile-time index is correct
+		attrs.emplace_back();
+		auto& attrBackdrop = attrs.back();
+		attrBackdrop.type = Attribute::Type::Enum;
+		attrBackdrop.name = "Backdrop";
+		attrBackdrop.desc = "Index of backdrop to draw behind level.";
+		attrBackdrop.enumValueNames = {
+			"0 - Blank (bdblank.mni)",
+			"1 - Pipe (bdpipe.mni)",
+			"2 - Red Sky (bdredsky.mni)",
+			"3 - Rock (bdrocktk.mni)",
+			"4 - Jungle (bdjungle.mni)",
+			"5 - Star (bdstar.mni)",
+			"6 - Weird (bdwierd.mni)",
+			"7 - Cave (bdcave.mni)",
+			"8 - Ice (bdice.mni)",
+			"9 - Shrum (bdshrum.mni)",
+			"10 - Tech (bdtechms.mni)",
+			"11 - New sky (bdnewsky.mni)",
+			"12 - Star 2 (bdstar2.mni)",
+			"13 - Star 3 (bdstar3.mni)",
+			"14 - Forest (bdforest.mni)",
+			"15 - Mountain (bdmountn.mni)",
+			"16 - Guts (bdguts.mni)",
+			"17 - Broken Tech (bdbrktec.mni)",
+			"18 - Clouds (bdclouds.mni)",
+			"19 - Future city (bdfutcty.mni)",
+			"20 - Ice 2 (bdice2.mni)",
+			"21 - Cliff (bdcliff.mni)",
+			"22 - Spooky (bdspooky.mni)",
+			"23 - Crystal (bdcrystl.mni)",
+			"24 - Circuit (bdcircut.mni)",
+			"25 - Circuit PC (bdcircpc.mni)",
+		};
+
+		assert(attrs.size() == ATTR_RAIN); // make sure compile-time index is correct
+		attrs.emplace_back();
+		auto& attrRain = attrs.back();
+		attrRain.type = Attribute::Type::Enum;
+		attrRain.name = "Rain";
+		attrRain.desc = "Is it raining in this level?";
+		attrRain.enumValueNames = {"No", "Yes"};
+
+		assert(attrs.size() == ATTR_SCROLL_X); // make sure compile-time index is correct
+		attrs.emplace_back();
+		auto& attrScrollX = attrs.back();
+		attrScrollX.type = Attribute::Type::Enum;
+		attrScrollX.name = "Scroll X";
+		attrScrollX.desc = "Should the backdrop scroll horizontally?";
+		attrScrollX.enumValueNames = {"No", "Yes"};
+
+		assert(attrs.size() == ATTR_SCROLL_Y); // make sure compile-time index is correct
+		attrs.emplace_back();
+		auto& attrScrollY = attrs.back();
+		attrScrollY.type = Attribute::Type::Enum;
+		attrScrollY.name = "Scroll Y";
+		attrScrollY.desc = "Should the backdrop scroll vertically?";
+		attrScrollY.enumValueNames = {"No", "Yes"};
+
+		assert(attrs.size() == ATTR_PAL_ANIM); // make sure compile-time index is correct
+		attrs.emplace_back();
+		auto& attrPalAnim = attrs.back();
+		attrPalAnim.type = Attribute::Type::Enum;
+		attrPalAnim.name = "Palette animation";
+		attrPalAnim.desc = "Type of colour animation to use in this level.  Only "
+			"dark magenta (EGA colour 5) is animated.";
+		attrPalAnim.enumValueNames = {
+			"0 - No animation",
+			"1 - Lightning",
+			"2 - Cycle: red -> yellow -> white",
+			"3 - Cycle: red -> green -> blue",
+			"4 - Cycle: black -> grey -> white",
+			"5 - Flashing: red -> magenta -> white",
+			"6 - Dark magenta -> black, bomb trigger",
+			"7 - Unknown/unused",
+		};
+
+		assert(attrs.size() == ATTR_MUSIC); // make sure compile-time index is correct
+		attrs.emplace_back();
+		auto& attrMusic = attrs.back();
+		attrMusic.type = Attribute::Type::Enum;
+		attrMusic.name = "Music";
+		attrMusic.desc = "Index of the song to play as background music in the level.";
+		attrMusic.enumValueNames = {
+			"0 - Caves (mcaves.mni)",
+			"1 - Scarry (mscarry.mni)",
+			"2 - Boss (mboss.mni)",
+			"3 - Run Away (mrunaway.mni)",
+			"4 - Circus (mcircus.mni)",
+			"5 - Tech World (mtekwrd.mni)",
+			"6 - Easy Level (measylev.mni)",
+			"7 - Rock It (mrockit.mni)",
+			"8 - Happy (mhappy.mni)",
+			"9 - Devo (mdevo.mni)",
+			"10 - Dadoda (mdadoda.mni)",
+			"11 - Bells (mbells.mni)",
+			"12 - Drums (mdrums.mni)",
+			"13 - Banjo (mbanjo.mni)",
+			"14 - Easy 2 (measy2.mni)",
+			"15 - Tech 2 (mteck2.mni)",
+			"16 - Tech 3 (mteck3.mni)",
+			"17 - Tech 4 (mteck4.mni)",
+			"18 - ZZ Top (mzztop.mni)",
+		};
+
+		return attrs;
+	}();
+	return schema;
+}
+
 class Map_Cosmo: public MapCore, public Map2DCore
 {
 	public:
-		Map_Cosmo(std::unique_ptr<stream::inout> content, stream::input& actrinfo)
+		Map_Cosmo(std::unique_ptr<stream::inout> content,
+			std::shared_ptr<const ActorInfo_Cosmo> actorInfo)
 			:	content(std::move(content))
 		{
 			stream::pos lenMap = this->content->size();
@@ -441,120 +532,17 @@ class Map_Cosmo: public MapCore, public Map2DCore
 			lenMap -= 4;
 
 			// Set the attributes
-			assert(this->v_attributes.size() == ATTR_BACKDROP); // make sure compile-time index is correct
-			this->v_attributes.emplace_back();
-			auto& attrBackdrop = this->v_attributes.back();
-			attrBackdrop.type = Attribute::Type::Enum;
-			attrBackdrop.name = "Backdrop";
-			attrBackdrop.desc = "Index of backdrop to draw behind level.";
-			attrBackdrop.enumValue = flags & 0x1F;
-			attrBackdrop.enumValueNames = {
-				"0 - Blank (bdblank.mni)",
-				"1 - Pipe (bdpipe.mni)",
-				"2 - Red Sky (bdredsky.mni)",
-				"3 - Rock (bdrocktk.mni)",
-				"4 - Jungle (bdjungle.mni)",
-				"5 - Star (bdstar.mni)",
-				"6 - Weird (bdwierd.mni)",
-				"7 - Cave (bdcave.mni)",
-				"8 - Ice (bdice.mni)",
-				"9 - Shrum (bdshrum.mni)",
-				"10 - Tech (bdtechms.mni)",
-				"11 - New sky (bdnewsky.mni)",
-				"12 - Star 2 (bdstar2.mni)",
-				"13 - Star 3 (bdstar3.mni)",
-				"14 - Forest (bdforest.mni)",
-				"15 - Mountain (bdmountn.mni)",
-				"16 - Guts (bdguts.mni)",
-				"17 - Broken Tech (bdbrktec.mni)",
-				"18 - Clouds (bdclouds.mni)",
-				"19 - Future city (bdfutcty.mni)",
-				"20 - Ice 2 (bdice2.mni)",
-				"21 - Cliff (bdcliff.mni)",
-				"22 - Spooky (bdspooky.mni)",
-				"23 - Crystal (bdcrystl.mni)",
-				"24 - Circuit (bdcircut.mni)",
-				"25 - Circuit PC (bdcircpc.mni)",
-			};
-
-			assert(this->v_attributes.size() == ATTR_RAIN); // make sure compile-time index is correct
-			this->v_attributes.emplace_back();
-			auto& attrRain = this->v_attributes.back();
-			attrRain.type = Attribute::Type::Enum;
-			attrRain.name = "Rain";
-			attrRain.desc = "Is it raining in this level?";
-			attrRain.enumValue = (flags >> 5) & 1;
-			attrRain.enumValueNames = {"No", "Yes"};
-
-			assert(this->v_attributes.size() == ATTR_SCROLL_X); // make sure compile-time index is correct
-			this->v_attributes.emplace_back();
-			auto& attrScrollX = this->v_attributes.back();
-			attrScrollX.type = Attribute::Type::Enum;
-			attrScrollX.name = "Scroll X";
-			attrScrollX.desc = "Should the backdrop scroll horizontally?";
-			attrScrollX.enumValue = (flags >> 6) & 1;
-			attrScrollX.enumValueNames = {"No", "Yes"};
-
-			assert(this->v_attributes.size() == ATTR_SCROLL_Y); // make sure compile-time index is correct
-			this->v_attributes.emplace_back();
-			auto& attrScrollY = this->v_attributes.back();
-			attrScrollY.type = Attribute::Type::Enum;
-			attrScrollY.name = "Scroll Y";
-			attrScrollY.desc = "Should the backdrop scroll vertically?";
-			attrScrollY.enumValue = (flags >> 7) & 1;
-			attrScrollY.enumValueNames = {"No", "Yes"};
-
-			assert(this->v_attributes.size() == ATTR_PAL_ANIM); // make sure compile-time index is correct
-			this->v_attributes.emplace_back();
-			auto& attrPalAnim = this->v_attributes.back();
-			attrPalAnim.type = Attribute::Type::Enum;
-			attrPalAnim.name = "Palette animation";
-			attrPalAnim.desc = "Type of colour animation to use in this level.  Only "
-				"dark magenta (EGA colour 5) is animated.";
-			attrPalAnim.enumValue = (flags >> 8) & 7;
-			attrPalAnim.enumValueNames = {
-				"0 - No animation",
-				"1 - Lightning",
-				"2 - Cycle: red -> yellow -> white",
-				"3 - Cycle: red -> green -> blue",
-				"4 - Cycle: black -> grey -> white",
-				"5 - Flashing: red -> magenta -> white",
-				"6 - Dark magenta -> black, bomb trigger",
-				"7 - Unknown/unused",
-			};
-
-			assert(this->v_attributes.size() == ATTR_MUSIC); // make sure compile-time index is correct
-			this->v_attributes.emplace_back();
-			auto& attrMusic = this->v_attributes.back();
-			attrMusic.type = Attribute::Type::Enum;
-			attrMusic.name = "Music";
-			attrMusic.desc = "Index of the song to play as background music in the level.";
-			attrMusic.enumValue = flags >> 11;
-			attrMusic.enumValueNames = {
-				"0 - Caves (mcaves.mni)",
-				"1 - Scarry (mscarry.mni)",
-				"2 - Boss (mboss.mni)",
-				"3 - Run Away (mrunaway.mni)",
-				"4 - Circus (mcircus.mni)",
-				"5 - Tech World (mtekwrd.mni)",
-				"6 - Easy Level (measylev.mni)",
-				"7 - Rock It (mrockit.mni)",
-				"8 - Happy (mhappy.mni)",
-				"9 - Devo (mdevo.mni)",
-				"10 - Dadoda (mdadoda.mni)",
-				"11 - Bells (mbells.mni)",
-				"12 - Drums (mdrums.mni)",
-				"13 - Banjo (mbanjo.mni)",
-				"14 - Easy 2 (measy2.mni)",
-				"15 - Tech 2 (mteck2.mni)",
-				"16 - Tech 3 (mteck3.mni)",
-				"17 - Tech 4 (mteck4.mni)",
-				"18 - ZZ Top (mzztop.mni)",
-			};
+			this->attributesFromSchema(attributeSchemaCosmo());
+			this->attributeValue(ATTR_BACKDROP, flags & 0x1F);
+			this->attributeValue(ATTR_RAIN, (flags >> 5) & 1);
+			this->attributeValue(ATTR_SCROLL_X, (flags >> 6) & 1);
+			this->attributeValue(ATTR_SCROLL_Y, (flags >> 7) & 1);
+			this->attributeValue(ATTR_PAL_ANIM, (flags >> 8) & 7);
+			this->attributeValue(ATTR_MUSIC, flags >> 11);
 
 			// Read in the actor layer
 			auto layerAC = std::make_shared<Layer_Cosmo_Actors>(
-				*this->content, actrinfo, lenMap
+				*this->content, actorInfo, lenMap
 			);
 
 			// Read the background layer
@@ -574,26 +562,17 @@ class Map_Cosmo: public MapCore, public Map2DCore
 
 		virtual void flush()
 		{
-			assert(this->layers().size() == 2);
+			assert(this->v_layers.size() == 2);
 
 			auto mapSize = this->mapSize();
 
-			assert(this->v_attributes.size() == 6);
-
-			assert(this->v_attributes[ATTR_BACKDROP].type == Attribute::Type::Enum);
-			assert(this->v_attributes[ATTR_RAIN    ].type == Attribute::Type::Enum);
-			assert(this->v_attributes[ATTR_SCROLL_X].type == Attribute::Type::Enum);
-			assert(this->v_attributes[ATTR_SCROLL_Y].type == Attribute::Type::Enum);
-			assert(this->v_attributes[ATTR_PAL_ANIM].type == Attribute::Type::Enum);
-			assert(this->v_attributes[ATTR_MUSIC   ].type == Attribute::Type::Enum);
-
 			uint16_t flags =
-				   this->v_attributes[ATTR_BACKDROP].enumValue
-				| (this->v_attributes[ATTR_RAIN    ].enumValue << 5)
-				| (this->v_attributes[ATTR_SCROLL_X].enumValue << 6)
-				| (this->v_attributes[ATTR_SCROLL_Y].enumValue << 7)
-				| (this->v_attributes[ATTR_PAL_ANIM].enumValue << 8)
-				| (this->v_attributes[ATTR_MUSIC   ].enumValue << 11)
+				   this->attributeNumber(ATTR_BACKDROP)
+				| (this->attributeNumber(ATTR_RAIN    ) << 5)
+				| (this->attributeNumber(ATTR_SCROLL_X) << 6)
+				| (this->attributeNumber(ATTR_SCROLL_Y) << 7)
+				| (this->attributeNumber(ATTR_PAL_ANIM) << 8)
+				| (this->attributeNumber(ATTR_MUSIC   ) << 11)
 			;
 
 			this->content->seekp(0, stream::start);
@@ -620,7 +599,7 @@ class Map_Cosmo: public MapCore, public Map2DCore
 			GraphicsFilename gf;
 			gf.type = "img-cosmo-backdrop";
 
-			switch (this->v_attributes.at(ATTR_BACKDROP).enumValue) {
+			switch (this->attributeNumber(ATTR_BACKDROP)) {
 				case 0: gf.filename = "bdblank.mni"; break;
 				case 1: gf.filename = "bdpipe.mni"; break;
 				case 2: gf.filename = "bdredsky.mni"; break;
@@ -769,7 +748,14 @@ std::unique_ptr<Map> MapType_Cosmo::open(
 		throw camoto::error("Missing content for Extra1 (actor info) "
 			"supplementary item.");
 	}
-	return std::make_unique<Map_Cosmo>(std::move(content), *(suppActrInfo->second));
+	return openCosmo(std::move(content),
+		std::make_shared<ActorInfo_Cosmo>(*(suppActrInfo->second)));
+}
+
+std::unique_ptr<Map> openCosmo(std::unique_ptr<stream::inout> content,
+	std::shared_ptr<const ActorInfo_Cosmo> actorInfo)
+{
+	return openPacked<Map_Cosmo>(std::move(content), actorInfo);
 }
 
 SuppFilenames MapType_Cosmo::getRequiredSupps(stream::input& content,
@@ -74,7 +74,7 @@ class Layer_DarkAges_Background: public Map2DCore::LayerCore
 		{
 			// Write the background layer
 			std::vector<uint8_t> bg(DA_LAYER_LEN_BG, DA_DEFAULT_BGTILE);
-			for (auto& i : this->items()) {
+			for (auto& i : this->itemView()) {
 				if ((i.pos.x >= DA_MAP_WIDTH) || (i.pos.y >= DA_MAP_HEIGHT)) {
 					throw stream::error("Layer has tiles outside map boundary!");
 				}
@@ -177,19 +177,22 @@ class Layer_DarkAges_Background: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
-			for (unsigned int i = 0; i <= DA_MAX_VALID_TILECODE; i++) {
-				if (i == DA_DEFAULT_BGTILE) continue;
-
-				Item t;
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i;
-				validItems.push_back(t);
-			}
-			return validItems;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> validItems;
+				for (unsigned int i = 0; i <= DA_MAX_VALID_TILECODE; i++) {
+					if (i == DA_DEFAULT_BGTILE) continue;
+
+					Item t;
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i;
+					validItems.push_back(t);
+				}
+				return validItems;
+			}();
+			return available;
 		}
 };
 
@@ -223,7 +226,7 @@ class Map_DarkAges: public MapCore, public Map2DCore
 
 		virtual void flush()
 		{
-			assert(this->layers().size() == 1);
+			assert(this->v_layers.size() == 1);
 
 			this->content->truncate(DA_LAYER_LEN_BG);
 			this->content->seekp(0, stream::start);
@@ -311,7 +314,7 @@ std::unique_ptr<Map> MapType_DarkAges::create(
 std::unique_ptr<Map> MapType_DarkAges::open(
 	std::unique_ptr<stream::inout> content, SuppData& suppData) const
 {
-	return std::make_unique<Map_DarkAges>(std::move(content));
+	return openPacked<Map_DarkAges>(std::move(content));
 }
 
 SuppFilenames MapType_DarkAges::getRequiredSupps(stream::input& content,
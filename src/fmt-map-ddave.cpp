@@ -82,7 +82,7 @@ class Layer_DDave_Background: public Map2DCore::LayerCore
 		{
 			// Write the background layer
 			std::vector<uint8_t> bg(DD_LAYER_LEN_BG, DD_DEFAULT_BGTILE);
-			for (auto& i : this->items()) {
+			for (auto& i : this->itemView()) {
 				if ((i.pos.x >= DD_MAP_WIDTH) || (i.pos.y >= DD_MAP_HEIGHT)) {
 					throw stream::error("Layer has tiles outside map boundary!");
 				}
@@ -124,19 +124,22 @@ class Layer_DDave_Background: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
-			for (unsigned int i = 0; i <= DD_MAX_VALID_TILECODE; i++) {
-				if (i == DD_DEFAULT_BGTILE) continue;
-
-				Item t;
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i;
-				validItems.push_back(t);
-			}
-			return validItems;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> validItems;
+				for (unsigned int i = 0; i <= DD_MAX_VALID_TILECODE; i++) {
+					if (i == DD_DEFAULT_BGTILE) continue;
+
+					Item t;
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i;
+					validItems.push_back(t);
+				}
+				return validItems;
+			}();
+			return available;
 		}
 };
 
@@ -194,7 +197,7 @@ class Map_DDave: public MapCore, public Map2DCore
 
 		virtual void flush()
 		{
-			assert(this->layers().size() == 1);
+			assert(this->v_layers.size() == 1);
 			assert(this->paths().size() == 1);
 
 			this->content->truncate(DD_LAYER_LEN_PATH + DD_LAYER_LEN_BG + DD_PAD_LEN);
@@ -342,7 +345,7 @@ std::unique_ptr<Map> MapType_DDave::create(
 std::unique_ptr<Map> MapType_DDave::open(
 	std::unique_ptr<stream::inout> content, SuppData& suppData) const
 {
-	return std::make_unique<Map_DDave>(std::move(content));
+	return openPacked<Map_DDave>(std::move(content));
 }
 
 SuppFilenames MapType_DDave::getRequiredSupps(stream::input& content,
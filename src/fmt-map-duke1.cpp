@@ -75,7 +75,7 @@ class Layer_Duke1_Background: public Map2DCore::LayerCore
 		{
 			// Write the background layer
 			std::vector<uint16_t> bg(DN1_LAYER_LEN_BG, DN1_DEFAULT_BGTILE);
-			for (auto& i : this->items()) {
+			for (auto& i : this->itemView()) {
 				if ((i.pos.x >= DN1_MAP_WIDTH) || (i.pos.y >= DN1_MAP_HEIGHT)) {
 					throw stream::error("Layer has tiles outside map boundary!");
 				}
@@ -273,19 +273,22 @@ class Layer_Duke1_Background: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
-			for (unsigned int i = 0; i <= DN1_MAX_VALID_TILECODE; i++) {
-				if (i == DN1_DEFAULT_BGTILE) continue;
-
-				Item t;
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i;
-				validItems.push_back(t);
-			}
-			return validItems;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> validItems;
+				for (unsigned int i = 0; i <= DN1_MAX_VALID_TILECODE; i++) {
+					if (i == DN1_DEFAULT_BGTILE) continue;
+
+					Item t;
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i;
+					validItems.push_back(t);
+				}
+				return validItems;
+			}();
+			return available;
 		}
 
 	private:
@@ -383,7 +386,7 @@ class Map_Duke1: public MapCore, public Map2DCore
 
 		virtual void flush()
 		{
-			assert(this->layers().size() == 1);
+			assert(this->v_layers.size() == 1);
 
 			// Write the background layer
 			auto layerBG = dynamic_cast<Layer_Duke1_Background*>(this->v_layers[0].get());
@@ -473,7 +476,7 @@ std::unique_ptr<Map> MapType_Duke1::create(
 std::unique_ptr<Map> MapType_Duke1::open(
 	std::unique_ptr<stream::inout> content, SuppData& suppData) const
 {
-	return std::make_unique<Map_Duke1>(std::move(content));
+	return openPacked<Map_Duke1>(std::move(content));
 }
 
 SuppFilenames MapType_Duke1::getRequiredSupps(stream::input& content,
@@ -21,7 +21,12 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cstring>
+#include <exception>
+#include <thread>
 #include <camoto/iostream_helpers.hpp>
 #include <camoto/util.hpp> // make_unique
 #include "map-core.hpp"
@@ -90,30 +95,71 @@
 /// Number of screens to draw in the vertical direction
 #define GOT_MAP_SCREENCOUNT_VERT (GOT_MAP_NUMSCREENS / GOT_MAP_SCREENCOUNT_HORIZ)
 
+/// Offset of the background layer within each screen
+#define GOT_OFFSET_BG            0
+
+/// Offset of the actor layer within each screen (after the default tile/song)
+#define GOT_OFFSET_ACTOR        (GOT_OFFSET_BG + GOT_LAYER_LEN_BG + 2)
+
+/// Offset of the object layer within each screen
+#define GOT_OFFSET_OBJECT       (GOT_OFFSET_ACTOR + GOT_LAYER_LEN_ACTOR)
+
 namespace camoto {
 namespace gamemaps {
 
 using namespace camoto::gamegraphics;
 
+/// Is the given position within the screen starting at origin?
+static bool inScreen(const Point& pos, const Point& origin)
+{
+	return
+		(pos.x >= origin.x) && (pos.x < origin.x + GOT_MAP_WIDTH)
+		&& (pos.y >= origin.y) && (pos.y < origin.y + GOT_MAP_HEIGHT)
+	;
+}
+
+/// Items falling within a single screen, in layer order.
+typedef std::vector<const Map2D::Layer::Item *> ScreenItems;
+
+/// Sort a layer's items into the screens they fall within.
+/**
+ * This is done once per layer so each screen only has to look at its own
+ * items, instead of every screen scanning the whole layer.
+ *
+ * @param layer
+ *   Layer to sort.  It must stay unchanged while the result is in use.
+ *
+ * @return One list per screen.  Items outside the world are left out.
+ */
+static std::vector<ScreenItems> itemsByScreen(const Map2D::Layer& layer)
+{
+	std::vector<ScreenItems> screens(GOT_MAP_NUMSCREENS);
+	for (auto& t : layer.itemView()) {
+		if ((t.pos.x < 0) || (t.pos.y < 0)) continue;
+		unsigned int sx = t.pos.x / GOT_MAP_WIDTH;
+		unsigned int sy = t.pos.y / GOT_MAP_HEIGHT;
+		if ((sx >= GOT_MAP_SCREENCOUNT_HORIZ) || (sy >= GOT_MAP_SCREENCOUNT_VERT)) {
+			continue;
+		}
+		screens[sy * GOT_MAP_SCREENCOUNT_HORIZ + sx].push_back(&t);
+	}
+	return screens;
+}
+
 class Layer_GOT_Background: public Map2DCore::LayerCore
 {
 	public:
+		Layer_GOT_Background()
+		{
+		}
+
 		Layer_GOT_Background(stream::input& content)
 		{
-			std::vector<uint8_t> buf(GOT_LAYER_LEN_BG, GOT_DEFAULT_BGTILE);
-			content.read(buf.data(), GOT_LAYER_LEN_BG);
+			uint8_t buf[GOT_LAYER_LEN_BG];
+			content.read(buf, GOT_LAYER_LEN_BG);
 
 			this->v_allItems.reserve(GOT_LAYER_LEN_BG);
-			for (unsigned int i = 0; i < GOT_LAYER_LEN_BG; i++) {
-				if (buf[i] == GOT_DEFAULT_BGTILE) continue;
-
-				this->v_allItems.emplace_back();
-				auto& t = this->v_allItems.back();
-				t.type = Item::Type::Default;
-				t.pos.x = i % GOT_MAP_WIDTH;
-				t.pos.y = i / GOT_MAP_WIDTH;
-				t.code = buf[i];
-			}
+			this->decodeScreen(this->v_allItems, buf, {0, 0});
 		}
 
 		virtual ~Layer_GOT_Background()
@@ -122,14 +168,67 @@ class Layer_GOT_Background: public Map2DCore::LayerCore
 
 		void flush(stream::output& content)
 		{
-			std::vector<uint8_t> buf(GOT_LAYER_LEN_BG, GOT_DEFAULT_BGTILE);
-			for (auto& t : this->items()) {
+			ScreenItems items;
+			for (auto& t : this->itemView()) {
 				if ((t.pos.x >= GOT_MAP_WIDTH) || (t.pos.y >= GOT_MAP_HEIGHT)) {
 					throw stream::error("Layer has tiles outside map boundary!");
 				}
-				buf[t.pos.y * GOT_MAP_WIDTH + t.pos.x] = t.code;
+				if (inScreen(t.pos, {0, 0})) items.push_back(&t);
+			}
+			uint8_t buf[GOT_LAYER_LEN_BG];
+			this->encodeScreen(buf, {0, 0}, items);
+			content.write(buf, GOT_LAYER_LEN_BG);
+			return;
+		}
+
+		/// Add the tiles from one screen's background data to a list.
+		/**
+		 * @param items
+		 *   List to append the tiles to.  This is the layer's own list,
+		 *   or a separate one when screens are decoded in parallel.
+		 *
+		 * @param buf
+		 *   GOT_LAYER_LEN_BG bytes of background data.
+		 *
+		 * @param origin
+		 *   Coordinates of the screen's top-left cell within the layer.
+		 */
+		template <class Items>
+		static void decodeScreen(Items& items, const uint8_t *buf,
+			const Point& origin)
+		{
+			for (unsigned int i = 0; i < GOT_LAYER_LEN_BG; i++) {
+				if (buf[i] == GOT_DEFAULT_BGTILE) continue;
+
+				items.emplace_back();
+				auto& t = items.back();
+				t.type = Item::Type::Default;
+				t.pos.x = origin.x + i % GOT_MAP_WIDTH;
+				t.pos.y = origin.y + i / GOT_MAP_WIDTH;
+				t.code = buf[i];
+			}
+			return;
+		}
+
+		/// Write the tiles within one screen as background data.
+		/**
+		 * @param buf
+		 *   GOT_LAYER_LEN_BG bytes, all of which are overwritten.
+		 *
+		 * @param origin
+		 *   Coordinates of the screen's top-left cell within the layer.
+		 *
+		 * @param items
+		 *   This layer's tiles that fall within the screen.
+		 */
+		void encodeScreen(uint8_t *buf, const Point& origin,
+			const ScreenItems& items) const
+		{
+			memset(buf, GOT_DEFAULT_BGTILE, GOT_LAYER_LEN_BG);
+			for (auto t : items) {
+				assert(inScreen(t->pos, origin));
+				buf[(t->pos.y - origin.y) * GOT_MAP_WIDTH + t->pos.x - origin.x] = t->code;
 			}
-			content.write(buf.data(), GOT_LAYER_LEN_BG);
 			return;
 		}
 
@@ -166,43 +265,39 @@ class Layer_GOT_Background: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
-			for (unsigned int i = 0; i <= GOT_MAX_VALID_BG_TILECODE; i++) {
-				if (i == GOT_DEFAULT_BGTILE) continue;
-
-				validItems.emplace_back();
-				auto& t = validItems.back();
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i;
-			}
-			return validItems;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> validItems;
+				for (unsigned int i = 0; i <= GOT_MAX_VALID_BG_TILECODE; i++) {
+					if (i == GOT_DEFAULT_BGTILE) continue;
+
+					validItems.emplace_back();
+					auto& t = validItems.back();
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i;
+				}
+				return validItems;
+			}();
+			return available;
 		}
 };
 
 class Layer_GOT_Actor: virtual public Map2DCore::LayerCore
 {
 	public:
-		Layer_GOT_Actor(stream::input& content)
+		Layer_GOT_Actor()
 		{
-			std::vector<uint8_t> buf(GOT_LAYER_LEN_ACTOR, GOT_DEFAULT_ACTORTILE);
-			content.read(buf.data(), GOT_LAYER_LEN_ACTOR);
+		}
 
-			this->v_allItems.reserve(GOT_LAYER_LEN_ACTOR);
-			for (unsigned int i = 0; i < GOT_NUM_ACTORS; i++) {
-				if (buf[i] == GOT_DEFAULT_ACTORTILE) continue;
+		Layer_GOT_Actor(stream::input& content)
+		{
+			uint8_t buf[GOT_LAYER_LEN_ACTOR];
+			content.read(buf, GOT_LAYER_LEN_ACTOR);
 
-				this->v_allItems.emplace_back();
-				auto& t = this->v_allItems.back();
-				t.type = Item::Type::Default;
-				t.pos = {
-					buf[16 + i] % GOT_MAP_WIDTH,
-					buf[16 + i] / GOT_MAP_WIDTH
-				};
-				t.code = buf[i] - 1;
-			}
+			this->v_allItems.reserve(GOT_NUM_ACTORS);
+			this->decodeScreen(this->v_allItems, buf, {0, 0});
 		}
 
 		virtual ~Layer_GOT_Actor()
@@ -211,21 +306,85 @@ class Layer_GOT_Actor: virtual public Map2DCore::LayerCore
 
 		void flush(stream::output& content)
 		{
-			for (auto& t : this->items()) {
+			ScreenItems items;
+			for (auto& t : this->itemView()) {
 				if ((t.pos.x >= GOT_MAP_WIDTH) || (t.pos.y >= GOT_MAP_HEIGHT)) {
 					throw stream::error("Layer has tiles outside map boundary!");
 				}
+				if (inScreen(t.pos, {0, 0})) items.push_back(&t);
 			}
-			auto numItems = this->items().size();
-			unsigned int padItems = numItems >= GOT_NUM_ACTORS ? 0 : GOT_NUM_ACTORS - numItems;
-			for (auto& t : this->items()) content << u8(t.code + 1);
-			content << nullPadded("", padItems); // pad out to 16 bytes
-			for (auto& t : this->items()) content << u8(t.pos.y * GOT_MAP_WIDTH + t.pos.x);
-			content << nullPadded("", padItems); // pad out to 16 bytes
-
-			// Padding, this data is unknown
+			// The last 48 bytes are unknown, so write them as zero
 /// @todo Work out what this data is used for
-			content << nullPadded("", 16*3);
+			uint8_t buf[GOT_LAYER_LEN_ACTOR];
+			memset(buf, 0, GOT_LAYER_LEN_ACTOR);
+			this->encodeScreen(buf, {0, 0}, items);
+			content.write(buf, GOT_LAYER_LEN_ACTOR);
+			return;
+		}
+
+		/// Add the actors from one screen's actor data to a list.
+		/**
+		 * @param items
+		 *   List to append the actors to.  This is the layer's own list,
+		 *   or a separate one when screens are decoded in parallel.
+		 *
+		 * @param buf
+		 *   GOT_LAYER_LEN_ACTOR bytes of actor data.
+		 *
+		 * @param origin
+		 *   Coordinates of the screen's top-left cell within the layer.
+		 */
+		template <class Items>
+		static void decodeScreen(Items& items, const uint8_t *buf,
+			const Point& origin)
+		{
+			for (unsigned int i = 0; i < GOT_NUM_ACTORS; i++) {
+				if (buf[i] == GOT_DEFAULT_ACTORTILE) continue;
+
+				items.emplace_back();
+				auto& t = items.back();
+				t.type = Item::Type::Default;
+				t.pos = {
+					origin.x + buf[16 + i] % GOT_MAP_WIDTH,
+					origin.y + buf[16 + i] / GOT_MAP_WIDTH
+				};
+				t.code = buf[i] - 1;
+			}
+			return;
+		}
+
+		/// Write the actors within one screen as actor data.
+		/**
+		 * Only the actor codes and positions are written.  The rest of the
+		 * block is left as-is, as its purpose is unknown.
+		 *
+		 * @param buf
+		 *   GOT_LAYER_LEN_ACTOR bytes of actor data to update.
+		 *
+		 * @param origin
+		 *   Coordinates of the screen's top-left cell within the layer.
+		 *
+		 * @param items
+		 *   This layer's actors that fall within the screen.
+		 *
+		 * @throw stream::error
+		 *   There are more than GOT_NUM_ACTORS actors on the screen.
+		 */
+		void encodeScreen(uint8_t *buf, const Point& origin,
+			const ScreenItems& items) const
+		{
+			if (items.size() > GOT_NUM_ACTORS) {
+				throw stream::error(createString("There can only be "
+					<< GOT_NUM_ACTORS << " actors on each screen."));
+			}
+			memset(buf, 0, GOT_NUM_ACTORS * 2);
+			unsigned int i = 0;
+			for (auto t : items) {
+				assert(inScreen(t->pos, origin));
+				buf[i] = t->code + 1;
+				buf[16 + i] = (t->pos.y - origin.y) * GOT_MAP_WIDTH + t->pos.x - origin.x;
+				i++;
+			}
 			return;
 		}
 
@@ -269,43 +428,39 @@ class Layer_GOT_Actor: virtual public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
-			for (unsigned int i = 0; i <= GOT_MAX_VALID_ACTOR_TILECODE; i++) {
-				if (i == GOT_DEFAULT_ACTORTILE) continue;
-
-				validItems.emplace_back();
-				auto& t = validItems.back();
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i;
-			}
-			return validItems;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> validItems;
+				for (unsigned int i = 0; i <= GOT_MAX_VALID_ACTOR_TILECODE; i++) {
+					if (i == GOT_DEFAULT_ACTORTILE) continue;
+
+					validItems.emplace_back();
+					auto& t = validItems.back();
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i;
+				}
+				return validItems;
+			}();
+			return available;
 		}
 };
 
 class Layer_GOT_Object: virtual public Map2DCore::LayerCore
 {
 	public:
-		Layer_GOT_Object(stream::input& content)
+		Layer_GOT_Object()
 		{
-			std::vector<uint8_t> buf(GOT_LAYER_LEN_OBJECT, GOT_DEFAULT_OBJTILE);
-			content.read(buf.data(), GOT_LAYER_LEN_OBJECT);
+		}
 
-			this->v_allItems.reserve(GOT_LAYER_LEN_OBJECT);
-			for (unsigned int i = 0; i < GOT_NUM_OBJECTS; i++) {
-				if (buf[i] == GOT_DEFAULT_OBJTILE) continue;
+		Layer_GOT_Object(stream::input& content)
+		{
+			uint8_t buf[GOT_LAYER_LEN_OBJECT];
+			content.read(buf, GOT_LAYER_LEN_OBJECT);
 
-				this->v_allItems.emplace_back();
-				auto& t = this->v_allItems.back();
-				t.type = Item::Type::Default;
-				t.pos = {
-					buf[30 + i * 2] | (buf[30 + i * 2 + 1] << 8),
-					buf[90 + i * 2] | (buf[90 + i * 2 + 1] << 8)
-				};
-				t.code = buf[i] - 1;
-			}
+			this->v_allItems.reserve(GOT_NUM_OBJECTS);
+			this->decodeScreen(this->v_allItems, buf, {0, 0});
 		}
 
 		virtual ~Layer_GOT_Object()
@@ -314,19 +469,84 @@ class Layer_GOT_Object: virtual public Map2DCore::LayerCore
 
 		void flush(stream::output& content)
 		{
-			for (auto& t : this->items()) {
+			ScreenItems items;
+			for (auto& t : this->itemView()) {
 				if ((t.pos.x >= GOT_MAP_WIDTH) || (t.pos.y >= GOT_MAP_HEIGHT)) {
 					throw stream::error("Layer has tiles outside map boundary!");
 				}
+				if (inScreen(t.pos, {0, 0})) items.push_back(&t);
+			}
+			uint8_t buf[GOT_LAYER_LEN_OBJECT];
+			this->encodeScreen(buf, {0, 0}, items);
+			content.write(buf, GOT_LAYER_LEN_OBJECT);
+			return;
+		}
+
+		/// Add the objects from one screen's object data to a list.
+		/**
+		 * @param items
+		 *   List to append the objects to.  This is the layer's own list,
+		 *   or a separate one when screens are decoded in parallel.
+		 *
+		 * @param buf
+		 *   GOT_LAYER_LEN_OBJECT bytes of object data.
+		 *
+		 * @param origin
+		 *   Coordinates of the screen's top-left cell within the layer.
+		 */
+		template <class Items>
+		static void decodeScreen(Items& items, const uint8_t *buf,
+			const Point& origin)
+		{
+			for (unsigned int i = 0; i < GOT_NUM_OBJECTS; i++) {
+				if (buf[i] == GOT_DEFAULT_OBJTILE) continue;
+
+				items.emplace_back();
+				auto& t = items.back();
+				t.type = Item::Type::Default;
+				t.pos = {
+					origin.x + (buf[30 + i * 2] | (buf[30 + i * 2 + 1] << 8)),
+					origin.y + (buf[90 + i * 2] | (buf[90 + i * 2 + 1] << 8))
+				};
+				t.code = buf[i] - 1;
+			}
+			return;
+		}
+
+		/// Write the objects within one screen as object data.
+		/**
+		 * @param buf
+		 *   GOT_LAYER_LEN_OBJECT bytes, all of which are overwritten.
+		 *
+		 * @param origin
+		 *   Coordinates of the screen's top-left cell within the layer.
+		 *
+		 * @param items
+		 *   This layer's objects that fall within the screen.
+		 *
+		 * @throw stream::error
+		 *   There are more than GOT_NUM_OBJECTS objects on the screen.
+		 */
+		void encodeScreen(uint8_t *buf, const Point& origin,
+			const ScreenItems& items) const
+		{
+			if (items.size() > GOT_NUM_OBJECTS) {
+				throw stream::error(createString("There can only be "
+					<< GOT_NUM_OBJECTS << " objects on each screen."));
+			}
+			memset(buf, 0, GOT_LAYER_LEN_OBJECT);
+			unsigned int i = 0;
+			for (auto t : items) {
+				assert(inScreen(t->pos, origin));
+				unsigned int x = t->pos.x - origin.x;
+				unsigned int y = t->pos.y - origin.y;
+				buf[i] = t->code + 1;
+				buf[30 + i * 2] = x & 0xFF;
+				buf[30 + i * 2 + 1] = x >> 8;
+				buf[90 + i * 2] = y & 0xFF;
+				buf[90 + i * 2 + 1] = y >> 8;
+				i++;
 			}
-			auto numItems = this->items().size();
-			unsigned int padItems = numItems >= GOT_NUM_OBJECTS ? 0 : GOT_NUM_OBJECTS - numItems;
-			for (auto& t : this->items()) content << u8(t.code + 1);
-			content << nullPadded("", padItems);
-			for (auto& t : this->items()) content << u16le(t.pos.x);
-			content << nullPadded("", padItems * 2);
-			for (auto& t : this->items()) content << u16le(t.pos.y);
-			content << nullPadded("", padItems * 2);
 			return;
 		}
 
@@ -362,22 +582,89 @@ class Layer_GOT_Object: virtual public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
-			for (unsigned int i = 0; i <= GOT_MAX_VALID_OBJ_TILECODE; i++) {
-				if (i == GOT_DEFAULT_OBJTILE) continue;
-
-				validItems.emplace_back();
-				auto& t = validItems.back();
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i;
-			}
-			return validItems;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> validItems;
+				for (unsigned int i = 0; i <= GOT_MAX_VALID_OBJ_TILECODE; i++) {
+					if (i == GOT_DEFAULT_OBJTILE) continue;
+
+					validItems.emplace_back();
+					auto& t = validItems.back();
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i;
+				}
+				return validItems;
+			}();
+			return available;
 		}
 };
 
+/// Attribute names, descriptions and limits for GOT maps.
+/**
+ * Built once on first use.  Map_GOT shares it and only keeps the values read
+ * from the file.
+ */
+static const std::vector<Attribute>& attributeSchemaGOT()
+{
+	static const std::vector<Attribute> schema = []() -> std::vector<Attribute> {
+		std::vector<Attribute> attrs;
+
+		attrs.emplace_back();
+		auto& attrBGTile = attrs.back();
+		attrBGTile.type = Attribute::Type::Enum;
+		attrBGTile.name = "Background";
+		attrBGTile.desc = "Default background tile to display behind level.";
+		attrBGTile.enumValueNames = {
+/// @todo Tile list
+			"0 - todo: tile list",
+			"1 - todo: tile list",
+		};
+
+		attrs.emplace_back();
+		auto& attrMusic = attrs.back();
+		attrMusic.type = Attribute::Type::Enum;
+		attrMusic.name = "Music";
+		attrMusic.desc = "Index of the song to play as background music in the level.";
+		attrMusic.enumValueNames = {
+/// @todo Song list
+			"0 - song1?",
+			"1 - ?",
+			"2 - todo",
+			"3 - etc",
+		};
+
+		for (int i = 0; i < 10; i++) {
+			attrs.emplace_back();
+			auto& attrHoleScreen = attrs.back();
+			attrHoleScreen.type = Attribute::Type::Integer;
+			attrHoleScreen.name = createString("Hole/ladder " << i << " target");
+			attrHoleScreen.desc = "Screen number of hole/ladder destination.";
+			attrHoleScreen.integerMinValue = 0;
+			attrHoleScreen.integerMaxValue = GOT_MAP_NUMSCREENS - 1;
+
+			attrs.emplace_back();
+			auto& attrHolePosX = attrs.back();
+			attrHolePosX.type = Attribute::Type::Integer;
+			attrHolePosX.name = createString("Hole/ladder " << i << " target X");
+			attrHolePosX.desc = "Player X coordinate on destination screen, after exiting hole/ladder.";
+			attrHolePosX.integerMinValue = 0;
+			attrHolePosX.integerMaxValue = GOT_MAP_WIDTH - 1;
+
+			attrs.emplace_back();
+			auto& attrHolePosY = attrs.back();
+			attrHolePosY.type = Attribute::Type::Integer;
+			attrHolePosY.name = createString("Hole/ladder " << i << " target Y");
+			attrHolePosY.desc = "Player Y coordinate on destination screen, after exiting hole/ladder.";
+			attrHolePosY.integerMinValue = 0;
+			attrHolePosY.integerMaxValue = GOT_MAP_HEIGHT - 1;
+		}
+		return attrs;
+	}();
+	return schema;
+}
+
 class Map_GOT: public MapCore, public Map2DCore
 {
 	public:
@@ -397,31 +684,6 @@ class Map_GOT: public MapCore, public Map2DCore
 				>> u8(defaultSong)
 			;
 
-			this->v_attributes.emplace_back();
-			auto& attrBGTile = this->v_attributes.back();
-			attrBGTile.type = Attribute::Type::Enum;
-			attrBGTile.name = "Background";
-			attrBGTile.desc = "Default background tile to display behind level.";
-			attrBGTile.enumValue = defaultTileBG;
-			attrBGTile.enumValueNames = {
-/// @todo Tile list
-				"0 - todo: tile list",
-				"1 - todo: tile list",
-			};
-
-			this->v_attributes.emplace_back();
-			auto& attrMusic = this->v_attributes.back();
-			attrMusic.type = Attribute::Type::Enum;
-			attrMusic.name = "Music";
-			attrMusic.desc = "Index of the song to play as background music in the level.";
-			attrMusic.enumValue = defaultSong;
-			attrMusic.enumValueNames = {
-/// @todo Song list
-				"0 - song1?",
-				"1 - ?",
-				"2 - todo",
-				"3 - etc",
-			};
 
 			// Read the actor layer
 			this->v_layers.push_back(
@@ -434,37 +696,18 @@ class Map_GOT: public MapCore, public Map2DCore
 			);
 
 			// Read the hole/ladder details
-			uint8_t holeScr[10], holePos[10];
-			this->content->read(holeScr, 10);
-			this->content->read(holePos, 10);
+			std::array<uint8_t, 10> holeScr, holePos;
+			this->content->read(holeScr.data(), 10);
+			this->content->read(holePos.data(), 10);
 
+			this->attributesFromSchema(attributeSchemaGOT());
+			this->attributeValue(0, defaultTileBG);
+			this->attributeValue(1, defaultSong);
 			for (int i = 0; i < 10; i++) {
-				this->v_attributes.emplace_back();
-				auto& attrHoleScreen = this->v_attributes.back();
-				attrHoleScreen.type = Attribute::Type::Integer;
-				attrHoleScreen.name = createString("Hole/ladder " << i << " target");
-				attrHoleScreen.desc = "Screen number of hole/ladder destination.";
-				attrHoleScreen.integerValue = holeScr[i];
-				attrHoleScreen.integerMinValue = 0;
-				attrHoleScreen.integerMaxValue = GOT_MAP_NUMSCREENS - 1;
-
-				this->v_attributes.emplace_back();
-				auto& attrHolePosX = this->v_attributes.back();
-				attrHolePosX.type = Attribute::Type::Integer;
-				attrHolePosX.name = createString("Hole/ladder " << i << " target X");
-				attrHolePosX.desc = "Player X coordinate on destination screen, after exiting hole/ladder.";
-				attrHolePosX.integerValue = holePos[i] % GOT_MAP_WIDTH;
-				attrHolePosX.integerMinValue = 0;
-				attrHolePosX.integerMaxValue = GOT_MAP_WIDTH - 1;
-
-				this->v_attributes.emplace_back();
-				auto& attrHolePosY = this->v_attributes.back();
-				attrHolePosY.type = Attribute::Type::Integer;
-				attrHolePosY.name = createString("Hole/ladder " << i << " target Y");
-				attrHolePosY.desc = "Player Y coordinate on destination screen, after exiting hole/ladder.";
-				attrHolePosY.integerValue = holePos[i] / GOT_MAP_WIDTH;
-				attrHolePosY.integerMinValue = 0;
-				attrHolePosY.integerMaxValue = GOT_MAP_HEIGHT - 1;
+				int attBase = 2 + i * 3;
+				this->attributeValue(attBase + 0, holeScr[i]);
+				this->attributeValue(attBase + 1, holePos[i] % GOT_MAP_WIDTH);
+				this->attributeValue(attBase + 2, holePos[i] / GOT_MAP_WIDTH);
 			}
 		}
 
@@ -481,8 +724,7 @@ class Map_GOT: public MapCore, public Map2DCore
 
 		virtual void flush()
 		{
-			assert(this->layers().size() == 3);
-			assert(this->v_attributes.size() == 2 + 10*3);
+			assert(this->v_layers.size() == 3);
 
 			this->content->truncate(GOT_MAP_LEN);
 			this->content->seekp(0, stream::start);
@@ -492,8 +734,8 @@ class Map_GOT: public MapCore, public Map2DCore
 			layerBG->flush(*this->content);
 
 			*this->content
-				<< u8(this->v_attributes[0].enumValue)
-				<< u8(this->v_attributes[1].enumValue)
+				<< u8(this->attributeNumber(0))
+				<< u8(this->attributeNumber(1))
 			;
 
 			// Write the actor layer
@@ -508,9 +750,9 @@ class Map_GOT: public MapCore, public Map2DCore
 			uint8_t holeScr[10], holePos[10];
 			for (int i = 0; i < 10; i++) {
 				int attBase = 2 + i * 3;
-				holeScr[i] = this->v_attributes[attBase + 0].integerValue;
-				holePos[i] = this->v_attributes[attBase + 2].integerValue * GOT_MAP_WIDTH
-					+ this->v_attributes[attBase + 1].integerValue;
+				holeScr[i] = this->attributeNumber(attBase + 0);
+				holePos[i] = this->attributeNumber(attBase + 2) * GOT_MAP_WIDTH
+					+ this->attributeNumber(attBase + 1);
 			}
 			this->content->write(holeScr, 10);
 			this->content->write(holePos, 10);
@@ -560,6 +802,242 @@ class Map_GOT: public MapCore, public Map2DCore
 		uint8_t defaultSong;
 };
 
+/// All the screens in a God of Thunder episode, shown as one large map.
+/**
+ * The screens are laid out GOT_MAP_SCREENCOUNT_HORIZ across, in the order
+ * they appear in the file.  Only the layers are available, as the other
+ * per-screen values (default tile, music and hole/ladder targets) can't be
+ * represented as attributes of the whole map.  These values are left
+ * untouched when the map is saved.
+ */
+class Map_GOTWorld: public MapCore, public Map2DCore
+{
+	public:
+		Map_GOTWorld(std::unique_ptr<stream::inout> content)
+			:	content(std::move(content))
+		{
+			// Read all the screens in one go.  A copy is kept so that only the
+			// screens that have changed need to be written out again.
+			this->screens.resize(GOT_MAP_LEN * GOT_MAP_NUMSCREENS);
+			this->content->seekg(0, stream::start);
+			this->content->read(this->screens.data(), this->screens.size());
+
+			// Each thread decodes a band of whole screen rows into its own lists,
+			// which are then joined in band order.
+			unsigned int threads = std::thread::hardware_concurrency();
+			if (threads == 0) threads = 1;
+			if (threads > GOT_MAP_SCREENCOUNT_VERT) threads = GOT_MAP_SCREENCOUNT_VERT;
+
+			struct Band {
+				std::vector<Map2D::Layer::Item> bg, ac, ob;
+				std::exception_ptr error;
+			};
+			std::vector<Band> bands(threads);
+			auto decodeBand = [&](unsigned int b) {
+				auto& band = bands[b];
+				try {
+					unsigned int first = GOT_MAP_SCREENCOUNT_VERT * b / threads;
+					unsigned int last = GOT_MAP_SCREENCOUNT_VERT * (b + 1) / threads;
+					for (unsigned int i = first * GOT_MAP_SCREENCOUNT_HORIZ;
+						i < last * GOT_MAP_SCREENCOUNT_HORIZ; i++
+					) {
+						const uint8_t *screen = &this->screens[i * GOT_MAP_LEN];
+						auto origin = this->screenOrigin(i);
+						Layer_GOT_Background::decodeScreen(band.bg,
+							screen + GOT_OFFSET_BG, origin);
+						Layer_GOT_Actor::decodeScreen(band.ac,
+							screen + GOT_OFFSET_ACTOR, origin);
+						Layer_GOT_Object::decodeScreen(band.ob,
+							screen + GOT_OFFSET_OBJECT, origin);
+					}
+					// Put the background in row-major order across the whole band, so
+					// once joined the layer can be packed.  The actors and objects
+					// keep their file order, as that sets their slot on each screen.
+					std::sort(band.bg.begin(), band.bg.end(),
+						[](const Map2D::Layer::Item& a, const Map2D::Layer::Item& b) {
+							return (a.pos.y < b.pos.y)
+								|| ((a.pos.y == b.pos.y) && (a.pos.x < b.pos.x));
+						}
+					);
+				} catch (...) {
+					band.error = std::current_exception();
+				}
+			};
+
+			std::vector<std::thread> pool;
+			for (unsigned int b = 1; b < threads; b++) pool.emplace_back(decodeBand, b);
+			decodeBand(0); // this thread does the first band
+			for (auto& t : pool) t.join();
+
+			// The lists are built here rather than in the workers, so they come
+			// from this thread's arena.
+			std::size_t countBG = 0, countAC = 0, countOB = 0;
+			for (auto& band : bands) {
+				if (band.error) std::rethrow_exception(band.error);
+				countBG += band.bg.size();
+				countAC += band.ac.size();
+				countOB += band.ob.size();
+			}
+			SharedItems itemsBG, itemsAC, itemsOB;
+			itemsBG.reserve(countBG);
+			itemsAC.reserve(countAC);
+			itemsOB.reserve(countOB);
+			for (auto& band : bands) {
+				for (auto& t : band.bg) itemsBG.push_back(t);
+				for (auto& t : band.ac) itemsAC.push_back(t);
+				for (auto& t : band.ob) itemsOB.push_back(t);
+			}
+
+			auto layerBG = std::make_shared<Layer_GOT_Background>();
+			auto layerAC = std::make_shared<Layer_GOT_Actor>();
+			auto layerOB = std::make_shared<Layer_GOT_Object>();
+			layerBG->sharedItems(itemsBG);
+			layerAC->sharedItems(itemsAC);
+			layerOB->sharedItems(itemsOB);
+			this->v_layers.push_back(layerBG);
+			this->v_layers.push_back(layerAC);
+			this->v_layers.push_back(layerOB);
+		}
+
+		virtual ~Map_GOTWorld()
+		{
+		}
+
+		virtual std::map<ImagePurpose, GraphicsFilename> graphicsFilenames() const
+		{
+			// Graphics filenames aren't stored in the map file, so we can't return
+			// anything here, they'll have to be supplied manually.
+			return {};
+		}
+
+		virtual void flush()
+		{
+			assert(this->v_layers.size() == 3);
+
+			auto layerBG = dynamic_cast<Layer_GOT_Background*>(this->v_layers[0].get());
+			auto layerAC = dynamic_cast<Layer_GOT_Actor*>(this->v_layers[1].get());
+			auto layerOB = dynamic_cast<Layer_GOT_Object*>(this->v_layers[2].get());
+
+			auto size = this->mapSize();
+			for (auto& l : this->v_layers) {
+				for (auto& t : l->itemView()) {
+					if ((t.pos.x >= size.x) || (t.pos.y >= size.y)) {
+						throw stream::error("Layer has tiles outside map boundary!");
+					}
+				}
+			}
+
+			// If the file has been truncated or replaced, the copy no longer matches
+			// what's there, so every screen must be written.
+			bool writeAll = this->content->size() != this->screens.size();
+
+			auto itemsBG = itemsByScreen(*layerBG);
+			auto itemsAC = itemsByScreen(*layerAC);
+			auto itemsOB = itemsByScreen(*layerOB);
+
+			uint8_t screen[GOT_MAP_LEN];
+			for (unsigned int i = 0; i < GOT_MAP_NUMSCREENS; i++) {
+				uint8_t *orig = &this->screens[i * GOT_MAP_LEN];
+				auto origin = this->screenOrigin(i);
+				memcpy(screen, orig, GOT_MAP_LEN);
+				layerBG->encodeScreen(screen + GOT_OFFSET_BG, origin, itemsBG[i]);
+				layerAC->encodeScreen(screen + GOT_OFFSET_ACTOR, origin, itemsAC[i]);
+				layerOB->encodeScreen(screen + GOT_OFFSET_OBJECT, origin, itemsOB[i]);
+
+				// Skip any screens that haven't changed since they were last written
+				if (!writeAll && (memcmp(screen, orig, GOT_MAP_LEN) == 0)) continue;
+
+				this->content->seekp(i * GOT_MAP_LEN, stream::start);
+				this->content->write(screen, GOT_MAP_LEN);
+				memcpy(orig, screen, GOT_MAP_LEN);
+			}
+
+			this->content->flush();
+			return;
+		}
+
+		virtual Caps caps() const
+		{
+			return
+				Map2D::Caps::HasViewport
+				| Map2D::Caps::HasMapSize
+				| Map2D::Caps::HasTileSize
+			;
+		}
+
+		virtual Point viewport() const
+		{
+			return {320, 192};
+		}
+
+		virtual Point mapSize() const
+		{
+			return {
+				GOT_MAP_WIDTH * GOT_MAP_SCREENCOUNT_HORIZ,
+				GOT_MAP_HEIGHT * GOT_MAP_SCREENCOUNT_VERT
+			};
+		}
+
+		virtual Point tileSize() const
+		{
+			return {GOT_TILE_WIDTH, GOT_TILE_HEIGHT};
+		}
+
+		Background background(const TilesetCollection& tileset) const
+		{
+			// Each screen has its own default tile, so use the tile that is left
+			// out of the background layer instead.
+			return this->backgroundFromTilecode(tileset, GOT_DEFAULT_BGTILE);
+		}
+
+	private:
+		std::unique_ptr<stream::inout> content;
+
+		/// Raw data for every screen, as last read from or written to the file
+		std::vector<uint8_t> screens;
+
+		/// Coordinates of the top-left cell of the given screen.
+		Point screenOrigin(unsigned int index) const
+		{
+			return {
+				(index % GOT_MAP_SCREENCOUNT_HORIZ) * GOT_MAP_WIDTH,
+				(index / GOT_MAP_SCREENCOUNT_HORIZ) * GOT_MAP_HEIGHT
+			};
+		}
+};
+
+/// Check that the layer codes in one screen are all within range.
+/**
+ * @param screen
+ *   GOT_MAP_LEN bytes of screen data.
+ *
+ * @return true if the screen is valid, false if not.
+ */
+static bool isValidScreen(const uint8_t *screen)
+{
+	const uint8_t *bg = screen + GOT_OFFSET_BG;
+	for (int i = 0; i < GOT_LAYER_LEN_BG; i++) {
+		// Background layer code out of range
+		// TESTED BY: fmt_map_got_isinstance_c02
+		if (bg[i] > GOT_MAX_VALID_BG_TILECODE) return false;
+	}
+
+	const uint8_t *ac = screen + GOT_OFFSET_ACTOR;
+	for (int i = 0; i < GOT_NUM_ACTORS; i++) {
+		// Actor layer code out of range
+		// TESTED BY: fmt_map_got_isinstance_c03
+		if (ac[i] > GOT_MAX_VALID_ACTOR_TILECODE) return false;
+	}
+
+	const uint8_t *ob = screen + GOT_OFFSET_OBJECT;
+	for (int i = 0; i < GOT_NUM_OBJECTS; i++) {
+		// Object layer code out of range
+		// TESTED BY: fmt_map_got_isinstance_c04
+		if (ob[i] > GOT_MAX_VALID_OBJ_TILECODE) return false;
+	}
+	return true;
+}
+
 
 std::string MapType_GOT::code() const
 {
@@ -589,31 +1067,10 @@ MapType::Certainty MapType_GOT::isInstance(stream::input& content) const
 	// TESTED BY: fmt_map_got_isinstance_c01
 	if (lenMap != GOT_MAP_LEN) return MapType::DefinitelyNo;
 
+	uint8_t screen[GOT_MAP_LEN];
 	content.seekg(0, stream::start);
-	uint8_t bg[GOT_LAYER_LEN_BG];
-	content.read(bg, GOT_LAYER_LEN_BG);
-	for (int i = 0; i < GOT_LAYER_LEN_BG; i++) {
-		// Background layer code out of range
-		// TESTED BY: fmt_map_got_isinstance_c02
-		if (bg[i] > GOT_MAX_VALID_BG_TILECODE) return MapType::DefinitelyNo;
-	}
-	content.seekg(2, stream::cur);
-
-	uint8_t ac[GOT_LAYER_LEN_ACTOR];
-	content.read(ac, GOT_LAYER_LEN_ACTOR);
-	for (int i = 0; i < GOT_NUM_ACTORS; i++) {
-		// Actor layer code out of range
-		// TESTED BY: fmt_map_got_isinstance_c03
-		if (ac[i] > GOT_MAX_VALID_ACTOR_TILECODE) return MapType::DefinitelyNo;
-	}
-
-	uint8_t ob[GOT_LAYER_LEN_OBJECT];
-	content.read(ob, GOT_LAYER_LEN_OBJECT);
-	for (int i = 0; i < GOT_NUM_OBJECTS; i++) {
-		// Object layer code out of range
-		// TESTED BY: fmt_map_got_isinstance_c04
-		if (ob[i] > GOT_MAX_VALID_OBJ_TILECODE) return MapType::DefinitelyNo;
-	}
+	content.read(screen, GOT_MAP_LEN);
+	if (!isValidScreen(screen)) return MapType::DefinitelyNo;
 
 	// TESTED BY: fmt_map_got_isinstance_c00
 	return MapType::DefinitelyYes;
@@ -629,7 +1086,7 @@ std::unique_ptr<Map> MapType_GOT::create(
 std::unique_ptr<Map> MapType_GOT::open(
 	std::unique_ptr<stream::inout> content, SuppData& suppData) const
 {
-	return std::make_unique<Map_GOT>(std::move(content));
+	return openPacked<Map_GOT>(std::move(content));
 }
 
 SuppFilenames MapType_GOT::getRequiredSupps(stream::input& content,
@@ -638,5 +1095,55 @@ SuppFilenames MapType_GOT::getRequiredSupps(stream::input& content,
 	return {};
 }
 
+
+std::string MapType_GOTWorld::code() const
+{
+	return "map2d-got-world";
+}
+
+std::string MapType_GOTWorld::friendlyName() const
+{
+	return "God of Thunder world";
+}
+
+MapType::Certainty MapType_GOTWorld::isInstance(stream::input& content) const
+{
+	stream::pos lenMap = content.size();
+
+	// Must be exactly one episode's worth of screens
+	// TESTED BY: fmt_map_got_world_isinstance_c01
+	if (lenMap != GOT_MAP_LEN * GOT_MAP_NUMSCREENS) return MapType::DefinitelyNo;
+
+	std::vector<uint8_t> screens(lenMap);
+	content.seekg(0, stream::start);
+	content.read(screens.data(), lenMap);
+	for (unsigned int i = 0; i < GOT_MAP_NUMSCREENS; i++) {
+		// TESTED BY: fmt_map_got_world_isinstance_c02
+		if (!isValidScreen(&screens[i * GOT_MAP_LEN])) return MapType::DefinitelyNo;
+	}
+
+	// TESTED BY: fmt_map_got_world_isinstance_c00
+	return MapType::DefinitelyYes;
+}
+
+std::unique_ptr<Map> MapType_GOTWorld::create(
+	std::unique_ptr<stream::inout> content, SuppData& suppData) const
+{
+	// TODO: Implement
+	throw stream::error("Not implemented yet!");
+}
+
+std::unique_ptr<Map> MapType_GOTWorld::open(
+	std::unique_ptr<stream::inout> content, SuppData& suppData) const
+{
+	return openPacked<Map_GOTWorld>(std::move(content));
+}
+
+SuppFilenames MapType_GOTWorld::getRequiredSupps(stream::input& content,
+	const std::string& filename) const
+{
+	return {};
+}
+
 } // namespace gamemaps
 } // namespace camoto
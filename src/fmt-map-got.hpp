@@ -43,6 +43,21 @@ class MapType_GOT: virtual public MapType
 			const std::string& filename) const;
 };
 
+/// God of Thunder reader/writer for every screen in an episode at once.
+class MapType_GOTWorld: virtual public MapType_GOT
+{
+	public:
+		virtual std::string code() const;
+		virtual std::string friendlyName() const;
+		virtual Certainty isInstance(stream::input& content) const;
+		virtual std::unique_ptr<Map> create(std::unique_ptr<stream::inout> content,
+			SuppData& suppData) const;
+		virtual std::unique_ptr<Map> open(std::unique_ptr<stream::inout> content,
+			SuppData& suppData) const;
+		virtual SuppFilenames getRequiredSupps(stream::input& content,
+			const std::string& filename) const;
+};
+
 } // namespace gamemaps
 } // namespace camoto
 
@@ -99,7 +99,7 @@ class Layer_Harry_Actor: public Map2DCore::LayerCore
 
 		void flush(stream::output& content, const Point& dims)
 		{
-			auto actors = this->items();
+			auto actors = this->itemView();
 			// There will be an actor for the player start point, but we don't want to
 			// write that as that goes in the map format's player-start-point fields.
 			unsigned int numActors = actors.size() - 1;
@@ -163,17 +163,20 @@ class Layer_Harry_Actor: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
-			for (unsigned int i = 0; i <= HH_MAX_VALID_TILECODE_ACTOR; i++) {
-				validItems.emplace_back();
-				auto& t = validItems.back();
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i;
-			}
-			return validItems;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> validItems;
+				for (unsigned int i = 0; i <= HH_MAX_VALID_TILECODE_ACTOR; i++) {
+					validItems.emplace_back();
+					auto& t = validItems.back();
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i;
+				}
+				return validItems;
+			}();
+			return available;
 		}
 };
 
@@ -207,7 +210,7 @@ class Layer_Harry_Background: public Map2DCore::LayerCore
 		void flush(stream::output& content, const Point& dims)
 		{
 			std::vector<uint8_t> buf(dims.x * dims.y, HH_DEFAULT_TILE);
-			for (auto& t : this->items()) {
+			for (auto& t : this->itemView()) {
 				if ((t.pos.x >= dims.x) || (t.pos.y >= dims.y)) {
 					throw stream::error("Layer has tiles outside map boundary!");
 				}
@@ -249,19 +252,22 @@ class Layer_Harry_Background: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
-			for (unsigned int i = 0; i <= HH_MAX_VALID_TILECODE_BG; i++) {
-				if (i == HH_DEFAULT_TILE) continue;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> validItems;
+				for (unsigned int i = 0; i <= HH_MAX_VALID_TILECODE_BG; i++) {
+					if (i == HH_DEFAULT_TILE) continue;
 
-				validItems.emplace_back();
-				auto& t = validItems.back();
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i;
-			}
-			return validItems;
+					validItems.emplace_back();
+					auto& t = validItems.back();
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i;
+				}
+				return validItems;
+			}();
+			return available;
 		}
 };
 
@@ -358,7 +364,7 @@ class Map_Harry: public MapCore, public Map2DCore
 
 		virtual void flush()
 		{
-			assert(this->layers().size() == 3);
+			assert(this->v_layers.size() == 3);
 			assert(this->v_attributes.size() == 1);
 
 			auto dims = this->mapSize();
@@ -369,7 +375,7 @@ class Map_Harry: public MapCore, public Map2DCore
 				+ 256 // tile flags
 				+  10 // unknown
 				+   2 // num actors
-				+ (this->layers().at(2)->items().size() - 1) * HH_ACTOR_LEN
+				+ (this->v_layers[2]->itemView().size() - 1) * HH_ACTOR_LEN
 				+ 4 // map size
 				+ dims.x * dims.y * 2 // bg + fg layer
 			);
@@ -378,8 +384,7 @@ class Map_Harry: public MapCore, public Map2DCore
 			// Find the player-start-point objects
 			uint16_t startX = 0, startY = 0;
 			bool setPlayer = false;
-			auto layer = this->layers().at(2);
-			auto actors = layer->items();
+			auto actors = this->v_layers[2]->itemView();
 			uint16_t numActors = (uint16_t)actors.size();
 			for (auto& t : actors) {
 				if (t.type & Layer::Item::Type::Player) {
@@ -573,7 +578,7 @@ std::unique_ptr<Map> MapType_Harry::create(
 std::unique_ptr<Map> MapType_Harry::open(
 	std::unique_ptr<stream::inout> content, SuppData& suppData) const
 {
-	return std::make_unique<Map_Harry>(std::move(content));
+	return openPacked<Map_Harry>(std::move(content));
 }
 
 SuppFilenames MapType_Harry::getRequiredSupps(stream::input& content,
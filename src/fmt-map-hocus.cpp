@@ -85,7 +85,7 @@ class Layer_Hocus_8bit: public Map2DCore::LayerCore
 		{
 			// Write the background layer
 			std::vector<uint8_t> bg(HP_MAP_SIZE, HP_DEFAULT_TILE);
-			for (auto& i : this->items()) {
+			for (auto& i : this->itemView()) {
 				if ((i.pos.x >= HP_MAP_WIDTH) || (i.pos.y >= HP_MAP_HEIGHT)) {
 					throw stream::error("Layer has tiles outside map boundary!");
 				}
@@ -125,19 +125,22 @@ class Layer_Hocus_8bit: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
-			for (unsigned int i = 0; i <= HP_MAX_VALID_TILECODE; i++) {
-				if (i == HP_DEFAULT_TILE) continue;
-
-				Item t;
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i;
-				validItems.push_back(t);
-			}
-			return validItems;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> validItems;
+				for (unsigned int i = 0; i <= HP_MAX_VALID_TILECODE; i++) {
+					if (i == HP_DEFAULT_TILE) continue;
+
+					Item t;
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i;
+					validItems.push_back(t);
+				}
+				return validItems;
+			}();
+			return available;
 		}
 
 	private:
@@ -205,7 +208,7 @@ class Map_Hocus: public MapCore, public Map2DCore
 
 		virtual void flush()
 		{
-			assert(this->layers().size() == 2);
+			assert(this->v_layers.size() == 2);
 
 			// Write the background layer
 			auto layerBG = dynamic_cast<Layer_Hocus_Background*>(this->v_layers[0].get());
@@ -296,7 +299,7 @@ std::unique_ptr<Map> MapType_Hocus::open(
 	if (layer1 == suppData.end()) {
 		throw stream::error("Missing content for layer: Layer1");
 	}
-	return std::make_unique<Map_Hocus>(std::move(content), std::move(layer1->second));
+	return openPacked<Map_Hocus>(std::move(content), std::move(layer1->second));
 }
 
 SuppFilenames MapType_Hocus::getRequiredSupps(stream::input& content,
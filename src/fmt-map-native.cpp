@@ -0,0 +1,811 @@
+/**
+ * @file  fmt-map-native.cpp
+ * @brief MapType and Map2D implementation for the native interchange format.
+ *
+ * The file starts with a 16-byte header:
+ *
+ *   char[8] signature "Camoto2D"
+ *   u16le   version (1)
+ *   u16le   number of sections
+ *   u32le   reserved (0)
+ *
+ * This is followed by one 12-byte entry per section (u32le id, u32le offset
+ * from the start of the file, u32le length) and then the sections themselves,
+ * each starting on a 4-byte boundary.  Sections with unknown IDs are skipped,
+ * so later versions can add new ones.  The layers are stored one per "LAYR"
+ * section, in the same order as Map2D::layers().
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <cstring>
+#include <camoto/util.hpp> // make_unique
+#include <camoto/gamemaps/native.hpp>
+#include <camoto/gamemaps/util.hpp>
+#include "map-core.hpp"
+#include "map2d-core.hpp"
+#include "fmt-map-native.hpp"
+
+/// Signature at the start of the file.
+#define NATIVE_SIG           "Camoto2D"
+
+/// Length of NATIVE_SIG, in bytes.
+#define NATIVE_SIG_LEN       8
+
+/// File format version written by this code.
+#define NATIVE_VERSION       1
+
+/// Length of the file header, before the section table.
+#define NATIVE_HEADER_LEN    16
+
+/// Length of each entry in the section table.
+#define NATIVE_ENTRY_LEN     12
+
+/// Make a section ID from four characters.
+#define NATIVE_ID(a, b, c, d) \
+	((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) \
+		| ((uint32_t)(d) << 24))
+
+/// Section with the map's caps and dimensions.
+#define NATIVE_ID_INFO       NATIVE_ID('I', 'N', 'F', 'O')
+
+/// Section listing the graphics filenames.
+#define NATIVE_ID_GFX        NATIVE_ID('G', 'F', 'X', ' ')
+
+/// Section with the map attributes.
+#define NATIVE_ID_ATTR       NATIVE_ID('A', 'T', 'T', 'R')
+
+/// Section with one layer.
+#define NATIVE_ID_LAYR       NATIVE_ID('L', 'A', 'Y', 'R')
+
+/// Section with the map paths.
+#define NATIVE_ID_PATH       NATIVE_ID('P', 'A', 'T', 'H')
+
+/// Layer content is a dense grid of codes, INVALID_TILECODE for empty cells.
+#define NATIVE_LAYER_GRID    0
+
+/// Layer content is a table of items.
+#define NATIVE_LAYER_ITEMS   1
+
+/// Smallest number of bytes an item takes up in an item table.
+#define NATIVE_MIN_ITEM_LEN  16
+
+namespace camoto {
+namespace gamemaps {
+
+typedef Map2D::Layer::Item Item;
+
+/// Bounds-checked reader for little-endian values in a memory buffer.
+class NativeReader
+{
+	public:
+		NativeReader(const uint8_t *begin, const uint8_t *end)
+			:	p(begin),
+				end(end)
+		{
+		}
+
+		std::size_t remaining() const
+		{
+			return this->end - this->p;
+		}
+
+		uint32_t u32()
+		{
+			this->need(4);
+			uint32_t v = this->p[0] | (this->p[1] << 8) | (this->p[2] << 16)
+				| ((uint32_t)this->p[3] << 24);
+			this->p += 4;
+			return v;
+		}
+
+		int32_t i32()
+		{
+			return (int32_t)this->u32();
+		}
+
+		Point point()
+		{
+			Point pt;
+			pt.x = this->i32();
+			pt.y = this->i32();
+			return pt;
+		}
+
+		std::string str()
+		{
+			uint32_t len = this->u32();
+			this->need(len);
+			std::string s((const char *)this->p, len);
+			this->p += len;
+			return s;
+		}
+
+		std::vector<std::string> strList()
+		{
+			uint32_t count = this->u32();
+			// Every string has at least a length field
+			this->need((uint64_t)count * 4);
+			std::vector<std::string> list;
+			list.reserve(count);
+			for (uint32_t i = 0; i < count; i++) list.push_back(this->str());
+			return list;
+		}
+
+		/// Make sure there are at least len bytes left to read.
+		void need(uint64_t len) const
+		{
+			if (len > this->remaining()) {
+				throw stream::error("Native map file is truncated.");
+			}
+		}
+
+	private:
+		const uint8_t *p;
+		const uint8_t *end;
+};
+
+/// Builds up a section of a native file in memory.
+class NativeWriter
+{
+	public:
+		void u32(uint32_t v)
+		{
+			char b[4] = {
+				(char)(v & 0xFF), (char)((v >> 8) & 0xFF),
+				(char)((v >> 16) & 0xFF), (char)((v >> 24) & 0xFF),
+			};
+			this->data.append(b, 4);
+			return;
+		}
+
+		void i32(int32_t v)
+		{
+			this->u32((uint32_t)v);
+			return;
+		}
+
+		void point(const Point& pt)
+		{
+			this->i32(pt.x);
+			this->i32(pt.y);
+			return;
+		}
+
+		void str(const std::string& s)
+		{
+			this->u32(s.length());
+			this->data.append(s);
+			return;
+		}
+
+		void strList(const std::vector<std::string>& list)
+		{
+			this->u32(list.size());
+			for (auto& s : list) this->str(s);
+			return;
+		}
+
+		/// Pad with zeroes to the next 4-byte boundary.
+		void align()
+		{
+			this->data.append((4 - (this->data.length() & 3)) & 3, '\0');
+			return;
+		}
+
+		std::string data;
+};
+
+static void writeItem(NativeWriter& w, const Item& item)
+{
+	w.u32((unsigned int)item.type);
+	w.point(item.pos);
+	w.u32(item.code);
+	if (item.type & Item::Type::Player) {
+		w.u32(item.playerNumber);
+		w.u32(item.playerFacingLeft ? 1 : 0);
+	}
+	if (item.type & Item::Type::Text) {
+		w.u32(item.textFont);
+		w.str(item.textContent);
+	}
+	if (item.type & Item::Type::Movement) {
+		w.u32((unsigned int)item.movementFlags);
+		w.u32(item.movementDistLeft);
+		w.u32(item.movementDistRight);
+		w.u32(item.movementDistUp);
+		w.u32(item.movementDistDown);
+		w.u32(item.movementSpeedX);
+		w.u32(item.movementSpeedY);
+	}
+	if (item.type & Item::Type::Blocking) {
+		w.u32((unsigned int)item.blockingFlags);
+	}
+	if (item.type & Item::Type::Flags) {
+		w.u32((unsigned int)item.generalFlags);
+	}
+	return;
+}
+
+static Item readItem(NativeReader& r)
+{
+	Item item = Item();
+	item.type = (Item::Type)r.u32();
+	item.pos = r.point();
+	item.code = r.u32();
+	if (item.type & Item::Type::Player) {
+		item.playerNumber = r.u32();
+		item.playerFacingLeft = r.u32() != 0;
+	}
+	if (item.type & Item::Type::Text) {
+		item.textFont = r.u32();
+		item.textContent = r.str();
+	}
+	if (item.type & Item::Type::Movement) {
+		item.movementFlags = (Item::MovementFlags)r.u32();
+		item.movementDistLeft = r.u32();
+		item.movementDistRight = r.u32();
+		item.movementDistUp = r.u32();
+		item.movementDistDown = r.u32();
+		item.movementSpeedX = r.u32();
+		item.movementSpeedY = r.u32();
+	}
+	if (item.type & Item::Type::Blocking) {
+		item.blockingFlags = (Item::BlockingFlags)r.u32();
+	}
+	if (item.type & Item::Type::Flags) {
+		item.generalFlags = (Item::GeneralFlags)r.u32();
+	}
+	return item;
+}
+
+static void writeItems(NativeWriter& w, ConstView<Item> items)
+{
+	w.u32(items.size());
+	for (auto& i : items) writeItem(w, i);
+	return;
+}
+
+static std::vector<Item> readItems(NativeReader& r)
+{
+	uint32_t count = r.u32();
+	r.need((uint64_t)count * NATIVE_MIN_ITEM_LEN);
+	std::vector<Item> items;
+	items.reserve(count);
+	for (uint32_t i = 0; i < count; i++) items.push_back(readItem(r));
+	return items;
+}
+
+/// Can a layer be stored as a dense grid, and would that be smaller?
+/**
+ * A grid costs four bytes per cell, while an item table costs at least
+ * NATIVE_MIN_ITEM_LEN bytes per item, so a grid is used once a quarter of the
+ * cells are filled with plain tiles.
+ */
+static bool suitsGrid(ConstView<Item> items, const Point& layerSize)
+{
+	if ((layerSize.x <= 0) || (layerSize.y <= 0)) return false;
+	uint64_t cells = (uint64_t)layerSize.x * layerSize.y;
+	if (cells > 0x10000000) return false;
+	if ((uint64_t)items.size() * NATIVE_MIN_ITEM_LEN < cells * 4) return false;
+
+	std::vector<bool> used(cells, false);
+	for (auto& i : items) {
+		if (i.type != Item::Type::Default) return false;
+		if (i.code == INVALID_TILECODE) return false;
+		if (
+			(i.pos.x < 0) || (i.pos.x >= layerSize.x)
+			|| (i.pos.y < 0) || (i.pos.y >= layerSize.y)
+		) return false;
+		auto cell = (uint64_t)i.pos.y * layerSize.x + i.pos.x;
+		if (used[cell]) return false; // more than one item in the cell
+		used[cell] = true;
+	}
+	return true;
+}
+
+/// Layer read from a native file.
+class Layer_Native: public Map2DCore::LayerCore
+{
+	public:
+		Layer_Native(NativeReader& r)
+		{
+			this->v_title = r.str();
+			this->v_caps = (Caps)r.u32();
+			this->v_layerSize = r.point();
+			this->v_tileSize = r.point();
+
+			uint32_t encoding = r.u32();
+			switch (encoding) {
+				case NATIVE_LAYER_GRID: {
+					Point size = r.point();
+					if ((size.x < 0) || (size.y < 0)) {
+						throw stream::error("Native map layer has a negative size.");
+					}
+					uint64_t cells = (uint64_t)size.x * size.y;
+					r.need(cells * 4);
+					std::vector<Item> items;
+					items.reserve(cells);
+					Item t = Item();
+					t.type = Item::Type::Default;
+					for (t.pos.y = 0; t.pos.y < size.y; t.pos.y++) {
+						for (t.pos.x = 0; t.pos.x < size.x; t.pos.x++) {
+							t.code = r.u32();
+							if (t.code != INVALID_TILECODE) items.push_back(t);
+						}
+					}
+					this->v_allItems = std::move(items);
+					break;
+				}
+				case NATIVE_LAYER_ITEMS:
+					this->v_allItems = readItems(r);
+					break;
+				default:
+					throw stream::error(createString("Native map layer uses unknown "
+						"encoding " << encoding << "."));
+			}
+			this->v_availableItems = readItems(r);
+		}
+
+		virtual std::string title() const
+		{
+			return this->v_title;
+		}
+
+		virtual Caps caps() const
+		{
+			return this->v_caps;
+		}
+
+		virtual const std::vector<Item>& availableItems() const
+		{
+			return this->v_availableItems;
+		}
+
+	private:
+		std::string v_title;
+		Caps v_caps;
+		std::vector<Item> v_availableItems;
+};
+
+class Map_Native: public MapCore, public Map2DCore
+{
+	public:
+		/// Create an empty map.
+		Map_Native(std::unique_ptr<stream::inout> content)
+			:	content(std::move(content)),
+				v_caps(Caps::Default)
+		{
+		}
+
+		/// Read a map from a native file, already loaded into memory.
+		Map_Native(std::unique_ptr<stream::inout> content,
+			const std::vector<uint8_t>& data)
+			:	content(std::move(content)),
+				v_caps(Caps::Default)
+		{
+			NativeReader header(data.data(), data.data() + data.size());
+			header.need(NATIVE_HEADER_LEN);
+			if (memcmp(data.data(), NATIVE_SIG, NATIVE_SIG_LEN) != 0) {
+				throw stream::error("This is not a native map file.");
+			}
+			header.u32();
+			header.u32();
+			uint32_t verCount = header.u32();
+			if ((verCount & 0xFFFF) != NATIVE_VERSION) {
+				throw stream::error(createString("Native map file version "
+					<< (verCount & 0xFFFF) << " is not supported."));
+			}
+			unsigned int numSections = verCount >> 16;
+			header.u32(); // reserved
+
+			for (unsigned int s = 0; s < numSections; s++) {
+				uint32_t id = header.u32();
+				uint32_t offset = header.u32();
+				uint32_t len = header.u32();
+				if ((uint64_t)offset + len > data.size()) {
+					throw stream::error("Native map section runs past the end of "
+						"the file.");
+				}
+				NativeReader r(data.data() + offset, data.data() + offset + len);
+				switch (id) {
+					case NATIVE_ID_INFO:
+						this->v_caps = (Caps)r.u32();
+						this->v_viewport = r.point();
+						this->v_mapSize = r.point();
+						this->v_tileSize = r.point();
+						break;
+					case NATIVE_ID_GFX: {
+						uint32_t count = r.u32();
+						for (uint32_t i = 0; i < count; i++) {
+							auto purpose = (ImagePurpose)r.u32();
+							GraphicsFilename gf;
+							gf.filename = r.str();
+							gf.type = r.str();
+							this->v_graphics[purpose] = gf;
+						}
+						break;
+					}
+					case NATIVE_ID_ATTR: {
+						uint32_t count = r.u32();
+						for (uint32_t i = 0; i < count; i++) {
+							this->v_attributes.push_back(readAttribute(r));
+						}
+						break;
+					}
+					case NATIVE_ID_LAYR:
+						this->v_layers.push_back(std::make_shared<Layer_Native>(r));
+						break;
+					case NATIVE_ID_PATH: {
+						uint32_t count = r.u32();
+						for (uint32_t i = 0; i < count; i++) {
+							auto path = std::make_shared<Path>();
+							path->fixed = r.u32() != 0;
+							path->forceClosed = r.u32() != 0;
+							path->maxPoints = r.u32();
+							path->start = readPoints(r);
+							path->points = readPoints(r);
+							this->v_paths.push_back(path);
+						}
+						break;
+					}
+					default:
+						// Section added by a later version, ignore it
+						break;
+				}
+			}
+		}
+
+		virtual ~Map_Native()
+		{
+		}
+
+		virtual std::map<ImagePurpose, GraphicsFilename> graphicsFilenames() const
+		{
+			return this->v_graphics;
+		}
+
+		virtual void flush()
+		{
+			saveNative(*this, *this->content);
+			this->content->flush();
+			return;
+		}
+
+		virtual Caps caps() const
+		{
+			return this->v_caps;
+		}
+
+		virtual Point viewport() const
+		{
+			return this->v_viewport;
+		}
+
+		virtual Point mapSize() const
+		{
+			return this->v_mapSize;
+		}
+
+		virtual void mapSize(const Point& newSize)
+		{
+			this->v_mapSize = newSize;
+			return;
+		}
+
+		virtual Point tileSize() const
+		{
+			return this->v_tileSize;
+		}
+
+		virtual void tileSize(const Point& newSize)
+		{
+			this->v_tileSize = newSize;
+			return;
+		}
+
+	private:
+		static Attribute readAttribute(NativeReader& r)
+		{
+			Attribute a;
+			a.type = (Attribute::Type)r.u32();
+			a.name = r.str();
+			a.desc = r.str();
+			switch (a.type) {
+				case Attribute::Type::Integer:
+					a.integerValue = r.i32();
+					a.integerMinValue = r.i32();
+					a.integerMaxValue = r.i32();
+					break;
+				case Attribute::Type::Enum:
+					a.enumValue = r.u32();
+					a.enumValueNames = r.strList();
+					break;
+				case Attribute::Type::Filename:
+					a.filenameValue = r.str();
+					a.filenameSpec = r.strList();
+					break;
+				case Attribute::Type::Text:
+					a.textValue = r.str();
+					a.textMaxLength = r.u32();
+					break;
+				case Attribute::Type::Image:
+					a.imageIndex = r.i32();
+					break;
+				default:
+					throw stream::error("Native map has an attribute of unknown type.");
+			}
+			return a;
+		}
+
+		static std::vector<Point> readPoints(NativeReader& r)
+		{
+			uint32_t count = r.u32();
+			r.need((uint64_t)count * 8);
+			std::vector<Point> points;
+			points.reserve(count);
+			for (uint32_t i = 0; i < count; i++) points.push_back(r.point());
+			return points;
+		}
+
+		std::unique_ptr<stream::inout> content;
+		Caps v_caps;
+		Point v_viewport;
+		Point v_mapSize;
+		Point v_tileSize;
+		std::map<ImagePurpose, GraphicsFilename> v_graphics;
+};
+
+static void writeAttribute(NativeWriter& w, const Attribute& a)
+{
+	w.u32((unsigned int)a.type);
+	w.str(a.name);
+	w.str(a.desc);
+	switch (a.type) {
+		case Attribute::Type::Integer:
+			w.i32(a.integerValue);
+			w.i32(a.integerMinValue);
+			w.i32(a.integerMaxValue);
+			break;
+		case Attribute::Type::Enum:
+			w.u32(a.enumValue);
+			w.strList(a.enumValueNames);
+			break;
+		case Attribute::Type::Filename:
+			w.str(a.filenameValue);
+			w.strList(a.filenameSpec);
+			break;
+		case Attribute::Type::Text:
+			w.str(a.textValue);
+			w.u32(a.textMaxLength);
+			break;
+		case Attribute::Type::Image:
+			w.i32(a.imageIndex);
+			break;
+	}
+	return;
+}
+
+static void writePoints(NativeWriter& w, const std::vector<Point>& points)
+{
+	w.u32(points.size());
+	for (auto& pt : points) w.point(pt);
+	return;
+}
+
+static void writeLayer(NativeWriter& w, const Map2D& map,
+	const Map2D::Layer& layer)
+{
+	// The palette can't be stored, so don't claim to have one
+	auto caps = (Map2D::Layer::Caps)((unsigned int)layer.caps()
+		& ~(unsigned int)Map2D::Layer::Caps::HasPalette);
+	w.str(layer.title());
+	w.u32((unsigned int)caps);
+	w.point((caps & Map2D::Layer::Caps::HasOwnSize)
+		? layer.layerSize() : Point{0, 0});
+	w.point((caps & Map2D::Layer::Caps::HasOwnTileSize)
+		? layer.tileSize() : Point{0, 0});
+
+	Point layerSize, tileSize;
+	getLayerDims(map, layer, &layerSize, &tileSize);
+	auto items = layer.itemView();
+	if (suitsGrid(items, layerSize)) {
+		w.u32(NATIVE_LAYER_GRID);
+		w.point(layerSize);
+		std::vector<uint32_t> grid((std::size_t)layerSize.x * layerSize.y,
+			INVALID_TILECODE);
+		for (auto& i : items) grid[i.pos.y * layerSize.x + i.pos.x] = i.code;
+		for (auto c : grid) w.u32(c);
+	} else {
+		w.u32(NATIVE_LAYER_ITEMS);
+		writeItems(w, items);
+	}
+	writeItems(w, ConstView<Item>(layer.availableItems()));
+	return;
+}
+
+void saveNative(const Map2D& map, stream::output& output)
+{
+	std::vector<std::pair<uint32_t, std::string>> sections;
+	auto caps = map.caps();
+
+	{
+		NativeWriter w;
+		w.u32((unsigned int)caps);
+		w.point((caps & Map2D::Caps::HasViewport) ? map.viewport() : Point{0, 0});
+		w.point((caps & Map2D::Caps::HasMapSize) ? map.mapSize() : Point{0, 0});
+		w.point((caps & Map2D::Caps::HasTileSize) ? map.tileSize() : Point{0, 0});
+		sections.emplace_back(NATIVE_ID_INFO, std::move(w.data));
+	}
+	{
+		NativeWriter w;
+		auto gfx = map.graphicsFilenames();
+		w.u32(gfx.size());
+		for (auto& g : gfx) {
+			w.u32((unsigned int)g.first);
+			w.str(g.second.filename);
+			w.str(g.second.type);
+		}
+		sections.emplace_back(NATIVE_ID_GFX, std::move(w.data));
+	}
+	{
+		NativeWriter w;
+		auto& attributes = map.attributes();
+		w.u32(attributes.size());
+		for (auto& a : attributes) writeAttribute(w, a);
+		sections.emplace_back(NATIVE_ID_ATTR, std::move(w.data));
+	}
+	for (auto& layer : map.layerView()) {
+		NativeWriter w;
+		writeLayer(w, map, layer);
+		sections.emplace_back(NATIVE_ID_LAYR, std::move(w.data));
+	}
+	{
+		// paths() has no const version, but it is only read here
+		auto& paths = const_cast<Map2D&>(map).paths();
+		NativeWriter w;
+		w.u32(paths.size());
+		for (auto& p : paths) {
+			w.u32(p->fixed ? 1 : 0);
+			w.u32(p->forceClosed ? 1 : 0);
+			w.u32(p->maxPoints);
+			writePoints(w, p->start);
+			writePoints(w, p->points);
+		}
+		sections.emplace_back(NATIVE_ID_PATH, std::move(w.data));
+	}
+
+	if (sections.size() > 0xFFFF) {
+		throw stream::error("Too many layers to store in a native map file.");
+	}
+
+	NativeWriter file;
+	file.data.append(NATIVE_SIG, NATIVE_SIG_LEN);
+	file.u32(NATIVE_VERSION | (sections.size() << 16));
+	file.u32(0);
+	uint64_t offset = NATIVE_HEADER_LEN + sections.size() * NATIVE_ENTRY_LEN;
+	for (auto& s : sections) {
+		offset = (offset + 3) & ~3ULL;
+		if (offset + s.second.length() > 0xFFFFFFFF) {
+			throw stream::error("Map is too large to store in a native map file.");
+		}
+		file.u32(s.first);
+		file.u32(offset);
+		file.u32(s.second.length());
+		offset += s.second.length();
+	}
+	for (auto& s : sections) {
+		file.align();
+		file.data.append(s.second);
+	}
+
+	output.truncate(file.data.length());
+	output.seekp(0, stream::start);
+	output.write(file.data);
+	return;
+}
+
+
+std::string MapType_Native::code() const
+{
+	return CAMOTO_NATIVE_MAPTYPE;
+}
+
+std::string MapType_Native::friendlyName() const
+{
+	return "Camoto native map";
+}
+
+std::vector<std::string> MapType_Native::fileExtensions() const
+{
+	return {"c2d"};
+}
+
+std::vector<std::string> MapType_Native::games() const
+{
+	return {};
+}
+
+MapType::Certainty MapType_Native::isInstance(stream::input& content) const
+{
+	stream::len lenMap = content.size();
+
+	// Too short to hold the header
+	// TESTED BY: fmt_map_native_isinstance_c01
+	if (lenMap < NATIVE_HEADER_LEN) return MapType::DefinitelyNo;
+
+	uint8_t header[NATIVE_HEADER_LEN];
+	content.seekg(0, stream::start);
+	content.read(header, NATIVE_HEADER_LEN);
+
+	// Bad signature
+	// TESTED BY: fmt_map_native_isinstance_c02
+	if (memcmp(header, NATIVE_SIG, NATIVE_SIG_LEN) != 0) {
+		return MapType::DefinitelyNo;
+	}
+
+	// Unsupported version
+	// TESTED BY: fmt_map_native_isinstance_c03
+	unsigned int version = header[8] | (header[9] << 8);
+	if (version != NATIVE_VERSION) return MapType::DefinitelyNo;
+
+	// Section table runs past the end of the file
+	// TESTED BY: fmt_map_native_isinstance_c04
+	unsigned int numSections = header[10] | (header[11] << 8);
+	stream::len lenTable = numSections * NATIVE_ENTRY_LEN;
+	if (NATIVE_HEADER_LEN + lenTable > lenMap) return MapType::DefinitelyNo;
+
+	std::vector<uint8_t> table(lenTable);
+	content.read(table.data(), lenTable);
+	NativeReader r(table.data(), table.data() + table.size());
+	for (unsigned int s = 0; s < numSections; s++) {
+		r.u32(); // id
+		uint64_t offset = r.u32();
+		uint64_t len = r.u32();
+		// Section runs past the end of the file
+		// TESTED BY: fmt_map_native_isinstance_c05
+		if (offset + len > lenMap) return MapType::DefinitelyNo;
+	}
+
+	// TESTED BY: fmt_map_native_isinstance_c00
+	return MapType::DefinitelyYes;
+}
+
+std::unique_ptr<Map> MapType_Native::create(
+	std::unique_ptr<stream::inout> content, SuppData& suppData) const
+{
+	return std::make_unique<Map_Native>(std::move(content));
+}
+
+std::unique_ptr<Map> MapType_Native::open(
+	std::unique_ptr<stream::inout> content, SuppData& suppData) const
+{
+	// Read the whole file in one go, then decode it from memory
+	std::vector<uint8_t> data(content->size());
+	content->seekg(0, stream::start);
+	content->read(data.data(), data.size());
+	return openPacked<Map_Native>(std::move(content), data);
+}
+
+SuppFilenames MapType_Native::getRequiredSupps(stream::input& content,
+	const std::string& filename) const
+{
+	return {};
+}
+
+} // namespace gamemaps
+} // namespace camoto
@@ -164,18 +164,21 @@ class Layer_Nukem2_Actors: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> validItems;
 /// @todo Correct list of actors
-			for (int i = 0; i < 10; i++) {
-				validItems.emplace_back();
-				auto& t = validItems.back();
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i + 31;
-			}
-			return validItems;
+				for (int i = 0; i < 10; i++) {
+					validItems.emplace_back();
+					auto& t = validItems.back();
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i + 31;
+				}
+				return validItems;
+			}();
+			return available;
 		}
 };
 
@@ -237,19 +240,22 @@ class Layer_Nukem2_Background: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
-			for (unsigned int i = 0; i < DN2_NUM_SOLID_TILES; i++) {
-				validItems.emplace_back();
-				auto& t = validItems.back();
-
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i;
-				validItems.push_back(t);
-			}
-			return validItems;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> validItems;
+				for (unsigned int i = 0; i < DN2_NUM_SOLID_TILES; i++) {
+					validItems.emplace_back();
+					auto& t = validItems.back();
+
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i;
+					validItems.push_back(t);
+				}
+				return validItems;
+			}();
+			return available;
 		}
 };
 
@@ -311,22 +317,159 @@ class Layer_Nukem2_Foreground: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
-			for (unsigned int i = 0; i < DN2_NUM_MASKED_TILES; i++) {
-				validItems.emplace_back();
-				auto& t = validItems.back();
-
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i;
-				validItems.push_back(t);
-			}
-			return validItems;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> validItems;
+				for (unsigned int i = 0; i < DN2_NUM_MASKED_TILES; i++) {
+					validItems.emplace_back();
+					auto& t = validItems.back();
+
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i;
+					validItems.push_back(t);
+				}
+				return validItems;
+			}();
+			return available;
 		}
 };
 
+/// Attribute names, descriptions and enum labels for Duke Nukem II maps.
+/**
+ * Only the filenames and flag values differ between levels, so everything
+ * else is built once and shared.
+ */
+static const std::vector<Attribute>& attributeSchemaNukem2()
+{
+	static const std::vector<Attribute> schema = []() -> std::vector<Attribute> {
+		std::vector<Attribute> attrs;
+		{
+			assert(attrs.size() == ATTR_CZONE); // make sure compile-time index is correct
+			attrs.emplace_back();
+			auto& a = attrs.back();
+			a.type = Attribute::Type::Filename;
+			a.name = "CZone tileset";
+			a.desc = "Filename of the tileset to use for drawing the foreground and background layers.";
+			a.filenameSpec.push_back("*.mni");
+		}
+		{
+			assert(attrs.size() == ATTR_BACKDROP); // make sure compile-time index is correct
+			attrs.emplace_back();
+			auto& a = attrs.back();
+			a.type = Attribute::Type::Filename;
+			a.name = "Backdrop";
+			a.desc = "Filename of the backdrop to draw behind the map.";
+			a.filenameSpec.push_back("*.mni");
+		}
+		{
+			assert(attrs.size() == ATTR_MUSIC); // make sure compile-time index is correct
+			attrs.emplace_back();
+			auto& a = attrs.back();
+			a.type = Attribute::Type::Filename;
+			a.name = "Song";
+			a.desc = "File to play as background music.";
+			a.filenameSpec.push_back("*.imf");
+		}
+		{
+			assert(attrs.size() == ATTR_USEALTBD); // make sure compile-time index is correct
+			attrs.emplace_back();
+			auto& a = attrs.back();
+			a.type = Attribute::Type::Enum;
+			a.name = "Alt backdrop?";
+			a.desc = "When should the alternate backdrop file be used?";
+			a.enumValueNames = {
+				"Never",
+				"After destroying force field",
+				"After teleporting",
+				"Both? (this value has an unknown/untested effect)",
+			};
+		}
+		{
+			assert(attrs.size() == ATTR_QUAKE); // make sure compile-time index is correct
+			attrs.emplace_back();
+			auto& a = attrs.back();
+			a.type = Attribute::Type::Enum;
+			a.name = "Earthquake";
+			a.desc = "Should the level shake like there is an earthquake?";
+			a.enumValueNames = {
+				"No",
+				"Yes",
+			};
+		}
+		{
+			assert(attrs.size() == ATTR_SCROLLBD); // make sure compile-time index is correct
+			attrs.emplace_back();
+			auto& a = attrs.back();
+			a.type = Attribute::Type::Enum;
+			a.name = "Backdrop movement";
+			a.desc = "Should the backdrop move when the player is stationary?";
+			a.enumValueNames = {
+				"No",
+				"Scroll left",
+				"Scroll up",
+				"3 (this value has an unknown/untested effect)",
+			};
+		}
+		{
+			assert(attrs.size() == ATTR_PARALLAX); // make sure compile-time index is correct
+			attrs.emplace_back();
+			auto& a = attrs.back();
+			a.type = Attribute::Type::Enum;
+			a.name = "Parallax";
+			a.desc = "How should the backdrop scroll when the player moves?";
+			a.enumValueNames = {
+				"Fixed - no movement",
+				"Horizontal and vertical movement",
+				"Horizontal movement only",
+				"3 (this value has an unknown/untested effect)",
+			};
+		}
+		{
+			assert(attrs.size() == ATTR_ALTBD); // make sure compile-time index is correct
+			attrs.emplace_back();
+			auto& a = attrs.back();
+			a.type = Attribute::Type::Integer;
+			a.name = "Alt backdrop pic";
+			a.desc = "Number of alternate backdrop file (DROPx.MNI), 0 if unused";
+			a.integerMinValue = 0;
+			a.integerMaxValue = 24;
+		}
+
+		// Trailing filenames
+		{
+			assert(attrs.size() == ATTR_ZONEATTR); // make sure compile-time index is correct
+			attrs.emplace_back();
+			auto& a = attrs.back();
+			a.type = Attribute::Type::Filename;
+			a.name = "Zone attribute";
+			a.desc = "Filename of the zone tile attributes.";
+			a.filenameSpec.push_back("*.mni");
+		}
+		{
+			assert(attrs.size() == ATTR_ZONETSET); // make sure compile-time index is correct
+			attrs.emplace_back();
+			auto& a = attrs.back();
+			a.type = Attribute::Type::Filename;
+			a.name = "Zone tileset";
+			a.desc = "Filename of the zone solid tileset.";
+			a.filenameSpec.push_back("*.mni");
+		}
+		{
+			assert(attrs.size() == ATTR_ZONEMSET); // make sure compile-time index is correct
+			attrs.emplace_back();
+			auto& a = attrs.back();
+			a.type = Attribute::Type::Filename;
+			a.name = "Zone masked tileset";
+			a.desc = "Filename of the zone masked tileset.";
+			a.filenameSpec.push_back("*.mni");
+		}
+		return attrs;
+	}();
+	return schema;
+}
+
 class Map_Nukem2: public MapCore, public Map2DCore
 {
 	public:
@@ -342,43 +485,15 @@ class Map_Nukem2: public MapCore, public Map2DCore
 				>> u16le(bgOffset)
 			;
 
-			// Set the attributes
-			{
-				assert(this->v_attributes.size() == ATTR_CZONE); // make sure compile-time index is correct
-				this->v_attributes.emplace_back();
-				auto& a = this->v_attributes.back();
-				a.type = Attribute::Type::Filename;
-				a.name = "CZone tileset";
-				a.desc = "Filename of the tileset to use for drawing the foreground and background layers.";
-				*this->content >> nullPadded(a.filenameValue, 13);
-				// Trim off the padding spaces
-				a.filenameValue = a.filenameValue.substr(0, a.filenameValue.find_last_not_of(' ') + 1);
-				a.filenameSpec.push_back("*.mni");
-			};
-			{
-				assert(this->v_attributes.size() == ATTR_BACKDROP); // make sure compile-time index is correct
-				this->v_attributes.emplace_back();
-				auto& a = this->v_attributes.back();
-				a.type = Attribute::Type::Filename;
-				a.name = "Backdrop";
-				a.desc = "Filename of the backdrop to draw behind the map.";
-				*this->content >> nullPadded(a.filenameValue, 13);
-				// Trim off the padding spaces
-				a.filenameValue = a.filenameValue.substr(0, a.filenameValue.find_last_not_of(' ') + 1);
-				a.filenameSpec.push_back("*.mni");
-			};
-			{
-				assert(this->v_attributes.size() == ATTR_MUSIC); // make sure compile-time index is correct
-				this->v_attributes.emplace_back();
-				auto& a = this->v_attributes.back();
-				a.type = Attribute::Type::Filename;
-				a.name = "Song";
-				a.desc = "File to play as background music.";
-				*this->content >> nullPadded(a.filenameValue, 13);
+			this->attributesFromSchema(attributeSchemaNukem2());
+			auto readFilename = [this](unsigned int index) {
+				std::string name;
+				*this->content >> nullPadded(name, 13);
 				// Trim off the padding spaces
-				a.filenameValue = a.filenameValue.substr(0, a.filenameValue.find_last_not_of(' ') + 1);
-				a.filenameSpec.push_back("*.imf");
+				this->attributeValue(index,
+					name.substr(0, name.find_last_not_of(' ') + 1));
 			};
+			for (auto i : {ATTR_CZONE, ATTR_BACKDROP, ATTR_MUSIC}) readFilename(i);
 
 			uint8_t flags, altBack;
 			*this->content
@@ -388,76 +503,6 @@ class Map_Nukem2: public MapCore, public Map2DCore
 			;
 			lenMap -= 2+13+13+13+1+1+2+2;
 
-			{
-				assert(this->v_attributes.size() == ATTR_USEALTBD); // make sure compile-time index is correct
-				this->v_attributes.emplace_back();
-				auto& a = this->v_attributes.back();
-				a.type = Attribute::Type::Enum;
-				a.name = "Alt backdrop?";
-				a.desc = "When should the alternate backdrop file be used?";
-				a.enumValue = (flags >> 6) & 3;
-				a.enumValueNames = {
-					"Never",
-					"After destroying force field",
-					"After teleporting",
-					"Both? (this value has an unknown/untested effect)",
-				};
-			};
-			{
-				assert(this->v_attributes.size() == ATTR_QUAKE); // make sure compile-time index is correct
-				this->v_attributes.emplace_back();
-				auto& a = this->v_attributes.back();
-				a.type = Attribute::Type::Enum;
-				a.name = "Earthquake";
-				a.desc = "Should the level shake like there is an earthquake?";
-				a.enumValue = (flags >> 5) & 1;
-				a.enumValueNames = {
-					"No",
-					"Yes",
-				};
-			};
-			{
-				assert(this->v_attributes.size() == ATTR_SCROLLBD); // make sure compile-time index is correct
-				this->v_attributes.emplace_back();
-				auto& a = this->v_attributes.back();
-				a.type = Attribute::Type::Enum;
-				a.name = "Backdrop movement";
-				a.desc = "Should the backdrop move when the player is stationary?";
-				a.enumValue = (flags >> 3) & 3;
-				a.enumValueNames = {
-					"No",
-					"Scroll left",
-					"Scroll up",
-					"3 (this value has an unknown/untested effect)",
-				};
-			};
-			{
-				assert(this->v_attributes.size() == ATTR_PARALLAX); // make sure compile-time index is correct
-				this->v_attributes.emplace_back();
-				auto& a = this->v_attributes.back();
-				a.type = Attribute::Type::Enum;
-				a.name = "Parallax";
-				a.desc = "How should the backdrop scroll when the player moves?";
-				a.enumValue = (flags >> 0) & 3;
-				a.enumValueNames = {
-					"Fixed - no movement",
-					"Horizontal and vertical movement",
-					"Horizontal movement only",
-					"3 (this value has an unknown/untested effect)",
-				};
-			};
-			{
-				assert(this->v_attributes.size() == ATTR_ALTBD); // make sure compile-time index is correct
-				this->v_attributes.emplace_back();
-				auto& a = this->v_attributes.back();
-				a.type = Attribute::Type::Integer;
-				a.name = "Alt backdrop pic";
-				a.desc = "Number of alternate backdrop file (DROPx.MNI), 0 if unused";
-				a.integerValue = altBack;
-				a.integerMinValue = 0;
-				a.integerMaxValue = 24;
-			};
-
 			// Read in the actor layer
 			auto layerAC = std::make_shared<Layer_Nukem2_Actors>(
 				*this->content, &lenMap
@@ -585,43 +630,16 @@ class Map_Nukem2: public MapCore, public Map2DCore
 			auto layerFG = std::make_shared<Layer_Nukem2_Foreground>(fgItems);
 
 			// Trailing filenames
-			{
-				assert(this->v_attributes.size() == ATTR_ZONEATTR); // make sure compile-time index is correct
-				this->v_attributes.emplace_back();
-				auto& a = this->v_attributes.back();
-				a.type = Attribute::Type::Filename;
-				a.name = "Zone attribute";
-				a.desc = "Filename of the zone tile attributes.";
-				*this->content >> nullPadded(a.filenameValue, 13);
-				// Trim off the padding spaces
-				a.filenameValue = a.filenameValue.substr(0, a.filenameValue.find_last_not_of(' ') + 1);
-				a.filenameSpec.push_back("*.mni");
-			}
-			{
-				assert(this->v_attributes.size() == ATTR_ZONETSET); // make sure compile-time index is correct
-				this->v_attributes.emplace_back();
-				auto& a = this->v_attributes.back();
-				a.type = Attribute::Type::Filename;
-				a.name = "Zone tileset";
-				a.desc = "Filename of the zone solid tileset.";
-				*this->content >> nullPadded(a.filenameValue, 13);
-				// Trim off the padding spaces
-				a.filenameValue = a.filenameValue.substr(0, a.filenameValue.find_last_not_of(' ') + 1);
-				a.filenameSpec.push_back("*.mni");
-			}
-			{
-				assert(this->v_attributes.size() == ATTR_ZONEMSET); // make sure compile-time index is correct
-				this->v_attributes.emplace_back();
-				auto& a = this->v_attributes.back();
-				a.type = Attribute::Type::Filename;
-				a.name = "Zone masked tileset";
-				a.desc = "Filename of the zone masked tileset.";
-				*this->content >> nullPadded(a.filenameValue, 13);
-				// Trim off the padding spaces
-				a.filenameValue = a.filenameValue.substr(0, a.filenameValue.find_last_not_of(' ') + 1);
-				a.filenameSpec.push_back("*.mni");
+			for (auto i : {ATTR_ZONEATTR, ATTR_ZONETSET, ATTR_ZONEMSET}) {
+				readFilename(i);
 			}
 
+			this->attributeValue(ATTR_USEALTBD, (flags >> 6) & 3);
+			this->attributeValue(ATTR_QUAKE, (flags >> 5) & 1);
+			this->attributeValue(ATTR_SCROLLBD, (flags >> 3) & 3);
+			this->attributeValue(ATTR_PARALLAX, (flags >> 0) & 3);
+			this->attributeValue(ATTR_ALTBD, altBack);
+
 			this->v_layers.push_back(layerBG);
 			this->v_layers.push_back(layerFG);
 			this->v_layers.push_back(layerAC);
@@ -638,7 +656,7 @@ class Map_Nukem2: public MapCore, public Map2DCore
 			auto layerAC = dynamic_cast<Layer_Nukem2_Actors*>(this->v_layers[2].get());
 
 			// Figure out where the main data will start
-			auto& actors = layerAC->items();
+			auto actors = layerAC->itemView();
 			stream::pos offBG = 2+13+13+13+1+1+2+2+6*actors.size();
 
 			this->content->seekp(0, stream::start);
@@ -647,44 +665,33 @@ class Map_Nukem2: public MapCore, public Map2DCore
 			;
 
 			// CZone
-			auto& attr0 = this->v_attributes[ATTR_CZONE];
-			std::string val = attr0.filenameValue;
+			std::string val = this->attributeText(ATTR_CZONE);
 			int padamt = 12 - val.length();
 			val += std::string(padamt, ' '); // pad with spaces
 			*this->content << nullPadded(val, 13);
 
 			// Backdrop
-			auto& attr1 = this->v_attributes[ATTR_BACKDROP];
-			val = attr1.filenameValue;
+			val = this->attributeText(ATTR_BACKDROP);
 			padamt = 12 - val.length();
 			val += std::string(padamt, ' '); // pad with spaces
 			*this->content << nullPadded(val, 13);
 
 			// Song
-			auto& attr2 = this->v_attributes[ATTR_MUSIC];
-			val = attr2.filenameValue;
+			val = this->attributeText(ATTR_MUSIC);
 			padamt = 12 - val.length();
 			val += std::string(padamt, ' '); // pad with spaces
 			*this->content << nullPadded(val, 13);
 
 			uint8_t flags = 0;
 
-			auto& attr3 = this->v_attributes[ATTR_USEALTBD];
-			flags |= attr3.enumValue << 6;
-
-			auto& attr4 = this->v_attributes[ATTR_QUAKE];
-			flags |= attr4.enumValue << 5;
-
-			auto& attr5 = this->v_attributes[ATTR_SCROLLBD];
-			flags |= attr5.enumValue << 3;
-
-			auto& attr6 = this->v_attributes[ATTR_PARALLAX];
-			flags |= attr6.enumValue << 0;
+			flags |= this->attributeNumber(ATTR_USEALTBD) << 6;
+			flags |= this->attributeNumber(ATTR_QUAKE) << 5;
+			flags |= this->attributeNumber(ATTR_SCROLLBD) << 3;
+			flags |= this->attributeNumber(ATTR_PARALLAX) << 0;
 
 			*this->content << u8(flags);
 
-			auto& attr7 = this->v_attributes[ATTR_ALTBD];
-			*this->content << u8(attr7.integerValue);
+			*this->content << u8(this->attributeNumber(ATTR_ALTBD));
 
 			*this->content << u16le(0);
 
@@ -702,12 +709,12 @@ class Map_Nukem2: public MapCore, public Map2DCore
 			// Set the default extra bits
 			std::vector<uint16_t> extra(DN2_NUM_TILES_BG, 0x00);
 
-			for (auto& i : layerBG->items()) {
+			for (auto& i : layerBG->itemView()) {
 				assert((i.pos.x < mapDims.x) && (i.pos.y < mapDims.y));
 				bg[i.pos.y * mapDims.x + i.pos.x] = i.code;
 			}
 
-			for (auto& i : layerFG->items()) {
+			for (auto& i : layerFG->itemView()) {
 				assert((i.pos.x < mapDims.x) && (i.pos.y < mapDims.y));
 				fg[i.pos.y * mapDims.x + i.pos.x] = i.code;
 			}
@@ -818,16 +825,13 @@ class Map_Nukem2: public MapCore, public Map2DCore
 			this->content->write(rleExtra.data(), rleExtra.size());
 
 			// Zone attribute filename (null-padded, not space-padded)
-			auto& attr8 = this->v_attributes[ATTR_ZONEATTR];
-			*this->content << nullPadded(attr8.filenameValue, 13);
+			*this->content << nullPadded(this->attributeText(ATTR_ZONEATTR), 13);
 
 			// Zone solid tileset filename (null-padded, not space-padded)
-			auto& attr9 = this->v_attributes[ATTR_ZONETSET];
-			*this->content << nullPadded(attr9.filenameValue, 13);
+			*this->content << nullPadded(this->attributeText(ATTR_ZONETSET), 13);
 
 			// Zone masked tileset filename (null-padded, not space-padded)
-			auto& attr10 = this->v_attributes[ATTR_ZONEMSET];
-			*this->content << nullPadded(attr10.filenameValue, 13);
+			*this->content << nullPadded(this->attributeText(ATTR_ZONEMSET), 13);
 
 			this->content->flush();
 			return;
@@ -840,7 +844,7 @@ class Map_Nukem2: public MapCore, public Map2DCore
 				std::make_pair(
 					ImagePurpose::BackgroundTileset1,
 					GraphicsFilename{
-						this->v_attributes[ATTR_CZONE].filenameValue,
+						this->attributeText(ATTR_CZONE),
 						"tls-nukem2-czone"
 					}
 				),
@@ -848,7 +852,7 @@ class Map_Nukem2: public MapCore, public Map2DCore
 				std::make_pair(
 					ImagePurpose::BackgroundImage,
 					GraphicsFilename{
-						this->v_attributes[ATTR_BACKDROP].filenameValue,
+						this->attributeText(ATTR_BACKDROP),
 						"img-nukem2-backdrop"
 					}
 				),
@@ -971,7 +975,7 @@ std::unique_ptr<Map> MapType_Nukem2::create(
 std::unique_ptr<Map> MapType_Nukem2::open(
 	std::unique_ptr<stream::inout> content, SuppData& suppData) const
 {
-	return std::make_unique<Map_Nukem2>(std::move(content));
+	return openPacked<Map_Nukem2>(std::move(content));
 }
 
 SuppFilenames MapType_Nukem2::getRequiredSupps(stream::input& content,
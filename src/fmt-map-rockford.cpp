@@ -78,7 +78,7 @@ class Layer_Rockford_Background: public Map2DCore::LayerCore
 		{
 			// Write the background layer
 			std::vector<uint8_t> bg(RF_LAYER_LEN_BG, RF_DEFAULT_BGTILE);
-			for (auto& i : this->items()) {
+			for (auto& i : this->itemView()) {
 				if ((i.pos.x > RF_MAP_WIDTH) || (i.pos.y > RF_MAP_HEIGHT)) {
 					throw stream::error("Layer has tiles outside map boundary!");
 				}
@@ -124,31 +124,34 @@ class Layer_Rockford_Background: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<uint8_t> validItemCodes = {
-				0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
-				0x08, 0x09, 0x0A, 0x0B, 0x0C,
-				0x10,
-				0x28, 0x2C, 0x2D, 0x2E,
-				0x30, 0x34, 0x35, 0x36, 0x37,
-				0x38,
-				0x53,
-				0x70, 0x74, 0x7C,
-				0x80, 0x82, 0x84, 0x88,
-				0xC4,
-			};
-			std::vector<Item> validItems;
-			for (auto i : validItemCodes) {
-				if (i == RF_DEFAULT_BGTILE) continue;
-
-				Item t;
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i;
-				validItems.push_back(t);
-			}
-			return validItems;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<uint8_t> validItemCodes = {
+					0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+					0x08, 0x09, 0x0A, 0x0B, 0x0C,
+					0x10,
+					0x28, 0x2C, 0x2D, 0x2E,
+					0x30, 0x34, 0x35, 0x36, 0x37,
+					0x38,
+					0x53,
+					0x70, 0x74, 0x7C,
+					0x80, 0x82, 0x84, 0x88,
+					0xC4,
+				};
+				std::vector<Item> validItems;
+				for (auto i : validItemCodes) {
+					if (i == RF_DEFAULT_BGTILE) continue;
+
+					Item t;
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i;
+					validItems.push_back(t);
+				}
+				return validItems;
+			}();
+			return available;
 		}
 };
 
@@ -185,7 +188,7 @@ class Map_Rockford: public MapCore, public Map2DCore
 
 		virtual void flush()
 		{
-			assert(this->layers().size() == 1);
+			assert(this->v_layers.size() == 1);
 
 			this->content->truncate(RF_LAYER_LEN_BG);
 			this->content->seekp(0, stream::start);
@@ -285,7 +288,7 @@ std::unique_ptr<Map> MapType_Rockford::create(
 std::unique_ptr<Map> MapType_Rockford::open(
 	std::unique_ptr<stream::inout> content, SuppData& suppData) const
 {
-	return std::make_unique<Map_Rockford>(std::move(content));
+	return openPacked<Map_Rockford>(std::move(content));
 }
 
 SuppFilenames MapType_Rockford::getRequiredSupps(stream::input& content,
@@ -66,6 +66,16 @@ typedef struct {
 
 #include "fmt-map-sagent-mapping.hpp"
 
+/// Can a tile be placed at the given cell?
+/**
+ * The first column of every row is reserved, so nothing can go there.
+ * Everywhere else is unrestricted.
+ */
+static inline bool cellPermitted(const Point& pos)
+{
+	return pos.x != 0;
+}
+
 class Layer_SAgent_Common: public Map2DCore::LayerCore
 {
 	public:
@@ -115,9 +125,26 @@ class Layer_SAgent_Background: public Layer_SAgent_Common
 {
 	public:
 		Layer_SAgent_Background(unsigned int tileBG, const TILE_MAP *tm)
-			:	tileBG(tileBG),
-				tm(tm)
 		{
+			for (unsigned int i = 1; i < 4; i++) {
+				// Add the background tiles
+				this->available.emplace_back();
+				auto& t = this->available.back();
+				t.type = Map2D::Layer::Item::Type::Default;
+				t.pos = {0, 0};
+				t.code = tileBG + i;
+			}
+			for (const TILE_MAP *next = tm; next->code > 0; next++) {
+				for (unsigned int i = 0; i < 4 * 3; i++) {
+					if (next->tiles[i] >= 0) {
+						this->available.emplace_back();
+						auto& t = this->available.back();
+						t.type = Map2D::Layer::Item::Type::Default;
+						t.pos = {0, 0};
+						t.code = next->tiles[i];
+					}
+				}
+			}
 		}
 
 		virtual ~Layer_SAgent_Background()
@@ -134,43 +161,33 @@ class Layer_SAgent_Background: public Layer_SAgent_Common
 			return Caps::Default;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
-
-			for (unsigned int i = 1; i < 4; i++) {
-				// Add the background tiles
-				validItems.emplace_back();
-				auto& t = validItems.back();
-				t.type = Map2D::Layer::Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = this->tileBG + i;
-			}
-			for (const TILE_MAP *next = this->tm; next->code > 0; next++) {
-				for (unsigned int i = 0; i < 4 * 3; i++) {
-					if (next->tiles[i] >= 0) {
-						validItems.emplace_back();
-						auto& t = validItems.back();
-						t.type = Map2D::Layer::Item::Type::Default;
-						t.pos = {0, 0};
-						t.code = next->tiles[i];
-					}
-				}
-			}
-			return validItems;
+			return this->available;
 		}
 
 	private:
-		unsigned int tileBG; ///< Index of current background tile
-		const TILE_MAP *tm;
+		/// Background tiles, plus every tile in this episode's tile map
+		std::vector<Item> available;
 };
 
 class Layer_SAgent_Foreground: public Layer_SAgent_Common
 {
 	public:
 		Layer_SAgent_Foreground(const TILE_MAP *tm)
-			:	tm(tm)
 		{
+/// @todo These tiles are not all valid here, only include ones that work (or perhaps only include ones where the background layer is not null in that cell)
+			for (const TILE_MAP *next = tm; next->code > 0; next++) {
+				for (unsigned int i = 0; i < 4 * 3; i++) {
+					if (next->tiles[i] >= 0) {
+						this->available.emplace_back();
+						auto& t = this->available.back();
+						t.type = Map2D::Layer::Item::Type::Default;
+						t.pos = {0, 0};
+						t.code = next->tiles[i];
+					}
+				}
+			}
 		}
 
 		virtual ~Layer_SAgent_Foreground()
@@ -187,34 +204,33 @@ class Layer_SAgent_Foreground: public Layer_SAgent_Common
 			return Caps::Default;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-/// @todo These tiles are not all valid here, only include ones that work (or perhaps only include ones where the background layer is not null in that cell)
-			std::vector<Item> validItems;
-
-			for (const TILE_MAP *next = this->tm; next->code > 0; next++) {
-				for (unsigned int i = 0; i < 4 * 3; i++) {
-					if (next->tiles[i] >= 0) {
-						validItems.emplace_back();
-						auto& t = validItems.back();
-						t.type = Map2D::Layer::Item::Type::Default;
-						t.pos = {0, 0};
-						t.code = next->tiles[i];
-					}
-				}
-			}
-			return validItems;
+			return this->available;
 		}
 
 		virtual bool tilePermittedAt(const Map2D::Layer::Item& item,
 			const Point& pos, unsigned int *maxCount) const
 		{
-			if (pos.x == 0) return false; // can't place tiles in this column
-			return true; // otherwise unrestricted
+			*maxCount = 0; // unlimited
+			return cellPermitted(pos);
+		}
+
+		virtual void itemsPermitted(ConstView<Item> items,
+			std::vector<bool> *permitted, std::vector<unsigned int> *maxCount)
+			const
+		{
+			// Same rule as tilePermittedAt(), without a call per item
+			permitted->resize(items.size());
+			maxCount->assign(items.size(), 0);
+			auto out = permitted->begin();
+			for (auto& i : items) *out++ = cellPermitted(i.pos);
+			return;
 		}
 
 	private:
-		const TILE_MAP *tm;
+		/// Every tile in this episode's tile map
+		std::vector<Item> available;
 };
 
 class Map_SAgent: public MapCore, public Map2DCore
@@ -229,7 +245,7 @@ class Map_SAgent: public MapCore, public Map2DCore
 
 			// Read the background layer
 			this->content->seekg(0, stream::start);
-			std::vector<uint8_t> bgdata(lenMap, SAMT_EMPTY);
+			ArenaVector<uint8_t> bgdata(lenMap, SAMT_EMPTY);
 			this->content->read(bgdata.data(), lenMap);
 
 			// Read the background code
@@ -293,8 +309,9 @@ class Map_SAgent: public MapCore, public Map2DCore
 			this->v_layers.push_back(layerBG);
 			this->v_layers.push_back(layerFG);
 
-			auto& tilesBG = layerBG->items();
-			auto& tilesFG = layerFG->items();
+			// Filled here and handed to the layers at the end, as loading through
+			// items() would stop the layers' items from being shared
+			SharedItems::ItemList tilesBG, tilesFG;
 			auto tiles = &tilesBG;
 
 			tilesBG.reserve(SAM_MAP_WIDTH * this->mapHeight);
@@ -357,6 +374,8 @@ class Map_SAgent: public MapCore, public Map2DCore
 				}
 				bg += 2; // skip CRLF
 			}
+			layerBG->sharedItems(SharedItems(std::move(tilesBG)));
+			layerFG->sharedItems(SharedItems(std::move(tilesFG)));
 		}
 
 		virtual ~Map_SAgent()
@@ -375,7 +394,7 @@ class Map_SAgent: public MapCore, public Map2DCore
 
 		virtual void flush()
 		{
-			assert(this->layers().size() == 2);
+			assert(this->v_layers.size() == 2);
 
 			auto mapSize = this->mapSize();
 
@@ -398,7 +417,7 @@ class Map_SAgent: public MapCore, public Map2DCore
 			std::vector<int> bgsrc(lenMap, -1);
 			std::vector<int> fgsrc(lenMap, -1);
 
-			for (const auto& i : this->v_layers[0]->items()) {
+			for (const auto& i : this->v_layers[0]->itemView()) {
 				if ((i.pos.x >= mapSize.x) || (i.pos.y >= mapSize.y)) {
 					throw stream::error("Background layer has tiles outside map boundary!");
 				}
@@ -406,7 +425,7 @@ class Map_SAgent: public MapCore, public Map2DCore
 				bgsrc[pos] = i.code;
 			}
 
-			for (const auto& i : this->v_layers[1]->items()) {
+			for (const auto& i : this->v_layers[1]->itemView()) {
 				if ((i.pos.x >= mapSize.x) || (i.pos.y >= mapSize.y)) {
 					throw stream::error("Foreground layer has tiles outside map boundary!");
 				}
@@ -748,7 +767,7 @@ std::unique_ptr<Map> MapType_SAgent::create(
 std::unique_ptr<Map> MapType_SAgent::open(
 	std::unique_ptr<stream::inout> content, SuppData& suppData) const
 {
-	return std::make_unique<Map_SAgent>(std::move(content), this->isWorldMap());
+	return openPacked<Map_SAgent>(std::move(content), this->isWorldMap());
 }
 
 SuppFilenames MapType_SAgent::getRequiredSupps(stream::input& content,
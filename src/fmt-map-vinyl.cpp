@@ -71,7 +71,7 @@ class Layer_Vinyl_Background: public Map2DCore::LayerCore
 			unsigned long mapHeight)
 		{
 			std::vector<uint16_t> grid(mapWidth * mapHeight, 0x00);
-			for (auto& i : this->items()) {
+			for (auto& i : this->itemView()) {
 				if ((i.pos.x >= (long)mapWidth) || (i.pos.y >= (long)mapHeight)) {
 					throw stream::error("Layer has tiles outside map boundary!");
 				}
@@ -115,17 +115,20 @@ class Layer_Vinyl_Background: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> items;
-			for (unsigned int i = 0; i <= VGFM_MAX_VALID_FGTILECODE; i++) {
-				items.emplace_back();
-				auto& t = items.back();
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i;
-			}
-			return items;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> items;
+				for (unsigned int i = 0; i <= VGFM_MAX_VALID_FGTILECODE; i++) {
+					items.emplace_back();
+					auto& t = items.back();
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i;
+				}
+				return items;
+			}();
+			return available;
 		}
 };
 
@@ -156,7 +159,7 @@ class Layer_Vinyl_Foreground: public Map2DCore::LayerCore
 			unsigned long mapHeight)
 		{
 			std::vector<uint8_t> grid(mapWidth * mapHeight, VGFM_DEFAULT_TILE_FG);
-			for (auto& i : this->items()) {
+			for (auto& i : this->itemView()) {
 				if ((i.pos.x >= (long)mapWidth) || (i.pos.y >= (long)mapHeight)) {
 					throw stream::error("Layer has tiles outside map boundary!");
 				}
@@ -198,20 +201,23 @@ class Layer_Vinyl_Foreground: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> items;
-			for (unsigned int i = 0; i <= VGFM_MAX_VALID_FGTILECODE; i++) {
-				// The default tile actually has an image, so don't exclude it
-				if (i == VGFM_DEFAULT_TILE_FG) continue;
-
-				items.emplace_back();
-				auto& t = items.back();
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i;
-			}
-			return items;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> items;
+				for (unsigned int i = 0; i <= VGFM_MAX_VALID_FGTILECODE; i++) {
+					// The default tile actually has an image, so don't exclude it
+					if (i == VGFM_DEFAULT_TILE_FG) continue;
+
+					items.emplace_back();
+					auto& t = items.back();
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i;
+				}
+				return items;
+			}();
+			return available;
 		}
 };
 
@@ -381,7 +387,7 @@ std::unique_ptr<Map> MapType_Vinyl::create(
 std::unique_ptr<Map> MapType_Vinyl::open(
 	std::unique_ptr<stream::inout> content, SuppData& suppData) const
 {
-	return std::make_unique<Map_Vinyl>(std::move(content));
+	return openPacked<Map_Vinyl>(std::move(content));
 }
 
 SuppFilenames MapType_Vinyl::getRequiredSupps(stream::input& content,
@@ -91,7 +91,7 @@ class Layer_Wacky_Background: public Map2DCore::LayerCore
 
 			// Write the background layer
 			std::vector<uint8_t> bg(WW_LAYER_LEN_BG, WW_DEFAULT_BGTILE);
-			for (auto& i : this->items()) {
+			for (auto& i : this->itemView()) {
 				if ((i.pos.x >= WW_MAP_WIDTH) || (i.pos.y >= WW_MAP_HEIGHT)) {
 					throw stream::error("Layer has tiles outside map boundary!");
 				}
@@ -137,19 +137,22 @@ class Layer_Wacky_Background: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
-			for (unsigned int i = 0; i <= WW_MAX_VALID_TILECODE; i++) {
-				if (i == WW_DEFAULT_BGTILE) continue;
-
-				validItems.emplace_back();
-				auto& t = validItems.back();
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i;
-			}
-			return validItems;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> validItems;
+				for (unsigned int i = 0; i <= WW_MAX_VALID_TILECODE; i++) {
+					if (i == WW_DEFAULT_BGTILE) continue;
+
+					validItems.emplace_back();
+					auto& t = validItems.back();
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i;
+				}
+				return validItems;
+			}();
+			return available;
 		}
 
 	private:
@@ -210,7 +213,7 @@ class Map_Wacky: public MapCore, public Map2DCore
 
 		virtual void flush()
 		{
-			assert(this->layers().size() == 1);
+			assert(this->v_layers.size() == 1);
 			assert(this->paths().size() == 1);
 			if (this->v_paths[0]->start.size() < 1) throw stream::error("Path has no starting point!");
 			if (this->v_paths[0]->start.size() > 1) throw stream::error("Path has too many starting points!");
@@ -349,7 +352,7 @@ std::unique_ptr<Map> MapType_Wacky::open(
 	if (compPath == suppData.end()) {
 		throw stream::error("Missing content for layer: Layer1 (need *.rd file)");
 	}
-	return std::make_unique<Map_Wacky>(
+	return openPacked<Map_Wacky>(
 		std::move(content), std::move(compPath->second)
 	);
 }
@@ -24,6 +24,7 @@
 #include <cassert>
 #include <camoto/iostream_helpers.hpp>
 #include <camoto/util.hpp> // make_unique
+#include <camoto/gamemaps/rle-wordresc.hpp>
 #include "map-core.hpp"
 #include "map2d-core.hpp"
 #include "fmt-map-wordresc.hpp"
@@ -92,73 +93,28 @@ namespace gamemaps {
 
 using namespace camoto::gamegraphics;
 
-/// Write the given data to the stream, RLE encoded
-int rleWrite(stream::output& output, const std::vector<uint8_t>& data)
-{
-	int lenWritten = 0;
-
-	// RLE encode the data
-	uint8_t lastCount = 0;
-	uint8_t lastCode = data[0];
-	for (auto& d : data) {
-		if (d == lastCode) {
-			if (lastCount == 0xFF) {
-				output
-					<< u8(lastCount)
-					<< u8(lastCode)
-				;
-				lenWritten += 2;
-				lastCount = 1;
-			} else {
-				lastCount++;
-			}
-		} else {
-			output
-				<< u8(lastCount)
-				<< u8(lastCode)
-			;
-			lenWritten += 2;
-			lastCode = d;
-			lastCount = 1;
-		}
-	}
-	// Write out the last tile
-	if (lastCount > 0) {
-		output
-			<< u8(lastCount)
-			<< u8(lastCode)
-		;
-		lenWritten += 2;
-	}
-
-	return lenWritten;
-}
-
-
 class Layer_WR_Background: public Map2DCore::LayerCore
 {
 	public:
 		Layer_WR_Background(stream::inout& content, const Point& mapSize)
 		{
-			this->v_allItems.reserve(mapSize.x * mapSize.y);
-			for (int i = 0; i < mapSize.x * mapSize.y; ) {
-				uint8_t num, code;
-				content >> u8(num) >> u8(code);
+			unsigned long lenBG = mapSize.x * mapSize.y;
+			std::vector<uint8_t> tiles(lenBG, WR_DEFAULT_BGTILE);
+			if (rleReadWR(content, tiles) < lenBG) {
+				throw stream::error("Background layer is truncated.");
+			}
 
-				if (code == WR_DEFAULT_BGTILE) {
-					i += num;
-				} else {
-					while (num-- > 0) {
-						this->v_allItems.emplace_back();
-						auto& t = this->v_allItems.back();
+			this->v_allItems.reserve(lenBG);
+			for (unsigned long i = 0; i < lenBG; i++) {
+				if (tiles[i] == WR_DEFAULT_BGTILE) continue;
 
-						t.type = Item::Type::Default;
-						t.pos.x = i % mapSize.x;
-						t.pos.y = i / mapSize.x;
-						t.code = code;
-						i++;
-					}
-				}
+				this->v_allItems.emplace_back();
+				auto& t = this->v_allItems.back();
+
+				t.type = Item::Type::Default;
+				t.pos.x = i % mapSize.x;
+				t.pos.y = i / mapSize.x;
+				t.code = tiles[i];
 			}
 		}
 
@@ -170,13 +126,13 @@ class Layer_WR_Background: public Map2DCore::LayerCore
 		{
 			std::vector<uint8_t> tiles(mapSize.x * mapSize.y, WR_DEFAULT_BGTILE);
 			for (auto& t : this->v_allItems) {
-				if ((t.pos.x > mapSize.x) || (t.pos.y > mapSize.y)) {
+				if ((t.pos.x >= mapSize.x) || (t.pos.y >= mapSize.y)) {
 					throw stream::error(createString("Layer has tiles outside map "
 							"boundary at (" << t.pos.x << "," << t.pos.y << ")"));
 				}
 				tiles[t.pos.y * mapSize.x + t.pos.x] = t.code;
 			}
-			rleWrite(content, tiles);
+			rleWriteWR(content, tiles);
 		}
 
 		virtual std::string title() const
@@ -211,19 +167,22 @@ class Layer_WR_Background: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
-			for (unsigned int i = 0; i <= WR_MAX_VALID_TILECODE; i++) {
-				if (i == WR_DEFAULT_BGTILE) continue;
-
-				validItems.emplace_back();
-				auto& t = validItems.back();
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i;
-			}
-			return validItems;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> validItems;
+				for (unsigned int i = 0; i <= WR_MAX_VALID_TILECODE; i++) {
+					if (i == WR_DEFAULT_BGTILE) continue;
+
+					validItems.emplace_back();
+					auto& t = validItems.back();
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i;
+				}
+				return validItems;
+			}();
+			return available;
 		}
 
 	private:
@@ -366,46 +325,49 @@ class Layer_WR_Object_Small: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
-			{
-				validItems.emplace_back();
-				auto& t = validItems.back();
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = WR_CODE_GRUZZLE;
-			}
-			{
-				validItems.emplace_back();
-				auto& t = validItems.back();
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = WR_CODE_ENTRANCE;
-			}
-			{
-				validItems.emplace_back();
-				auto& t = validItems.back();
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = WR_CODE_EXIT;
-			}
-			{
-				validItems.emplace_back();
-				auto& t = validItems.back();
-				t.type = Item::Type::Movement;
-				t.pos = {0, 0};
-				t.code = WR_CODE_DRIP;
-				t.movementFlags = Item::MovementFlags::DistanceLimit
-					| Item::MovementFlags::SpeedLimit;
-				t.movementDistLeft = 0;
-				t.movementDistRight = 0;
-				t.movementDistUp = 0;
-				t.movementDistDown = Item::DistIndeterminate;
-				t.movementSpeedX = 0;
-				t.movementSpeedY = 0x44;
-			}
-			return validItems;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> validItems;
+				{
+					validItems.emplace_back();
+					auto& t = validItems.back();
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = WR_CODE_GRUZZLE;
+				}
+				{
+					validItems.emplace_back();
+					auto& t = validItems.back();
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = WR_CODE_ENTRANCE;
+				}
+				{
+					validItems.emplace_back();
+					auto& t = validItems.back();
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = WR_CODE_EXIT;
+				}
+				{
+					validItems.emplace_back();
+					auto& t = validItems.back();
+					t.type = Item::Type::Movement;
+					t.pos = {0, 0};
+					t.code = WR_CODE_DRIP;
+					t.movementFlags = Item::MovementFlags::DistanceLimit
+						| Item::MovementFlags::SpeedLimit;
+					t.movementDistLeft = 0;
+					t.movementDistRight = 0;
+					t.movementDistUp = 0;
+					t.movementDistDown = Item::DistIndeterminate;
+					t.movementSpeedX = 0;
+					t.movementSpeedY = 0x44;
+				}
+				return validItems;
+			}();
+			return available;
 		}
 
 		virtual bool tilePermittedAt(const Item& item,
@@ -561,17 +523,20 @@ class Layer_WR_Object_Large: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
-			for (unsigned int i = WR_CODE_SLIME; i <= WR_CODE_LETTER7; i++) {
-				validItems.emplace_back();
-				auto& t = validItems.back();
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i;
-			}
-			return validItems;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> validItems;
+				for (unsigned int i = WR_CODE_SLIME; i <= WR_CODE_LETTER7; i++) {
+					validItems.emplace_back();
+					auto& t = validItems.back();
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i;
+				}
+				return validItems;
+			}();
+			return available;
 		}
 
 		virtual bool tilePermittedAt(const Item& item,
@@ -591,50 +556,46 @@ class Layer_WR_Attribute: public Map2DCore::LayerCore
 	public:
 		Layer_WR_Attribute(stream::inout& content, const Point& mapSize)
 		{
-			uint16_t atWidth = mapSize.x * 2;
-			uint16_t atHeight = mapSize.y * 2;
-			this->v_allItems.reserve(atWidth * atHeight);
-			for (int i = 0; i < atWidth * atHeight; ) {
-				uint8_t num, code;
-				try {
-					content >> u8(num) >> u8(code);
-				} catch (const stream::incomplete_read&) {
-					// Some level files seem to be truncated (maybe for efficiency)
-					break;
-				}
-				if (code == WR_DEFAULT_ATTILE) {
-					i += num;
-				} else {
-					while (num-- > 0) {
-						this->v_allItems.emplace_back();
-						auto& t = this->v_allItems.back();
-
-						t.pos.x = i % atWidth + 1;
-						t.pos.y = i / atWidth;
-						t.code = code;
-						switch (code) {
-							case 0x73:
-								t.type = Item::Type::Blocking;
-								t.blockingFlags =
-									Item::BlockingFlags::BlockLeft
-									| Item::BlockingFlags::BlockRight
-									| Item::BlockingFlags::BlockTop
-									| Item::BlockingFlags::BlockBottom
-								;
-								break;
-							case 0x74:
-								t.type = Item::Type::Blocking;
-								t.blockingFlags =
-									Item::BlockingFlags::BlockTop
-									| Item::BlockingFlags::JumpDown
-								;
-								break;
-							default:
-								t.type = Item::Type::Default;
-								break;
-						}
-						i++;
-					}
+			unsigned int atWidth = mapSize.x * 2;
+			unsigned int atHeight = mapSize.y * 2;
+			unsigned long lenAttr = atWidth * atHeight;
+			std::vector<uint8_t> attr(lenAttr, WR_DEFAULT_ATTILE);
+
+			// Some level files seem to be truncated (maybe for efficiency), so any
+			// cells that are missing are left as the default.
+			rleReadWR(content, attr);
+
+			this->v_allItems.reserve(lenAttr);
+			for (unsigned long i = 0; i < lenAttr; i++) {
+				uint8_t code = attr[i];
+				if (code == WR_DEFAULT_ATTILE) continue;
+
+				this->v_allItems.emplace_back();
+				auto& t = this->v_allItems.back();
+
+				t.pos.x = i % atWidth + 1;
+				t.pos.y = i / atWidth;
+				t.code = code;
+				switch (code) {
+					case 0x73:
+						t.type = Item::Type::Blocking;
+						t.blockingFlags =
+							Item::BlockingFlags::BlockLeft
+							| Item::BlockingFlags::BlockRight
+							| Item::BlockingFlags::BlockTop
+							| Item::BlockingFlags::BlockBottom
+						;
+						break;
+					case 0x74:
+						t.type = Item::Type::Blocking;
+						t.blockingFlags =
+							Item::BlockingFlags::BlockTop
+							| Item::BlockingFlags::JumpDown
+						;
+						break;
+					default:
+						t.type = Item::Type::Default;
+						break;
 				}
 			}
 		}
@@ -665,13 +626,13 @@ class Layer_WR_Attribute: public Map2DCore::LayerCore
 				unsigned int xpos = t.pos.x;
 				if (xpos < 1) continue; // skip first column, just in case
 				xpos--;
-				if ((xpos > mapSize.x * 2) || (t.pos.y > mapSize.y * 2)) {
+				if ((xpos >= mapSize.x * 2) || (t.pos.y >= mapSize.y * 2)) {
 					throw stream::error(createString("Layer has tiles outside map "
 							"boundary at (" << xpos << "," << t.pos.y << ")"));
 				}
 				attr[t.pos.y * mapSize.x * 2 + xpos] = code;
 			}
-			rleWrite(content, attr);
+			rleWriteWR(content, attr);
 		}
 
 		virtual std::string title() const
@@ -735,52 +696,55 @@ class Layer_WR_Attribute: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
-			{
-				validItems.emplace_back();
-				auto& t = validItems.back();
-				t.type = Item::Type::Blocking;
-				t.pos = {0, 0};
-				t.code = 0x0073;
-				t.blockingFlags =
-					Item::BlockingFlags::BlockLeft
-					| Item::BlockingFlags::BlockRight
-					| Item::BlockingFlags::BlockTop
-					| Item::BlockingFlags::BlockBottom
-				;
-			}
-			{
-				validItems.emplace_back();
-				auto& t = validItems.back();
-				t.type = Item::Type::Blocking;
-				t.pos = {0, 0};
-				t.code = 0x0074;
-				t.blockingFlags =
-					Item::BlockingFlags::BlockTop
-					| Item::BlockingFlags::JumpDown
-				;
-			}
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> validItems;
+				{
+					validItems.emplace_back();
+					auto& t = validItems.back();
+					t.type = Item::Type::Blocking;
+					t.pos = {0, 0};
+					t.code = 0x0073;
+					t.blockingFlags =
+						Item::BlockingFlags::BlockLeft
+						| Item::BlockingFlags::BlockRight
+						| Item::BlockingFlags::BlockTop
+						| Item::BlockingFlags::BlockBottom
+					;
+				}
+				{
+					validItems.emplace_back();
+					auto& t = validItems.back();
+					t.type = Item::Type::Blocking;
+					t.pos = {0, 0};
+					t.code = 0x0074;
+					t.blockingFlags =
+						Item::BlockingFlags::BlockTop
+						| Item::BlockingFlags::JumpDown
+					;
+				}
 
-			// Question-mark boxes
-			for (unsigned int i = 0; i < 7; i++) {
-				validItems.emplace_back();
-				auto& t = validItems.back();
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i;
-			}
+				// Question-mark boxes
+				for (unsigned int i = 0; i < 7; i++) {
+					validItems.emplace_back();
+					auto& t = validItems.back();
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i;
+				}
 
-			// Unknown (see tile mapping code)
-			{
-				validItems.emplace_back();
-				auto& t = validItems.back();
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = 0x00FD;
-			}
-			return validItems;
+				// Unknown (see tile mapping code)
+				{
+					validItems.emplace_back();
+					auto& t = validItems.back();
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = 0x00FD;
+				}
+				return validItems;
+			}();
+			return available;
 		}
 
 		virtual bool tilePermittedAt(const Item& item,
@@ -794,6 +758,78 @@ class Layer_WR_Attribute: public Map2DCore::LayerCore
 		std::unique_ptr<stream::inout> content;
 };
 
+/// Attribute names, descriptions and enum labels for Word Rescue maps.
+/**
+ * These are the same for every map, so they are only built once.  Each map
+ * shares them and only keeps its own values.
+ */
+static const std::vector<Attribute>& attributeSchemaWordRescue()
+{
+	static const std::vector<Attribute> schema = []() -> std::vector<Attribute> {
+		std::vector<Attribute> attrs;
+		{
+			assert(attrs.size() == ATTR_BGCOLOUR); // make sure compile-time index is correct
+			attrs.emplace_back();
+			auto& a = attrs.back();
+			a.type = Attribute::Type::Enum;
+			a.name = "Background colour";
+			a.desc = "Colour to draw where there are no tiles.  Only used if "
+				"backdrop is not set.";
+			a.enumValueNames.push_back("EGA 0 - Black");
+			a.enumValueNames.push_back("EGA 1 - Dark blue");
+			a.enumValueNames.push_back("EGA 2 - Dark green");
+			a.enumValueNames.push_back("EGA 3 - Dark cyan");
+			a.enumValueNames.push_back("EGA 4 - Dark red");
+			a.enumValueNames.push_back("EGA 5 - Dark magenta");
+			a.enumValueNames.push_back("EGA 6 - Brown");
+			a.enumValueNames.push_back("EGA 7 - Light grey");
+			a.enumValueNames.push_back("EGA 8 - Dark grey");
+			a.enumValueNames.push_back("EGA 9 - Light blue");
+			a.enumValueNames.push_back("EGA 10 - Light green");
+			a.enumValueNames.push_back("EGA 11 - Light cyan");
+			a.enumValueNames.push_back("EGA 12 - Light red");
+			a.enumValueNames.push_back("EGA 13 - Light magenta");
+			a.enumValueNames.push_back("EGA 14 - Yellow");
+			a.enumValueNames.push_back("EGA 15 - White");
+		}
+		{
+			assert(attrs.size() == ATTR_TILESET); // make sure compile-time index is correct
+			attrs.emplace_back();
+			auto& a = attrs.back();
+			a.type = Attribute::Type::Enum;
+			a.name = "Tileset";
+			a.desc = "Tileset to use for this map.";
+			a.enumValueNames.push_back("Desert");
+			a.enumValueNames.push_back("Castle");
+			a.enumValueNames.push_back("Suburban");
+			a.enumValueNames.push_back("Spooky (episode 3 only)");
+			a.enumValueNames.push_back("Industrial");
+			a.enumValueNames.push_back("Custom (back6.wr)");
+			a.enumValueNames.push_back("Custom (back7.wr)");
+			a.enumValueNames.push_back("Custom (back8.wr)");
+		}
+		{
+			assert(attrs.size() == ATTR_BACKDROP); // make sure compile-time index is correct
+			attrs.emplace_back();
+			auto& a = attrs.back();
+			a.type = Attribute::Type::Enum;
+			a.name = "Backdrop";
+			a.desc = "Image to show behind map (overrides background colour.)";
+			a.enumValueNames.push_back("None (use background colour)");
+			a.enumValueNames.push_back("Custom (drop1.wr)");
+			a.enumValueNames.push_back("Cave (episodes 2-3 only)");
+			a.enumValueNames.push_back("Desert");
+			a.enumValueNames.push_back("Mountain");
+			a.enumValueNames.push_back("Custom (drop5.wr)");
+			a.enumValueNames.push_back("Custom (drop6.wr)");
+			a.enumValueNames.push_back("Custom (drop7.wr)");
+		}
+
+		return attrs;
+	}();
+	return schema;
+}
+
 class Map_WordRescue: public MapCore, public Map2DCore
 {
 	public:
@@ -818,67 +854,11 @@ class Map_WordRescue: public MapCore, public Map2DCore
 				>> u16le(ptEnd.y)
 			;
 
-			{
-				assert(this->v_attributes.size() == ATTR_BGCOLOUR); // make sure compile-time index is correct
-				this->v_attributes.emplace_back();
-				auto& a = this->v_attributes.back();
-				a.type = Attribute::Type::Enum;
-				a.name = "Background colour";
-				a.desc = "Colour to draw where there are no tiles.  Only used if "
-					"backdrop is not set.";
-				a.enumValue = bgColour;
-				a.enumValueNames.push_back("EGA 0 - Black");
-				a.enumValueNames.push_back("EGA 1 - Dark blue");
-				a.enumValueNames.push_back("EGA 2 - Dark green");
-				a.enumValueNames.push_back("EGA 3 - Dark cyan");
-				a.enumValueNames.push_back("EGA 4 - Dark red");
-				a.enumValueNames.push_back("EGA 5 - Dark magenta");
-				a.enumValueNames.push_back("EGA 6 - Brown");
-				a.enumValueNames.push_back("EGA 7 - Light grey");
-				a.enumValueNames.push_back("EGA 8 - Dark grey");
-				a.enumValueNames.push_back("EGA 9 - Light blue");
-				a.enumValueNames.push_back("EGA 10 - Light green");
-				a.enumValueNames.push_back("EGA 11 - Light cyan");
-				a.enumValueNames.push_back("EGA 12 - Light red");
-				a.enumValueNames.push_back("EGA 13 - Light magenta");
-				a.enumValueNames.push_back("EGA 14 - Yellow");
-				a.enumValueNames.push_back("EGA 15 - White");
-			};
-			{
-				assert(this->v_attributes.size() == ATTR_TILESET); // make sure compile-time index is correct
-				this->v_attributes.emplace_back();
-				auto& a = this->v_attributes.back();
-				a.type = Attribute::Type::Enum;
-				a.name = "Tileset";
-				a.desc = "Tileset to use for this map.";
-				if (tileset > 0) tileset--; // just in case it *is* ever zero
-				a.enumValue = tileset;
-				a.enumValueNames.push_back("Desert");
-				a.enumValueNames.push_back("Castle");
-				a.enumValueNames.push_back("Suburban");
-				a.enumValueNames.push_back("Spooky (episode 3 only)");
-				a.enumValueNames.push_back("Industrial");
-				a.enumValueNames.push_back("Custom (back6.wr)");
-				a.enumValueNames.push_back("Custom (back7.wr)");
-				a.enumValueNames.push_back("Custom (back8.wr)");
-			};
-			{
-				assert(this->v_attributes.size() == ATTR_BACKDROP); // make sure compile-time index is correct
-				this->v_attributes.emplace_back();
-				auto& a = this->v_attributes.back();
-				a.type = Attribute::Type::Enum;
-				a.name = "Backdrop";
-				a.desc = "Image to show behind map (overrides background colour.)";
-				a.enumValue = backdrop;
-				a.enumValueNames.push_back("None (use background colour)");
-				a.enumValueNames.push_back("Custom (drop1.wr)");
-				a.enumValueNames.push_back("Cave (episodes 2-3 only)");
-				a.enumValueNames.push_back("Desert");
-				a.enumValueNames.push_back("Mountain");
-				a.enumValueNames.push_back("Custom (drop5.wr)");
-				a.enumValueNames.push_back("Custom (drop6.wr)");
-				a.enumValueNames.push_back("Custom (drop7.wr)");
-			};
+			if (tileset > 0) tileset--; // just in case it *is* ever zero
+			this->attributesFromSchema(attributeSchemaWordRescue());
+			this->attributeValue(ATTR_BGCOLOUR, bgColour);
+			this->attributeValue(ATTR_TILESET, tileset);
+			this->attributeValue(ATTR_BACKDROP, backdrop);
 
 			// Read data for each layer
 			auto layerOS = std::make_shared<Layer_WR_Object_Small>(*this->content,
@@ -902,21 +882,12 @@ class Map_WordRescue: public MapCore, public Map2DCore
 		virtual void flush()
 		{
 			assert(this->v_layers.size() == 4);
-			assert(this->v_attributes.size() == 3);
 
 			this->content->seekp(0, stream::start);
 
-			auto& attrBG = this->v_attributes[ATTR_BGCOLOUR];
-			assert(attrBG.type == Attribute::Type::Enum);
-			uint16_t bgColour = attrBG.enumValue;
-
-			auto& attrTileset = this->v_attributes[ATTR_TILESET];
-			assert(attrTileset.type == Attribute::Type::Enum);
-			uint16_t tileset = attrTileset.enumValue + 1;
-
-			auto& attrBackdrop = this->v_attributes[ATTR_BACKDROP];
-			assert(attrBackdrop.type == Attribute::Type::Enum);
-			uint16_t backdrop = attrBackdrop.enumValue;
+			uint16_t bgColour = this->attributeNumber(ATTR_BGCOLOUR);
+			uint16_t tileset = this->attributeNumber(ATTR_TILESET) + 1;
+			uint16_t backdrop = this->attributeNumber(ATTR_BACKDROP);
 
 			std::vector<Point> itemLocations[INDEX_SIZE];
 			struct DripData {
@@ -933,7 +904,7 @@ class Map_WordRescue: public MapCore, public Map2DCore
 			Point ptStart{0, 0}, ptEnd{0, 0};
 
 			auto layerOS = this->v_layers[1];
-			for (auto& t : layerOS->items()) {
+			for (auto& t : layerOS->itemView()) {
 				switch (t.code & 0xFFFF) {
 					case WR_CODE_GRUZZLE: itemLocations[INDEX_GRUZZLE].push_back(t.pos); break;
 					case WR_CODE_DRIP: {
@@ -954,7 +925,7 @@ class Map_WordRescue: public MapCore, public Map2DCore
 			}
 
 			auto layerOL = this->v_layers[2];
-			for (auto& t : layerOL->items()) {
+			for (auto& t : layerOL->itemView()) {
 				switch (t.code) {
 					case WR_CODE_SLIME:   itemLocations[INDEX_SLIME].push_back(t.pos); break;
 					case WR_CODE_BOOK:    itemLocations[INDEX_BOOK].push_back(t.pos); break;
@@ -1030,12 +1001,12 @@ class Map_WordRescue: public MapCore, public Map2DCore
 			std::map<ImagePurpose, GraphicsFilename> gf;
 			gf[ImagePurpose::BackgroundTileset1] = GraphicsFilename{
 				createString("back"
-					<< (int)(this->v_attributes[ATTR_TILESET].enumValue + 1)
+					<< this->attributeNumber(ATTR_TILESET) + 1
 					<< ".wr"),
 				"tls-wordresc"
 			};
 
-			unsigned int dropNum = this->v_attributes[ATTR_BACKDROP].enumValue;
+			unsigned int dropNum = this->attributeNumber(ATTR_BACKDROP);
 			if (dropNum > 0) {
 				gf[ImagePurpose::BackgroundImage] = GraphicsFilename{
 					createString("drop" << dropNum << ".wr"),
@@ -1072,10 +1043,10 @@ class Map_WordRescue: public MapCore, public Map2DCore
 
 		Background background(const TilesetCollection& tileset) const
 		{
-			unsigned int dropNum = this->v_attributes[ATTR_BACKDROP].enumValue;
+			unsigned int dropNum = this->attributeNumber(ATTR_BACKDROP);
 			if (dropNum > 0) return this->backgroundUseBGImage(tileset);
 
-			unsigned int bgColour = this->v_attributes[ATTR_BGCOLOUR].enumValue;
+			unsigned int bgColour = this->attributeNumber(ATTR_BGCOLOUR);
 			auto pal = createPalette_DefaultEGA();
 			Background bg;
 			bg.att = Background::Attachment::SingleColour;
@@ -1213,7 +1184,7 @@ std::unique_ptr<Map> MapType_WordRescue::create(
 std::unique_ptr<Map> MapType_WordRescue::open(
 	std::unique_ptr<stream::inout> content, SuppData& suppData) const
 {
-	return std::make_unique<Map_WordRescue>(std::move(content));
+	return openPacked<Map_WordRescue>(std::move(content));
 }
 
 SuppFilenames MapType_WordRescue::getRequiredSupps(stream::input& content,
@@ -21,6 +21,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <list>
@@ -55,6 +56,12 @@
 /// Object number for the player ("hero") object
 #define SW_OBJCODE_PLAYER 0
 
+/// Value for TileCode::tilesetIndex when the DMA file has no such tile
+#define SW_NO_TILESET 0xFF
+
+/// Width and height of each block when transposing the background layer
+#define SW_TRANSPOSE_BLOCK 16
+
 namespace camoto {
 namespace gamemaps {
 
@@ -84,6 +91,41 @@ GameData getXargonData()
 	return gdXargon;
 }
 
+/// Transpose a grid of tile codes.
+/**
+ * The grid is processed in small square blocks, so both the reads and the
+ * writes stay within a few cache lines at a time.
+ *
+ * @param src
+ *   Grid to read, srcWidth codes per row.
+ *
+ * @param dst
+ *   Grid to write, srcHeight codes per row.
+ *
+ * @param srcWidth
+ *   Number of codes in each row of src.
+ *
+ * @param srcHeight
+ *   Number of rows in src.
+ */
+static void transposeTiles(const uint16_t *src, uint16_t *dst,
+	unsigned int srcWidth, unsigned int srcHeight)
+{
+	for (unsigned int by = 0; by < srcHeight; by += SW_TRANSPOSE_BLOCK) {
+		unsigned int ey = std::min(by + SW_TRANSPOSE_BLOCK, srcHeight);
+		for (unsigned int bx = 0; bx < srcWidth; bx += SW_TRANSPOSE_BLOCK) {
+			unsigned int ex = std::min(bx + SW_TRANSPOSE_BLOCK, srcWidth);
+			for (unsigned int y = by; y < ey; y++) {
+				const uint16_t *s = src + y * srcWidth;
+				for (unsigned int x = bx; x < ex; x++) {
+					dst[x * srcHeight + y] = s[x];
+				}
+			}
+		}
+	}
+	return;
+}
+
 class Layer_Sweeney_Background: public Map2DCore::LayerCore
 {
 	public:
@@ -107,6 +149,9 @@ class Layer_Sweeney_Background: public Map2DCore::LayerCore
 				;
 
 				tc.tilesetIndex &= 0x3F;
+				if (mapCode >= this->dmaMap.size()) {
+					this->dmaMap.resize(mapCode + 1, TileCode{SW_NO_TILESET, 0});
+				}
 				this->dmaMap[mapCode] = tc;
 
 				// Skip name
@@ -114,29 +159,51 @@ class Layer_Sweeney_Background: public Map2DCore::LayerCore
 				len -= 7 + namelen;
 			} while (len > 7);
 
+			// Any tile listed in the DMA file can be placed
+			for (unsigned int i = 0; i < this->dmaMap.size(); i++) {
+				if (this->dmaMap[i].tilesetIndex == SW_NO_TILESET) continue;
 
-			// Read the background layer
-			this->v_allItems.reserve(SW_MAP_WIDTH * SW_MAP_HEIGHT);
-
-			for (unsigned int x = 0; x < SW_MAP_WIDTH; x++) {
-				for (unsigned int y = 0; y < SW_MAP_HEIGHT; y++) {
-					uint16_t code;
-					content >> u16le(code);
-
-					// Don't push zero codes (these will "show through" to the map
-					// background, which is this image tiled, prevening tiles from being
-					// completely deleted (deleting a tile just appears to set it back
-					// to the default tile.)
-					if ((code & 0x3FFF) == SW_DEFAULT_BGTILE) continue;
-
-					this->v_allItems.emplace_back();
-					auto& t = this->v_allItems.back();
-
-					t.type = Item::Type::Default;
-					t.pos.x = x;
-					t.pos.y = y;
-					t.code = code;
-				}
+				this->available.emplace_back();
+				auto& t = this->available.back();
+
+				t.type = Item::Type::Default;
+				t.pos = {0, 0};
+				t.code = i;
+			}
+
+
+			// Read the background layer.  It's stored in column-major order (each
+			// column from top to bottom, then the next column) so read it all in one
+			// go and transpose it, rather than reading one tile at a time.
+			unsigned int lenBG = this->mapSize.x * this->mapSize.y;
+			std::vector<uint8_t> raw(lenBG * 2);
+			content.read(raw.data(), raw.size());
+
+			std::vector<uint16_t> columns(lenBG);
+			for (unsigned int i = 0; i < lenBG; i++) {
+				columns[i] = raw[i * 2] | (raw[i * 2 + 1] << 8);
+			}
+			std::vector<uint16_t> tiles(lenBG);
+			transposeTiles(columns.data(), tiles.data(), this->mapSize.y,
+				this->mapSize.x);
+
+			this->v_allItems.reserve(lenBG);
+			for (unsigned int i = 0; i < lenBG; i++) {
+				auto code = tiles[i];
+
+				// Don't push zero codes (these will "show through" to the map
+				// background, which is this image tiled, prevening tiles from being
+				// completely deleted (deleting a tile just appears to set it back
+				// to the default tile.)
+				if ((code & 0x3FFF) == SW_DEFAULT_BGTILE) continue;
+
+				this->v_allItems.emplace_back();
+				auto& t = this->v_allItems.back();
+
+				t.type = Item::Type::Default;
+				t.pos.x = i % this->mapSize.x;
+				t.pos.y = i / this->mapSize.x;
+				t.code = code;
 			}
 		}
 
@@ -146,19 +213,27 @@ class Layer_Sweeney_Background: public Map2DCore::LayerCore
 
 		void flush(stream::output& content)
 		{
-			std::vector<uint16_t> tiles(this->mapSize.x * this->mapSize.y,
-				SW_DEFAULT_BGTILE);
+			unsigned int lenBG = this->mapSize.x * this->mapSize.y;
+			std::vector<uint16_t> tiles(lenBG, SW_DEFAULT_BGTILE);
 			for (auto& t : this->v_allItems) {
-				if ((t.pos.x > this->mapSize.x) || (t.pos.y > this->mapSize.y)) {
+				if ((t.pos.x >= this->mapSize.x) || (t.pos.y >= this->mapSize.y)) {
 					throw stream::error(createString("Layer has tiles outside map "
 							"boundary at (" << t.pos.x << "," << t.pos.y << ")"));
 				}
-				tiles[t.pos.x * this->mapSize.y + t.pos.y] = t.code;
+				tiles[t.pos.y * this->mapSize.x + t.pos.x] = t.code;
 			}
 
-			for (auto& code : tiles) {
-				content << u16le(code);
+			// Convert back to column-major order and write it all at once
+			std::vector<uint16_t> columns(lenBG);
+			transposeTiles(tiles.data(), columns.data(), this->mapSize.x,
+				this->mapSize.y);
+
+			std::vector<uint8_t> raw(lenBG * 2);
+			for (unsigned int i = 0; i < lenBG; i++) {
+				raw[i * 2] = columns[i] & 0xFF;
+				raw[i * 2 + 1] = columns[i] >> 8;
 			}
+			content.write(raw.data(), raw.size());
 			return;
 		}
 
@@ -183,15 +258,18 @@ class Layer_Sweeney_Background: public Map2DCore::LayerCore
 				return ret;
 			}
 
-			auto itTC = this->dmaMap.find(item.code & 0x3FFF);
-			if (itTC == this->dmaMap.end()) {
+			unsigned int dmaCode = item.code & 0x3FFF;
+			if (
+				(dmaCode >= this->dmaMap.size())
+				|| (this->dmaMap[dmaCode].tilesetIndex == SW_NO_TILESET)
+			) {
 				std::cout << "Xargon tilecode 0x" << std::hex
-					<< (unsigned int)(item.code & 0x3FFF) << std::dec
+					<< dmaCode << std::dec
 					<< " not found in DMA file.\n";
 				ret.type = ImageFromCodeInfo::ImageType::Unknown;
 				return ret;
 			}
-			auto& tc = itTC->second;
+			auto& tc = this->dmaMap[dmaCode];
 
 			auto& tilesets = t->second->files();
 
@@ -230,26 +308,18 @@ class Layer_Sweeney_Background: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
-			for (auto& i : this->dmaMap) {
-				validItems.emplace_back();
-				auto& t = validItems.back();
-
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i.first;
-			}
-			return validItems;
+			return this->available;
 		}
 
 	protected:
 		struct TileCode {
-			uint8_t tilesetIndex;
+			uint8_t tilesetIndex; ///< SW_NO_TILESET if not listed in the DMA file
 			uint8_t imageIndex;
 		};
-		std::map<uint16_t, TileCode> dmaMap;
+		std::vector<TileCode> dmaMap; ///< Tile properties, indexed by map code
+		std::vector<Item> available; ///< Tiles listed in dmaMap, as Items
 
 		Point mapSize; ///< Size of the layer, in tiles
 };
@@ -317,6 +387,15 @@ class Layer_Sweeney_Object: public Map2DCore::LayerCore
 					t.movementDistDown = 0;
 				}
 			}
+
+			for (unsigned int i = 0; i < this->gameData.numObjectTypes; i++) {
+				this->available.emplace_back();
+				auto& t = this->available.back();
+
+				t.type = Item::Type::Default;
+				t.pos = {0, 0};
+				t.code = i;
+			}
 		}
 
 		virtual ~Layer_Sweeney_Object()
@@ -325,7 +404,8 @@ class Layer_Sweeney_Object: public Map2DCore::LayerCore
 
 		void readText(stream::input& content)
 		{
-			for (auto& t : this->v_allItems) {
+			for (std::size_t i = 0; i < this->v_allItems.size(); i++) {
+				auto& t = this->v_allItems.at(i);
 				if (t.type & Item::Type::Text) {
 					try {
 						// Read a text element, if any are present
@@ -435,22 +515,14 @@ class Layer_Sweeney_Object: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
-			for (unsigned int i = 0; i < this->gameData.numObjectTypes; i++) {
-				validItems.emplace_back();
-				auto& t = validItems.back();
-
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i;
-			}
-			return validItems;
+			return this->available;
 		}
 
 	protected:
 		GameData gameData;
+		std::vector<Item> available; ///< One Item for each object type
 };
 
 
@@ -699,7 +771,7 @@ std::unique_ptr<Map> MapType_Jill::open(
 			"supplementary item.");
 	}
 
-	return std::make_unique<Map_Sweeney>(std::move(content),
+	return openPacked<Map_Sweeney>(std::move(content),
 		*(suppTileInfo->second), getJillData());
 }
 
@@ -765,7 +837,7 @@ std::unique_ptr<Map> MapType_Xargon::open(
 			"supplementary item.");
 	}
 
-	return std::make_unique<Map_Sweeney>(std::move(content),
+	return openPacked<Map_Sweeney>(std::move(content),
 		*(suppTileInfo->second), getXargonData());
 }
 
@@ -46,11 +46,89 @@
 /// Map code to write for locations with no tile set
 #define Z66_DEFAULT_BGTILE 0x00
 
+/// Largest tile code that can be stored in the tile mapping table
+#define Z66_MAX_TILECODE 0xFFFF
+
+/// Number of entries in the tile mapping table (one per possible map byte)
+#define Z66_TILEMAP_LEN 256
+
+/// Number of mapping table entries used by each tile (normal and destroyed)
+#define Z66_TILEMAP_ENTRIES_PER_TILE 2
+
+/// Maximum number of different tiles in a level, excluding the default tile
+#define Z66_MAX_UNIQUE_TILES \
+	(Z66_TILEMAP_LEN / Z66_TILEMAP_ENTRIES_PER_TILE - 1)
+
+/// Lookup value for codes not yet in the table.  Each tile starts on an even
+/// table entry, so no tile can be given this map byte.
+#define Z66_UNASSIGNED 0xFF
+
 namespace camoto {
 namespace gamemaps {
 
 using namespace camoto::gamegraphics;
 
+/// Assign each different tile code a place in the tile mapping table.
+/**
+ * Codes are looked up directly by value, so adding a tile is O(1) regardless
+ * of how many tiles are already in the table.  A new dictionary is used for
+ * each save, so the lookup array is only held while the level is written.
+ */
+class Zone66TileDictionary
+{
+	public:
+		Zone66TileDictionary()
+			:	lookup(Z66_MAX_TILECODE + 1, Z66_UNASSIGNED)
+		{
+			// The default tile is always first, so empty cells (which are written
+			// as Z66_DEFAULT_BGTILE) map back to it.
+			this->index(Z66_DEFAULT_BGTILE);
+		}
+
+		/// Get the map byte for a tile code, adding it to the table if needed.
+		/**
+		 * @param code
+		 *   Tile code to look up.
+		 *
+		 * @return The value to write into the map for this tile.
+		 *
+		 * @throw stream::error if the code cannot be stored, or the table is full.
+		 */
+		uint8_t index(unsigned int code)
+		{
+			if (code > Z66_MAX_TILECODE) {
+				throw stream::error(createString("Tile code " << code
+					<< " is too large to be stored in a Zone 66 level."));
+			}
+			auto& e = this->lookup[code];
+			if (e == Z66_UNASSIGNED) {
+				if (
+					this->codes.size() + Z66_TILEMAP_ENTRIES_PER_TILE > Z66_TILEMAP_LEN
+				) {
+					throw stream::error(createString("There are too many unique tiles "
+						"in this level - Zone 66 only supports up to "
+						<< Z66_MAX_UNIQUE_TILES << " different tiles in each level.  "
+						"Please remove some tiles and try again."));
+				}
+				e = this->codes.size();
+				this->codes.push_back(code); // normal tile
+				/// @todo Use the correct "destroyed" tile code
+				this->codes.push_back(code); // destroyed tile
+			}
+			return e;
+		}
+
+		/// Mapping table entries, in the order they should be written.
+		const std::vector<unsigned int>& table() const
+		{
+			return this->codes;
+		}
+
+	private:
+		std::vector<uint8_t> lookup;     ///< Map byte for each tile code
+		std::vector<unsigned int> codes; ///< Mapping table entries
+};
+
 class Layer_Zone66_Background: public Map2DCore::LayerCore
 {
 	public:
@@ -94,50 +172,29 @@ class Layer_Zone66_Background: public Map2DCore::LayerCore
 		void flush(stream::output& content, stream::output& tilemap)
 		{
 			// Write the background layer
-			unsigned int numTileMappings = 0;
-			unsigned int mapBG[256];
-
+			Zone66TileDictionary dict;
 			std::vector<uint8_t> bg(Z66_LAYER_LEN_BG, Z66_DEFAULT_BGTILE);
-			for (auto& i : this->items()) {
-				if ((i.pos.x > Z66_MAP_WIDTH) || (i.pos.y > Z66_MAP_HEIGHT)) {
+			for (auto& i : this->itemView()) {
+				if (
+					(i.pos.x < 0) || (i.pos.x >= Z66_MAP_WIDTH)
+					|| (i.pos.y < 0) || (i.pos.y >= Z66_MAP_HEIGHT)
+				) {
 					throw stream::error("Layer has tiles outside map boundary!");
 				}
-
-				// Look for an existing tile mapping first
-				bool found = false;
-				for (unsigned int m = 0; m < numTileMappings; m++) {
-					if (mapBG[m] == i.code) {
-						bg[i.pos.y * Z66_MAP_WIDTH + i.pos.x] = m;
-						found = true;
-						break;
-					}
-				}
-				if (!found) {
-					// Have to add this tile to the mapping table
-					if (numTileMappings >= 256) {
-						throw stream::error("There are too many unique tiles in this level - "
-							"Zone 66 only supports up to 256 different tiles in each level.  "
-							"Please remove some tiles and try again.");
-					}
-					bg[i.pos.y * Z66_MAP_WIDTH + i.pos.x] = numTileMappings;
-					mapBG[numTileMappings++] = i.code;
-					/// @todo Use the correct "destroyed" tile code
-					mapBG[numTileMappings++] = i.code;
-				}
+				bg[i.pos.y * Z66_MAP_WIDTH + i.pos.x] = dict.index(i.code);
 			}
 			content.write(bg.data(), Z66_LAYER_LEN_BG);
 
 			// Write the tile mapping table
+			auto& mapBG = dict.table();
+			unsigned int numTileMappings = mapBG.size();
 			tilemap.seekp(0, stream::start);
 			tilemap
 				<< u16le(numTileMappings)
 				<< u16le(0) /// @todo Animated tiles
 			;
-			for (unsigned int i = 0; i < numTileMappings; i++) {
-				tilemap
-					<< u16le(mapBG[i * 2])      // normal tile
-					<< u16le(mapBG[i * 2 + 1])  // destroyed tile
-				;
+			for (auto& i : mapBG) {
+				tilemap << u16le(i);
 			}
 
 			/// @todo Write correct values for tile points/score
@@ -158,6 +215,27 @@ class Layer_Zone66_Background: public Map2DCore::LayerCore
 			return "Background";
 		}
 
+		virtual unsigned int countUniqueCodes(ConstView<Item> items,
+			unsigned int *maxCount) const
+		{
+			*maxCount = Z66_MAX_UNIQUE_TILES;
+
+			// The default tile is not counted as it is always in the table.
+			std::vector<bool> seen(Z66_MAX_TILECODE + 1, false);
+			seen[Z66_DEFAULT_BGTILE] = true;
+			unsigned int count = 0;
+			for (auto& i : items) {
+				if (i.code > Z66_MAX_TILECODE) {
+					count++; // won't be saved, but still needs to be counted
+					continue;
+				}
+				if (seen[i.code]) continue;
+				seen[i.code] = true;
+				count++;
+			}
+			return count;
+		}
+
 		virtual Caps caps() const
 		{
 			return Caps::Default;
@@ -185,22 +263,24 @@ class Layer_Zone66_Background: public Map2DCore::LayerCore
 			return ret;
 		}
 
-		virtual std::vector<Item> availableItems() const
+		virtual const std::vector<Item>& availableItems() const
 		{
-			std::vector<Item> validItems;
+			static const std::vector<Item> available = []() -> std::vector<Item> {
+				std::vector<Item> validItems;
 /// @todo Add all tiles instead of just ones already in the map, and rewrite the map on save
-			for (unsigned int i = 0; i < 300; i++) {
-				if (i == Z66_DEFAULT_BGTILE) continue;
-
-				Item t;
-				t.type = Item::Type::Default;
-				t.pos = {0, 0};
-				t.code = i;
-				validItems.push_back(t);
-			}
-			return validItems;
+				for (unsigned int i = 0; i < 300; i++) {
+					if (i == Z66_DEFAULT_BGTILE) continue;
+
+					Item t;
+					t.type = Item::Type::Default;
+					t.pos = {0, 0};
+					t.code = i;
+					validItems.push_back(t);
+				}
+				return validItems;
+			}();
+			return available;
 		}
-
 };
 
 class Map_Zone66: public MapCore, public Map2DCore
@@ -232,7 +312,7 @@ class Map_Zone66: public MapCore, public Map2DCore
 
 		virtual void flush()
 		{
-			assert(this->layers().size() == 1);
+			assert(this->v_layers.size() == 1);
 
 			this->content->truncate(Z66_LAYER_LEN_BG);
 			this->content->seekp(0, stream::start);
@@ -326,7 +406,7 @@ std::unique_ptr<Map> MapType_Zone66::open(
 	if (tilemap == suppData.end()) {
 		throw stream::error("Missing content for layer: Extra1");
 	}
-	return std::make_unique<Map_Zone66>(std::move(content),
+	return openPacked<Map_Zone66>(std::move(content),
 		std::move(tilemap->second));
 }
 
@@ -0,0 +1,108 @@
+/**
+ * @file  hash.hpp
+ * @brief Hash functions shared by the fingerprint and cache code.
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _CAMOTO_GAMEMAPS_HASH_HPP_
+#define _CAMOTO_GAMEMAPS_HASH_HPP_
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+
+namespace camoto {
+namespace gamemaps {
+
+/// Scramble the bits of a 64-bit value (the splitmix64 finaliser.)
+inline uint64_t mix(uint64_t x)
+{
+	x ^= x >> 30;
+	x *= 0xBF58476D1CE4E5B9ULL;
+	x ^= x >> 27;
+	x *= 0x94D049BB133111EBULL;
+	x ^= x >> 31;
+	return x;
+}
+
+/// 128-bit hash of a sequence of byte blocks.
+/**
+ * The input is read eight bytes at a time into two independently seeded
+ * lanes.  Each block passed to add() is prefixed with its length, so moving
+ * bytes from one block into the next changes the hash.
+ */
+class ByteHash
+{
+	public:
+		ByteHash()
+			:	a(0x9E3779B97F4A7C15ULL),
+				b(0xC2B2AE3D27D4EB4FULL)
+		{
+		}
+
+		/// Add a block of bytes.
+		void add(const uint8_t *data, std::size_t len)
+		{
+			this->word(len);
+			for (; len >= 8; data += 8, len -= 8) {
+				uint64_t w = 0;
+				for (int i = 7; i >= 0; i--) w = (w << 8) | data[i];
+				this->word(w);
+			}
+			if (len) {
+				uint64_t w = 0;
+				for (std::size_t i = len; i > 0; i--) w = (w << 8) | data[i - 1];
+				this->word(w);
+			}
+			return;
+		}
+
+		/// Add a string as a block.
+		void add(const std::string& s)
+		{
+			this->add((const uint8_t *)s.data(), s.length());
+			return;
+		}
+
+		/// Get the hash as 32 lowercase hex digits.
+		std::string hex() const
+		{
+			static const char digits[] = "0123456789abcdef";
+			std::string s(32, '0');
+			for (int i = 0; i < 16; i++) {
+				s[15 - i] = digits[(this->a >> (i * 4)) & 0xF];
+				s[31 - i] = digits[(this->b >> (i * 4)) & 0xF];
+			}
+			return s;
+		}
+
+	private:
+		void word(uint64_t w)
+		{
+			this->a = mix(this->a ^ w) + 0x632BE59BD9B4E019ULL;
+			this->b = mix(this->b + w * 0xFF51AFD7ED558CCDULL) ^ this->a;
+			return;
+		}
+
+		uint64_t a;  ///< First lane
+		uint64_t b;  ///< Second lane, also mixed with the first
+};
+
+} // namespace gamemaps
+} // namespace camoto
+
+#endif // _CAMOTO_GAMEMAPS_HASH_HPP_
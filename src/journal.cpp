@@ -0,0 +1,1035 @@
+/**
+ * @file  journal.cpp
+ * @brief Undo/redo journal for edits made to a Map2D.
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <camoto/stream.hpp>
+#include <camoto/util.hpp>
+#include <camoto/gamemaps/journal.hpp>
+#include <camoto/gamemaps/util.hpp>
+#include "map2d-core.hpp"
+
+namespace camoto {
+namespace gamemaps {
+
+/// Key used to look up a cell in the cell index.
+static inline unsigned long long cellKey(const Point& pos)
+{
+	return ((unsigned long long)(uint32_t)pos.x << 32) | (uint32_t)pos.y;
+}
+
+/// Key used to sort positions in the code index, in row order.
+static inline unsigned long long rowKey(const Point& pos)
+{
+	return ((unsigned long long)(uint32_t)pos.y << 32) | (uint32_t)pos.x;
+}
+
+/// Convert a key from rowKey() back into a position.
+static inline Point rowKeyToPoint(unsigned long long key)
+{
+	Point pos;
+	pos.x = (int32_t)(uint32_t)(key & 0xFFFFFFFF);
+	pos.y = (int32_t)(uint32_t)(key >> 32);
+	return pos;
+}
+
+/// Replace one item index with another in a cell's list.
+static void replaceIndex(std::vector<std::size_t>& list, std::size_t from,
+	std::size_t to)
+{
+	auto i = std::find(list.begin(), list.end(), from);
+	assert(i != list.end());
+	*i = to;
+	return;
+}
+
+/// Remove an item index from a cell's list.
+static void eraseIndex(std::vector<std::size_t>& list, std::size_t index)
+{
+	auto i = std::find(list.begin(), list.end(), index);
+	assert(i != list.end());
+	list.erase(i);
+	return;
+}
+
+/// A layer's items, read and changed without lending them out.
+/**
+ * Layer::items() lends the list for good (see SharedItems::lend()), after
+ * which every snapshot of the map has to copy it.  The journal only needs the
+ * items for the length of one edit, so for layers built on LayerCore it uses
+ * the shared list directly.  Snapshots taken between edits then share the
+ * items, until the next edit copies them.
+ *
+ * References returned by operator[] and at() are only valid until the list is
+ * next changed.
+ */
+class EditJournal::Items
+{
+	public:
+		/// Use a layer's shared list.
+		Items(SharedItems *shared)
+			:	shared(shared),
+				plain(nullptr)
+		{
+		}
+
+		/// Use the list from Layer::items(), for layers not built on LayerCore.
+		Items(std::vector<Item> *plain)
+			:	shared(nullptr),
+				plain(plain)
+		{
+		}
+
+		std::size_t size() const
+		{
+			return this->shared ? this->shared->size() : this->plain->size();
+		}
+
+		/// Get all the items for reading.
+		ConstView<Item> view() const
+		{
+			if (this->shared) return this->shared->get();
+			return *this->plain;
+		}
+
+		/// Get an item for reading.
+		const Item& operator[](std::size_t index) const
+		{
+			return this->view()[index];
+		}
+
+		/// Get an item for modification.
+		Item& at(std::size_t index)
+		{
+			if (this->shared) return this->shared->at(index);
+			return (*this->plain)[index];
+		}
+
+		void push_back(const Item& item)
+		{
+			if (this->shared) this->shared->push_back(item);
+			else this->plain->push_back(item);
+		}
+
+		void pop_back()
+		{
+			if (this->shared) this->shared->pop_back();
+			else this->plain->pop_back();
+		}
+
+	private:
+		SharedItems *shared;
+		std::vector<Item> *plain;
+};
+
+/// Keep a group open until the end of the current scope, even if it throws.
+class GroupGuard
+{
+	public:
+		GroupGuard(EditJournal& journal)
+			:	journal(journal)
+		{
+			this->journal.beginGroup();
+		}
+
+		~GroupGuard()
+		{
+			this->journal.endGroup();
+		}
+
+	private:
+		EditJournal& journal;
+};
+
+EditJournal::EditJournal(std::shared_ptr<Map2D> map)
+	:	map(map),
+		layers(map->layers()),
+		groupDepth(0),
+		groupStarted(false)
+{
+	this->cells.resize(this->layers.size());
+	this->codes.resize(this->layers.size());
+	this->hashes.resize(this->layers.size());
+	this->generations.resize(this->layers.size());
+}
+
+void EditJournal::beginGroup()
+{
+	if (this->groupDepth++ == 0) this->groupStarted = false;
+	this->map->beginUpdate();
+	return;
+}
+
+void EditJournal::endGroup()
+{
+	assert(this->groupDepth > 0);
+	if (this->groupDepth > 0) {
+		this->groupDepth--;
+		this->map->endUpdate();
+	}
+	return;
+}
+
+void EditJournal::setCell(unsigned int layer, const Point& pos,
+	unsigned int code)
+{
+	auto idx = this->cellIndex(layer);
+	auto cell = idx->find(cellKey(pos));
+	if ((cell == idx->end()) || cell->second.empty()) {
+		// Nothing here yet
+		if (code == INVALID_TILECODE) return;
+		Item t = Item();
+		t.type = Item::Type::Default;
+		t.pos = pos;
+		t.code = code;
+		this->insertItem(layer, t);
+		return;
+	}
+
+	auto index = cell->second.front();
+	if (code == INVALID_TILECODE) {
+		this->removeItem(layer, index);
+		return;
+	}
+
+	this->changeCode(layer, index, code);
+	return;
+}
+
+std::size_t EditJournal::insertItem(unsigned int layer, const Item& item)
+{
+	Op op = Op();
+	op.kind = Op::Kind::Insert;
+	op.layer = layer;
+	op.index = this->doInsert(layer, item);
+	op.item = std::make_shared<const Item>(item);
+	this->record(std::move(op));
+	return this->items(layer).size() - 1;
+}
+
+void EditJournal::removeItem(unsigned int layer, std::size_t index)
+{
+	Op op = Op();
+	op.kind = Op::Kind::Remove;
+	op.layer = layer;
+	op.index = index;
+	op.item = std::make_shared<const Item>(this->doRemove(layer, index));
+	this->record(std::move(op));
+	return;
+}
+
+void EditJournal::moveItem(unsigned int layer, std::size_t index,
+	const Point& pos)
+{
+	auto items = this->items(layer);
+	if (index >= items.size()) {
+		throw camoto::error("Tried to move an item that doesn't exist.");
+	}
+	Op op = Op();
+	op.kind = Op::Kind::Move;
+	op.layer = layer;
+	op.index = index;
+	op.posOld = items[index].pos;
+	op.posNew = pos;
+	this->map->beginUpdate();
+	this->doMove(layer, index, pos);
+	this->map->endUpdate();
+	this->record(std::move(op));
+	return;
+}
+
+std::vector<Point> EditJournal::findCode(unsigned int layer,
+	unsigned int code)
+{
+	std::vector<Point> found;
+	auto idx = this->codeIndex(layer);
+	auto c = idx->find(code);
+	if (c == idx->end()) return found;
+
+	found.reserve(c->second.size());
+	unsigned long long last = 0;
+	for (auto key : c->second) {
+		// Several items with the same code in one cell count as one cell
+		if (!found.empty() && (key == last)) continue;
+		found.push_back(rowKeyToPoint(key));
+		last = key;
+	}
+	return found;
+}
+
+std::size_t EditJournal::countCode(unsigned int layer, unsigned int code)
+{
+	auto idx = this->codeIndex(layer);
+	auto c = idx->find(code);
+	if (c == idx->end()) return 0;
+	return c->second.size();
+}
+
+std::map<unsigned int, std::size_t> EditJournal::codeUsage(unsigned int layer)
+{
+	std::map<unsigned int, std::size_t> usage;
+	for (auto& c : *this->codeIndex(layer)) {
+		if (!c.second.empty()) usage[c.first] = c.second.size();
+	}
+	return usage;
+}
+
+std::size_t EditJournal::replaceCode(unsigned int layer, unsigned int from,
+	unsigned int to)
+{
+	if (from == to) return 0;
+	auto codes = this->codeIndex(layer);
+	auto c = codes->find(from);
+	if (c == codes->end()) return 0;
+
+	// Take a copy, as the list changes as each item is updated
+	std::vector<unsigned long long> keys(c->second.begin(), c->second.end());
+	keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+	GroupGuard group(*this);
+	auto& target = this->layers[layer];
+	auto items = this->items(layer);
+	auto cells = this->cellIndex(layer);
+	std::size_t count = 0;
+	for (auto key : keys) {
+		auto pos = rowKeyToPoint(key);
+		auto cell = cells->find(cellKey(pos));
+		if (cell == cells->end()) continue;
+		for (auto i : cell->second) {
+			auto& item = items[i];
+			if (item.code != from) continue;
+
+			Item replacement = item;
+			replacement.code = to;
+			unsigned int maxCount;
+			if (!target->tilePermittedAt(replacement, pos, &maxCount)) continue;
+
+			this->changeCode(layer, i, to);
+			count++;
+		}
+	}
+	return count;
+}
+
+uint64_t EditJournal::fingerprint(unsigned int layer)
+{
+	auto hash = this->layerHash(layer);
+	Point layerSize, tileSize;
+	getLayerDims(*this->map, *this->layers[layer], &layerSize, &tileSize);
+	return hash->value(layerSize);
+}
+
+uint64_t EditJournal::fingerprint()
+{
+	std::vector<uint64_t> layerHashes;
+	layerHashes.reserve(this->layers.size());
+	for (unsigned int l = 0; l < this->layers.size(); l++) {
+		layerHashes.push_back(this->fingerprint(l));
+	}
+	return combineFingerprints(layerHashes, this->map->attributes());
+}
+
+EditJournal::Region EditJournal::copyRegion(unsigned int layer,
+	const Point& pos, const Point& size)
+{
+	Region region;
+	region.size = size;
+
+	Point cpos = pos, csize = size;
+	if (!this->clip(layer, &cpos, &csize)) return region;
+
+	auto items = this->items(layer);
+	auto idx = this->cellIndex(layer);
+	Point cell;
+	for (cell.y = cpos.y; cell.y < cpos.y + csize.y; cell.y++) {
+		for (cell.x = cpos.x; cell.x < cpos.x + csize.x; cell.x++) {
+			auto c = idx->find(cellKey(cell));
+			if (c == idx->end()) continue;
+			for (auto i : c->second) {
+				region.items.push_back(items[i]);
+				auto& copy = region.items.back();
+				copy.pos.x -= pos.x;
+				copy.pos.y -= pos.y;
+			}
+		}
+	}
+	return region;
+}
+
+void EditJournal::pasteRegion(unsigned int layer, const Point& pos,
+	const Region& region, bool transparent)
+{
+	if ((region.size.x <= 0) || (region.size.y <= 0)) {
+		throw stream::error(createString("Can't paste a block of "
+			<< region.size.x << "x" << region.size.y << " tiles."));
+	}
+	Point cpos = pos, csize = region.size;
+	if (!this->clip(layer, &cpos, &csize)) return;
+
+	// Sort the block's items by cell first, so each cell can be looked up
+	// directly instead of searching the whole block.  Only the part of the
+	// block that lands inside the layer is kept.
+	std::vector<std::vector<const Item *>> incoming(
+		(std::size_t)csize.x * csize.y);
+	for (auto& i : region.items) {
+		if (
+			(i.pos.x < 0) || (i.pos.x >= region.size.x)
+			|| (i.pos.y < 0) || (i.pos.y >= region.size.y)
+		) continue;
+		Point cell;
+		cell.x = pos.x + i.pos.x - cpos.x;
+		cell.y = pos.y + i.pos.y - cpos.y;
+		if (
+			(cell.x < 0) || (cell.x >= csize.x)
+			|| (cell.y < 0) || (cell.y >= csize.y)
+		) continue;
+		incoming[cell.y * csize.x + cell.x].push_back(&i);
+	}
+
+	GroupGuard group(*this);
+	auto& target = this->layers[layer];
+	auto idx = this->cellIndex(layer);
+	std::vector<const Item *> permitted;
+	Point cell;
+	for (cell.y = cpos.y; cell.y < cpos.y + csize.y; cell.y++) {
+		for (cell.x = cpos.x; cell.x < cpos.x + csize.x; cell.x++) {
+			auto& from = incoming[(cell.y - cpos.y) * csize.x + (cell.x - cpos.x)];
+			permitted.clear();
+			for (auto i : from) {
+				unsigned int maxCount;
+				if (target->tilePermittedAt(*i, cell, &maxCount)) {
+					permitted.push_back(i);
+				}
+			}
+			if (permitted.empty()) {
+				if (!transparent) this->clearCell(layer, cell);
+				continue;
+			}
+
+			// A plain tile replacing a plain tile only needs its code changed
+			auto existing = idx->find(cellKey(cell));
+			if (
+				(permitted.size() == 1)
+				&& (permitted[0]->type == Item::Type::Default)
+				&& (existing != idx->end())
+				&& (existing->second.size() == 1)
+				&& (this->items(layer)[existing->second[0]].type
+					== Item::Type::Default)
+			) {
+				this->setCell(layer, cell, permitted[0]->code);
+				continue;
+			}
+
+			this->clearCell(layer, cell);
+			for (auto i : permitted) {
+				Item copy = *i;
+				copy.pos = cell;
+				this->insertItem(layer, copy);
+			}
+		}
+	}
+	return;
+}
+
+void EditJournal::fillRegion(unsigned int layer, const Point& pos,
+	const Point& size, unsigned int code)
+{
+	if (code == INVALID_TILECODE) {
+		this->clearRegion(layer, pos, size);
+		return;
+	}
+
+	Point cpos = pos, csize = size;
+	if (!this->clip(layer, &cpos, &csize)) return;
+
+	Item t = Item();
+	t.type = Item::Type::Default;
+	t.code = code;
+	std::vector<bool> permitted;
+	unsigned int maxCount;
+	this->layers[layer]->tilePermittedIn(t, cpos, csize, &permitted, &maxCount);
+	if (maxCount) {
+		// Cells already holding this code don't add another one
+		auto items = this->items(layer);
+		auto idx = this->cellIndex(layer);
+		std::size_t added = 0;
+		auto check = permitted.begin();
+		Point cell;
+		for (cell.y = cpos.y; cell.y < cpos.y + csize.y; cell.y++) {
+			for (cell.x = cpos.x; cell.x < cpos.x + csize.x; cell.x++) {
+				if (!*check++) continue;
+				auto c = idx->find(cellKey(cell));
+				if (
+					(c != idx->end()) && !c->second.empty()
+					&& (items[c->second.front()].code == code)
+				) continue;
+				added++;
+			}
+		}
+		auto existing = this->countCode(layer, code);
+		if (existing + added > maxCount) {
+			throw camoto::error(createString("Only " << maxCount
+				<< " of this tile can be placed in the level, but there are already "
+				<< existing << " and the area to fill would add " << added
+				<< " more."));
+		}
+	}
+
+	GroupGuard group(*this);
+	auto ok = permitted.begin();
+	Point cell;
+	for (cell.y = cpos.y; cell.y < cpos.y + csize.y; cell.y++) {
+		for (cell.x = cpos.x; cell.x < cpos.x + csize.x; cell.x++) {
+			if (*ok++) this->setCell(layer, cell, code);
+		}
+	}
+	return;
+}
+
+void EditJournal::clearRegion(unsigned int layer, const Point& pos,
+	const Point& size)
+{
+	Point cpos = pos, csize = size;
+	if (!this->clip(layer, &cpos, &csize)) return;
+
+	GroupGuard group(*this);
+	Point cell;
+	for (cell.y = cpos.y; cell.y < cpos.y + csize.y; cell.y++) {
+		for (cell.x = cpos.x; cell.x < cpos.x + csize.x; cell.x++) {
+			this->clearCell(layer, cell);
+		}
+	}
+	return;
+}
+
+void EditJournal::shiftRegion(unsigned int layer, const Point& pos,
+	const Point& size, const Point& offset)
+{
+	if ((size.x <= 0) || (size.y <= 0)) return;
+
+	GroupGuard group(*this);
+	auto block = this->copyRegion(layer, pos, size);
+	this->clearRegion(layer, pos, size);
+	Point dest;
+	dest.x = pos.x + offset.x;
+	dest.y = pos.y + offset.y;
+	this->pasteRegion(layer, dest, block, false);
+	return;
+}
+
+void EditJournal::setAttribute(unsigned int index, int value)
+{
+	auto& attributes = this->map->attributes();
+	if (index >= attributes.size()) {
+		throw camoto::error("Tried to change an attribute that doesn't exist.");
+	}
+	Op op = Op();
+	op.kind = Op::Kind::Attribute;
+	op.index = index;
+	auto& a = attributes[index];
+	switch (a.type) {
+		case Attribute::Type::Integer: op.attrIntOld = a.integerValue; break;
+		case Attribute::Type::Enum: op.attrIntOld = a.enumValue; break;
+		case Attribute::Type::Image: op.attrIntOld = a.imageIndex; break;
+		default:
+			throw camoto::error("Tried to set a text attribute to a number.");
+	}
+	op.attrIntNew = value;
+	this->map->attribute(index, value);
+	this->record(std::move(op));
+	return;
+}
+
+void EditJournal::setAttribute(unsigned int index, const std::string& value)
+{
+	auto& attributes = this->map->attributes();
+	if (index >= attributes.size()) {
+		throw camoto::error("Tried to change an attribute that doesn't exist.");
+	}
+	Op op = Op();
+	op.kind = Op::Kind::Attribute;
+	op.index = index;
+	auto& a = attributes[index];
+	switch (a.type) {
+		case Attribute::Type::Filename:
+			op.attrText = std::make_shared<const std::pair<std::string, std::string>>(
+				a.filenameValue, value);
+			break;
+		case Attribute::Type::Text:
+			op.attrText = std::make_shared<const std::pair<std::string, std::string>>(
+				a.textValue, value);
+			break;
+		default:
+			throw camoto::error("Tried to set a numeric attribute to a string.");
+	}
+	this->map->attribute(index, value);
+	this->record(std::move(op));
+	return;
+}
+
+void EditJournal::applyPatch(const MapPatch& patch)
+{
+	auto samePtr = [](const Item *a, const Item *b) {
+		return sameContent(*a, *b);
+	};
+
+	// Check the whole patch first, so one that doesn't fit changes nothing
+	std::vector<const Item *> current, expected;
+	for (auto& c : patch.cells) {
+		if (c.layer >= this->layers.size()) {
+			throw camoto::error("The patch refers to a layer this map doesn't "
+				"have.");
+		}
+		auto items = this->items(c.layer);
+		auto idx = this->cellIndex(c.layer);
+		current.clear();
+		auto existing = idx->find(cellKey(c.pos));
+		if (existing != idx->end()) {
+			for (auto i : existing->second) current.push_back(&items[i]);
+		}
+		expected.clear();
+		for (auto& i : c.before) expected.push_back(&i);
+		if (
+			(current.size() != expected.size())
+			|| !std::is_permutation(current.begin(), current.end(),
+				expected.begin(), samePtr)
+		) {
+			throw camoto::error(createString("Layer " << c.layer + 1
+				<< " has changed at (" << c.pos.x << "," << c.pos.y
+				<< ") since the patch was made."));
+		}
+	}
+	auto& attributes = this->map->attributes();
+	for (auto& a : patch.attributes) {
+		if (
+			(a.index >= attributes.size())
+			|| !sameValue(attributes[a.index], a.before)
+		) {
+			throw camoto::error(createString("Attribute " << a.index + 1
+				<< " has changed since the patch was made."));
+		}
+	}
+
+	GroupGuard group(*this);
+	for (auto& c : patch.cells) {
+		auto idx = this->cellIndex(c.layer);
+		auto existing = idx->find(cellKey(c.pos));
+		if (
+			(c.after.size() == 1)
+			&& (c.after[0].type == Item::Type::Default)
+			&& (existing != idx->end())
+			&& (existing->second.size() == 1)
+			&& (this->items(c.layer)[existing->second[0]].type
+				== Item::Type::Default)
+		) {
+			this->setCell(c.layer, c.pos, c.after[0].code);
+			continue;
+		}
+		this->clearCell(c.layer, c.pos);
+		for (auto& i : c.after) {
+			Item copy = i;
+			copy.pos = c.pos;
+			this->insertItem(c.layer, copy);
+		}
+	}
+	for (auto& a : patch.attributes) {
+		switch (a.after.type) {
+			case Attribute::Type::Integer:
+				this->setAttribute(a.index, a.after.integerValue);
+				break;
+			case Attribute::Type::Enum:
+				this->setAttribute(a.index, (int)a.after.enumValue);
+				break;
+			case Attribute::Type::Image:
+				this->setAttribute(a.index, a.after.imageIndex);
+				break;
+			case Attribute::Type::Filename:
+				this->setAttribute(a.index, a.after.filenameValue);
+				break;
+			case Attribute::Type::Text:
+				this->setAttribute(a.index, a.after.textValue);
+				break;
+		}
+	}
+	return;
+}
+
+bool EditJournal::canUndo() const
+{
+	return !this->undoGroups.empty();
+}
+
+bool EditJournal::canRedo() const
+{
+	return !this->redoGroups.empty();
+}
+
+void EditJournal::undo()
+{
+	if (this->groupDepth > 0) {
+		throw camoto::error("Cannot undo while a group of edits is in progress.");
+	}
+	if (this->undoGroups.empty()) return;
+
+	auto start = this->undoGroups.back();
+	this->undoGroups.pop_back();
+
+	// Reverse the edits, newest first
+	this->map->beginUpdate();
+	for (auto i = this->undoOps.size(); i > start; i--) {
+		this->apply(this->undoOps[i - 1], false);
+	}
+	this->map->endUpdate();
+
+	this->redoGroups.push_back(this->redoOps.size());
+	std::move(this->undoOps.begin() + start, this->undoOps.end(),
+		std::back_inserter(this->redoOps));
+	this->undoOps.erase(this->undoOps.begin() + start, this->undoOps.end());
+	return;
+}
+
+void EditJournal::redo()
+{
+	if (this->groupDepth > 0) {
+		throw camoto::error("Cannot redo while a group of edits is in progress.");
+	}
+	if (this->redoGroups.empty()) return;
+
+	auto start = this->redoGroups.back();
+	this->redoGroups.pop_back();
+
+	// Repeat the edits in their original order
+	this->map->beginUpdate();
+	for (auto i = start; i < this->redoOps.size(); i++) {
+		this->apply(this->redoOps[i], true);
+	}
+	this->map->endUpdate();
+
+	this->undoGroups.push_back(this->undoOps.size());
+	std::move(this->redoOps.begin() + start, this->redoOps.end(),
+		std::back_inserter(this->undoOps));
+	this->redoOps.erase(this->redoOps.begin() + start, this->redoOps.end());
+	return;
+}
+
+void EditJournal::clear()
+{
+	this->undoOps.clear();
+	this->undoGroups.clear();
+	this->redoOps.clear();
+	this->redoGroups.clear();
+	this->groupStarted = false;
+
+	// The items may have been changed behind our back, so rebuild the index
+	// next time it's needed.
+	for (auto& c : this->cells) c.reset();
+	for (auto& c : this->codes) c.reset();
+	for (auto& h : this->hashes) h.reset();
+	return;
+}
+
+void EditJournal::record(Op op)
+{
+	this->redoOps.clear();
+	this->redoGroups.clear();
+
+	if ((this->groupDepth == 0) || !this->groupStarted) {
+		this->undoGroups.push_back(this->undoOps.size());
+		this->groupStarted = this->groupDepth > 0;
+	}
+	this->undoOps.push_back(std::move(op));
+	return;
+}
+
+void EditJournal::apply(const Op& op, bool redo)
+{
+	switch (op.kind) {
+		case Op::Kind::Code:
+			this->doSetCode(op.layer, op.index, redo ? op.codeNew : op.codeOld);
+			break;
+		case Op::Kind::Insert:
+			if (redo) {
+				auto index = this->doInsert(op.layer, *op.item);
+				assert(index == op.index);
+				(void)index;
+			} else {
+				this->doRemove(op.layer, op.index);
+			}
+			break;
+		case Op::Kind::Remove:
+			if (redo) {
+				this->doRemove(op.layer, op.index);
+			} else {
+				this->doInsertAt(op.layer, op.index, *op.item);
+			}
+			break;
+		case Op::Kind::Move:
+			this->doMove(op.layer, op.index, redo ? op.posNew : op.posOld);
+			break;
+		case Op::Kind::Attribute:
+			this->setAttributeValue(op.index, op, redo);
+			break;
+	}
+	return;
+}
+
+std::size_t EditJournal::doInsert(unsigned int layer, const Item& item)
+{
+	auto items = this->items(layer);
+	std::size_t index = items.size();
+	items.push_back(item);
+	if (this->cells[layer]) {
+		(*this->cells[layer])[cellKey(item.pos)].push_back(index);
+	}
+	this->itemAdded(layer, item);
+	this->cellChanged(layer, item.pos);
+	return index;
+}
+
+EditJournal::Item EditJournal::doRemove(unsigned int layer, std::size_t index)
+{
+	auto items = this->items(layer);
+	if (index >= items.size()) {
+		throw camoto::error("Tried to remove an item that doesn't exist.");
+	}
+	auto idx = this->cells[layer].get();
+	Item removed = std::move(items.at(index));
+	if (idx) eraseIndex((*idx)[cellKey(removed.pos)], index);
+
+	// Fill the gap with the last item, so nothing else has to move
+	std::size_t last = items.size() - 1;
+	if (index != last) {
+		auto& gap = items.at(index);
+		gap = std::move(items.at(last));
+		if (idx) replaceIndex((*idx)[cellKey(gap.pos)], last, index);
+	}
+	items.pop_back();
+	this->itemRemoved(layer, removed);
+	this->cellChanged(layer, removed.pos);
+	return removed;
+}
+
+void EditJournal::doInsertAt(unsigned int layer, std::size_t index,
+	const Item& item)
+{
+	// Exact reverse of doRemove(): whatever was moved into index goes back to
+	// the end, and the removed item returns to its old place.
+	auto items = this->items(layer);
+	assert(index <= items.size());
+	auto idx = this->cells[layer].get();
+	std::size_t last = items.size();
+	if (index != last) {
+		Item moved = items[index];
+		items.push_back(moved);
+		if (idx) replaceIndex((*idx)[cellKey(moved.pos)], index, last);
+		items.at(index) = item;
+	} else {
+		items.push_back(item);
+	}
+	if (idx) (*idx)[cellKey(item.pos)].push_back(index);
+	this->itemAdded(layer, item);
+	this->cellChanged(layer, item.pos);
+	return;
+}
+
+void EditJournal::doMove(unsigned int layer, std::size_t index,
+	const Point& pos)
+{
+	auto& item = this->items(layer).at(index);
+	Point oldPos = item.pos;
+	if (this->cells[layer]) {
+		auto& idx = *this->cells[layer];
+		eraseIndex(idx[cellKey(oldPos)], index);
+		idx[cellKey(pos)].push_back(index);
+	}
+	this->itemRemoved(layer, item);
+	item.pos = pos;
+	this->itemAdded(layer, item);
+
+	// Observers may take a snapshot, which would leave item pointing at the
+	// items the snapshot now shares, so tell them only once the item is done.
+	this->cellChanged(layer, oldPos);
+	this->cellChanged(layer, pos);
+	return;
+}
+
+EditJournal::Items EditJournal::items(unsigned int layer)
+{
+	if (layer >= this->layers.size()) {
+		throw camoto::error("Tried to edit a layer that doesn't exist.");
+	}
+	auto core = dynamic_cast<Map2DCore::LayerCore*>(this->layers[layer].get());
+	if (!core) return Items(&this->layers[layer]->items());
+
+	// If anything else has replaced or fetched the items since we last did,
+	// they may no longer match the indices.
+	if (core->sharedItems().generation() != this->generations[layer]) {
+		this->cells[layer].reset();
+		this->codes[layer].reset();
+		this->hashes[layer].reset();
+	}
+	this->generations[layer] = core->sharedItems().generation();
+	return Items(&core->editItems());
+}
+
+EditJournal::CellIndex *EditJournal::cellIndex(unsigned int layer)
+{
+	auto items = this->items(layer);
+	auto& idx = this->cells[layer];
+	if (!idx) {
+		idx.reset(new CellIndex());
+		for (std::size_t i = 0; i < items.size(); i++) {
+			(*idx)[cellKey(items[i].pos)].push_back(i);
+		}
+	}
+	return idx.get();
+}
+
+EditJournal::CodeIndex *EditJournal::codeIndex(unsigned int layer)
+{
+	auto items = this->items(layer);
+	auto& idx = this->codes[layer];
+	if (!idx) {
+		idx.reset(new CodeIndex());
+		for (auto& i : items.view()) (*idx)[i.code].insert(rowKey(i.pos));
+	}
+	return idx.get();
+}
+
+LayerHash *EditJournal::layerHash(unsigned int layer)
+{
+	auto items = this->items(layer);
+	auto& hash = this->hashes[layer];
+	if (!hash) {
+		hash.reset(new LayerHash());
+		for (auto& i : items.view()) hash->add(i);
+	}
+	return hash.get();
+}
+
+void EditJournal::itemAdded(unsigned int layer, const Item& item)
+{
+	if (this->hashes[layer]) this->hashes[layer]->add(item);
+	if (!this->codes[layer]) return;
+	(*this->codes[layer])[item.code].insert(rowKey(item.pos));
+	return;
+}
+
+void EditJournal::itemRemoved(unsigned int layer, const Item& item)
+{
+	if (this->hashes[layer]) this->hashes[layer]->remove(item);
+	if (!this->codes[layer]) return;
+	auto& idx = *this->codes[layer];
+	auto c = idx.find(item.code);
+	assert(c != idx.end());
+	auto k = c->second.find(rowKey(item.pos));
+	assert(k != c->second.end());
+	c->second.erase(k); // only one instance, in case of duplicates
+	if (c->second.empty()) idx.erase(c);
+	return;
+}
+
+void EditJournal::changeCode(unsigned int layer, std::size_t index,
+	unsigned int code)
+{
+	auto& item = this->items(layer)[index];
+	if (item.code == code) return;
+
+	Op op = Op();
+	op.kind = Op::Kind::Code;
+	op.layer = layer;
+	op.index = index;
+	op.codeOld = item.code;
+	op.codeNew = code;
+	this->doSetCode(layer, index, code);
+	this->record(std::move(op));
+	return;
+}
+
+void EditJournal::doSetCode(unsigned int layer, std::size_t index,
+	unsigned int code)
+{
+	auto& item = this->items(layer).at(index);
+	this->itemRemoved(layer, item);
+	item.code = code;
+	this->itemAdded(layer, item);
+	this->cellChanged(layer, item.pos);
+	return;
+}
+
+bool EditJournal::clip(unsigned int layer, Point *pos, Point *size)
+{
+	if (layer >= this->layers.size()) {
+		throw camoto::error("Tried to edit a layer that doesn't exist.");
+	}
+	Point layerSize, tileSize;
+	getLayerDims(*this->map, *this->layers[layer], &layerSize, &tileSize);
+
+	if (pos->x < 0) {
+		size->x += pos->x;
+		pos->x = 0;
+	}
+	if (pos->y < 0) {
+		size->y += pos->y;
+		pos->y = 0;
+	}
+	if (pos->x + size->x > layerSize.x) size->x = layerSize.x - pos->x;
+	if (pos->y + size->y > layerSize.y) size->y = layerSize.y - pos->y;
+	return (size->x > 0) && (size->y > 0);
+}
+
+void EditJournal::clearCell(unsigned int layer, const Point& pos)
+{
+	auto idx = this->cellIndex(layer);
+	auto key = cellKey(pos);
+	for (;;) {
+		auto c = idx->find(key);
+		if ((c == idx->end()) || c->second.empty()) break;
+		this->removeItem(layer, c->second.back());
+	}
+	return;
+}
+
+void EditJournal::cellChanged(unsigned int layer, const Point& pos)
+{
+	Map2D::Change c = Map2D::Change();
+	c.type = Map2D::Change::Type::Items;
+	c.layer = layer;
+	c.pos = pos;
+	c.size = {1, 1};
+	this->map->changed(c);
+	return;
+}
+
+void EditJournal::setAttributeValue(unsigned int index, const Op& op,
+	bool useNew)
+{
+	if (op.attrText) {
+		this->map->attribute(index,
+			useNew ? op.attrText->second : op.attrText->first);
+	} else {
+		this->map->attribute(index, useNew ? op.attrIntNew : op.attrIntOld);
+	}
+	return;
+}
+
+} // namespace gamemaps
+} // namespace camoto
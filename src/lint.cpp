@@ -0,0 +1,250 @@
+/**
+ * @file  lint.cpp
+ * @brief Check collections of map files for problems.
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <iterator>
+#include <thread>
+#include <camoto/stream_file.hpp>
+#include <camoto/stream_string.hpp>
+#include <camoto/util.hpp>
+#include <camoto/gamemaps/lint.hpp>
+#include <camoto/gamemaps/manager.hpp>
+#include <camoto/gamemaps/util.hpp>
+
+namespace camoto {
+namespace gamemaps {
+
+/// Copy a whole file into memory.
+/**
+ * The map is opened from the copy, so nothing can be written back to the
+ * original file, and files without write permission can still be checked.
+ *
+ * @throw stream::error
+ *   The file could not be opened or read.
+ */
+static std::unique_ptr<stream::inout> readFile(const std::string& filename)
+{
+	stream::input_file file(filename);
+	auto len = file.size();
+	std::vector<uint8_t> data(len);
+	file.read(data.data(), len);
+
+	std::unique_ptr<stream::inout> content = std::make_unique<stream::string>();
+	content->write(data.data(), len);
+	content->seekp(0, stream::start);
+	return content;
+}
+
+/// Pick the handler that is most certain it can open the content.
+static MapManager::handler_t detectType(
+	const std::vector<MapManager::handler_t>& formats, stream::input& content)
+{
+	MapManager::handler_t best;
+	auto bestCert = MapType::Certainty::DefinitelyNo;
+	for (auto& t : formats) {
+		auto cert = t->isInstance(content);
+		if (cert == MapType::Certainty::DefinitelyYes) return t;
+		if (cert > bestCert) {
+			best = t;
+			bestCert = cert;
+		}
+	}
+	return best;
+}
+
+/// Check one file, using an already-fetched list of handlers.
+static std::vector<LintIssue> lintFile(const std::string& filename,
+	const std::string& type, const std::vector<MapManager::handler_t>& formats)
+{
+	std::vector<LintIssue> issues;
+	std::string mapType;
+	auto add = [&](LintIssue::Type t, const std::string& message) -> LintIssue& {
+		LintIssue issue = LintIssue();
+		issue.type = t;
+		issue.filename = filename;
+		issue.mapType = mapType;
+		issue.message = message;
+		issues.push_back(issue);
+		return issues.back();
+	};
+
+	// Anything thrown here would otherwise end the whole run, or terminate the
+	// program from a worker thread, so report it against this file instead.
+	// Errors before the file is read mean it couldn't be read, after that it
+	// was the format checks that failed.
+	auto failType = LintIssue::Type::Unreadable;
+	try {
+		std::unique_ptr<stream::inout> content;
+		try {
+			content = readFile(filename);
+		} catch (const stream::error& e) {
+			add(LintIssue::Type::Unreadable, e.what());
+			return issues;
+		}
+		failType = LintIssue::Type::NotInstance;
+
+		MapManager::handler_t handler;
+		if (type.empty()) {
+			handler = detectType(formats, *content);
+			if (!handler) {
+				add(LintIssue::Type::UnknownFormat,
+					"File is not in any supported map format.");
+				return issues;
+			}
+			mapType = handler->code();
+		} else {
+			mapType = type;
+			for (auto& t : formats) {
+				if (t->code() == type) {
+					handler = t;
+					break;
+				}
+			}
+			if (!handler) {
+				add(LintIssue::Type::UnknownFormat,
+					"There is no map handler called \"" + type + "\".");
+				return issues;
+			}
+			if (handler->isInstance(*content) == MapType::Certainty::DefinitelyNo) {
+				add(LintIssue::Type::NotInstance,
+					"File is not a valid " + handler->friendlyName() + ".");
+				return issues;
+			}
+		}
+
+		SuppData suppData;
+		for (auto& s : handler->getRequiredSupps(*content, filename)) {
+			try {
+				suppData[s.first] = readFile(s.second);
+			} catch (const stream::error& e) {
+				add(LintIssue::Type::MissingSupp, createString("Unable to open "
+					"supplemental file " << s.second << ": " << e.what()));
+			}
+		}
+
+		std::shared_ptr<Map> map;
+		try {
+			map = handler->open(std::move(content), suppData);
+		} catch (const stream::incomplete_read& e) {
+			add(LintIssue::Type::Truncated, e.what());
+			return issues;
+		} catch (const std::exception& e) {
+			add(LintIssue::Type::OpenFailed, e.what());
+			return issues;
+		}
+
+		auto map2d = std::dynamic_pointer_cast<const Map2D>(map);
+		if (!map2d) return issues;
+
+		try {
+			for (auto& p : validate(*map2d)) {
+				LintIssue::Type t;
+				std::string message;
+				switch (p.type) {
+					case PlacementProblem::Type::OutOfBounds:
+						t = LintIssue::Type::OutOfBounds;
+						message = "Item is outside the layer.";
+						break;
+					case PlacementProblem::Type::NotPermitted:
+						t = LintIssue::Type::NotPermitted;
+						message = "Item is not permitted at this position.";
+						break;
+					case PlacementProblem::Type::TooMany:
+					default:
+						t = LintIssue::Type::TooMany;
+						message = createString("Only " << p.maxCount
+							<< " items with this code are permitted.");
+						break;
+				}
+				auto& issue = add(t, message);
+				issue.layer = p.layer;
+				issue.index = p.index;
+				issue.pos = p.pos;
+				issue.code = p.code;
+				issue.maxCount = p.maxCount;
+			}
+
+			unsigned int l = 0;
+			for (auto& layer : map2d->layerView()) {
+				unsigned int maxCount;
+				auto count = layer.uniqueCodes(&maxCount);
+				if (maxCount && (count > maxCount)) {
+					auto& issue = add(LintIssue::Type::TooManyCodes,
+						createString("Layer uses " << count << " different tiles but can "
+							"only store " << maxCount << "."));
+					issue.layer = l;
+					issue.maxCount = maxCount;
+				}
+				l++;
+			}
+		} catch (const std::exception& e) {
+			add(LintIssue::Type::OpenFailed, e.what());
+		}
+	} catch (const std::exception& e) {
+		add(failType, e.what());
+	} catch (...) {
+		add(failType, "Unknown error.");
+	}
+	return issues;
+}
+
+std::vector<LintIssue> lint(const std::string& filename,
+	const std::string& type)
+{
+	return lintFile(filename, type, MapManager::formats());
+}
+
+std::vector<LintIssue> lint(const std::vector<std::string>& filenames,
+	const std::string& type, unsigned int threads)
+{
+	// Fetch the handler list once, here, rather than in every worker.
+	auto formats = MapManager::formats();
+
+	if (threads == 0) threads = std::thread::hardware_concurrency();
+	if (threads == 0) threads = 1;
+	if (threads > filenames.size()) threads = filenames.size();
+
+	// Each worker takes the next unchecked file until there are none left.
+	// Results are stored per file, so the output order doesn't depend on
+	// which thread finished first.
+	std::vector<std::vector<LintIssue>> results(filenames.size());
+	std::atomic<std::size_t> next(0);
+	auto worker = [&]() {
+		for (;;) {
+			auto i = next++;
+			if (i >= filenames.size()) break;
+			results[i] = lintFile(filenames[i], type, formats);
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (unsigned int t = 1; t < threads; t++) pool.emplace_back(worker);
+	worker(); // this thread helps out too
+	for (auto& t : pool) t.join();
+
+	std::vector<LintIssue> issues;
+	for (auto& r : results) {
+		std::move(r.begin(), r.end(), std::back_inserter(issues));
+	}
+	return issues;
+}
+
+} // namespace gamemaps
+} // namespace camoto
@@ -30,6 +30,7 @@
 #include "fmt-map-got.hpp"
 #include "fmt-map-harry.hpp"
 #include "fmt-map-hocus.hpp"
+#include "fmt-map-native.hpp"
 #include "fmt-map-nukem2.hpp"
 #include "fmt-map-rockford.hpp"
 #include "fmt-map-sagent.hpp"
@@ -57,10 +58,12 @@ const std::vector<std::shared_ptr<const MapType> > CAMOTO_GAMEMAPS_API
 		MapType_DDave,
 		MapType_Duke1,
 		MapType_GOT,
+		MapType_GOTWorld,
 		MapType_Harry,
 		MapType_Hocus,
 		MapType_Nukem2,
 		MapType_Jill,
+		MapType_Native,
 		MapType_Rockford,
 		MapType_SAgent,
 		MapType_SAgentWorld,
@@ -18,6 +18,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <cassert>
 #include "map-core.hpp"
 
 namespace camoto {
@@ -77,9 +78,99 @@ const char* toString(ImagePurpose p)
 	return "<unknown ImagePurpose>";
 }
 
+MapCore::MapCore()
+	:	schema(nullptr),
+		built(false)
+{
+}
+
 MapCore::~MapCore()
 {
 }
 
+const std::vector<Attribute>& MapCore::attributes() const
+{
+	if (this->schema) {
+		std::call_once(this->attributesBuilt, [this]() {
+			// This is the only write to the list while it is lazy, and call_once
+			// keeps other readers waiting until it's done.
+			auto& attrs = const_cast<MapCore*>(this)->v_attributes;
+			attrs = *this->schema;
+			for (unsigned int i = 0; i < attrs.size(); i++) {
+				auto& a = attrs[i];
+				auto& v = this->values[i];
+				switch (a.type) {
+					case Attribute::Type::Integer: a.integerValue = v.number; break;
+					case Attribute::Type::Enum: a.enumValue = v.number; break;
+					case Attribute::Type::Image: a.imageIndex = v.number; break;
+					case Attribute::Type::Filename: a.filenameValue = v.text; break;
+					case Attribute::Type::Text: a.textValue = v.text; break;
+				}
+			}
+			this->built.store(true, std::memory_order_release);
+		});
+	}
+	return this->Map::attributes();
+}
+
+void MapCore::attributesFromSchema(const std::vector<Attribute>& schema)
+{
+	this->schema = &schema;
+	this->values.resize(schema.size());
+	for (unsigned int i = 0; i < schema.size(); i++) {
+		auto& a = schema[i];
+		auto& v = this->values[i];
+		switch (a.type) {
+			case Attribute::Type::Integer: v.number = a.integerValue; break;
+			case Attribute::Type::Enum: v.number = a.enumValue; break;
+			case Attribute::Type::Image: v.number = a.imageIndex; break;
+			case Attribute::Type::Filename: v.text = a.filenameValue; break;
+			case Attribute::Type::Text: v.text = a.textValue; break;
+		}
+	}
+	return;
+}
+
+void MapCore::attributeValue(unsigned int index, int value)
+{
+	assert(this->schema && !this->built);
+	this->values.at(index).number = value;
+	return;
+}
+
+void MapCore::attributeValue(unsigned int index, const std::string& value)
+{
+	assert(this->schema && !this->built);
+	this->values.at(index).text = value;
+	return;
+}
+
+int MapCore::attributeNumber(unsigned int index) const
+{
+	if (this->schema && !this->built.load(std::memory_order_acquire)) {
+		return this->values.at(index).number;
+	}
+	auto& a = this->Map::attributes().at(index);
+	switch (a.type) {
+		case Attribute::Type::Integer: return a.integerValue;
+		case Attribute::Type::Enum: return a.enumValue;
+		case Attribute::Type::Image: return a.imageIndex;
+		default: break;
+	}
+	assert(false);
+	return 0;
+}
+
+const std::string& MapCore::attributeText(unsigned int index) const
+{
+	if (this->schema && !this->built.load(std::memory_order_acquire)) {
+		return this->values.at(index).text;
+	}
+	auto& a = this->Map::attributes().at(index);
+	if (a.type == Attribute::Type::Filename) return a.filenameValue;
+	assert(a.type == Attribute::Type::Text);
+	return a.textValue;
+}
+
 } // namespace gamemaps
 } // namespace camoto
@@ -21,6 +21,9 @@
 #ifndef _CAMOTO_GAMEMAPS_MAP_CORE_HPP_
 #define _CAMOTO_GAMEMAPS_MAP_CORE_HPP_
 
+#include <atomic>
+#include <mutex>
+#include <string>
 #include <camoto/gamemaps/map.hpp>
 
 namespace camoto {
@@ -29,7 +32,61 @@ namespace gamemaps {
 class MapCore: virtual public Map
 {
 	public:
+		MapCore();
 		virtual ~MapCore();
+
+		virtual const std::vector<Attribute>& attributes() const;
+
+	protected:
+		/// Build the attribute list from a shared schema when it is first read.
+		/**
+		 * Formats whose attribute names, descriptions and enum labels never change
+		 * keep them in a single static list.  Until something asks for the
+		 * attributes, each map only holds its own values (set with
+		 * attributeValue()) rather than its own copy of every label.
+		 *
+		 * Anything in the format handler that reads the values, such as flush()
+		 * or graphicsFilenames(), should use attributeNumber() and
+		 * attributeText() so the full list isn't built just to read them.
+		 *
+		 * @param schema
+		 *   Attribute list with the labels filled in and the values left at their
+		 *   defaults.  It must outlive the map, so is normally a function-local
+		 *   static.
+		 */
+		void attributesFromSchema(const std::vector<Attribute>& schema);
+
+		/// Set a value read from the file, while the map is being opened.
+		/**
+		 * @param index
+		 *   Attribute to set.
+		 *
+		 * @param value
+		 *   New integerValue, enumValue or imageIndex, depending on the type of
+		 *   the attribute.
+		 */
+		void attributeValue(unsigned int index, int value);
+
+		/// Set a filename or text value read from the file.
+		void attributeValue(unsigned int index, const std::string& value);
+
+		/// Get the integerValue, enumValue or imageIndex of an attribute.
+		int attributeNumber(unsigned int index) const;
+
+		/// Get the filenameValue or textValue of an attribute.
+		const std::string& attributeText(unsigned int index) const;
+
+	private:
+		/// Value of one attribute, held while the schema is shared.
+		struct Value {
+			int number;       ///< integerValue, enumValue or imageIndex
+			std::string text; ///< filenameValue or textValue
+		};
+
+		const std::vector<Attribute> *schema; ///< Shared labels, or null
+		std::vector<Value> values;            ///< This map's values
+		mutable std::once_flag attributesBuilt; ///< Set once v_attributes is ready
+		mutable std::atomic<bool> built;        ///< Is v_attributes ready?
 };
 
 } // namespace gamemaps
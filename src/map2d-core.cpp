@@ -18,14 +18,332 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <mutex>
 #include "map2d-core.hpp"
+#include "packed-codes.hpp"
 
 namespace camoto {
 namespace gamemaps {
 
 using namespace camoto::gamegraphics;
 
+/// Tile codes of a packed grid, or the items once they've been rebuilt.
+/**
+ * Only one form is held at a time.  Reads that only need a code are served
+ * from the packed codes, until something needs the whole list of items.
+ * Then the items are rebuilt and the codes dropped, so the list never takes
+ * up more memory than it did before it was packed.
+ */
+class SharedItems::Packed
+{
+	public:
+		Packed(std::shared_ptr<const PackedCodes> codes, long width, long height,
+			std::size_t count, MapArena *arena)
+			:	width(width),
+				height(height),
+				count(count),
+				arena(arena),
+				codes(std::move(codes)),
+				v_items(ArenaAllocator<Item>(arena)),
+				rebuilt(false)
+		{
+		}
+
+		/// Rebuild the items from the codes, the first time only.
+		const ItemList& items() const
+		{
+			if (!this->rebuilt.load(std::memory_order_acquire)) {
+				std::lock_guard<std::mutex> guard(this->lock);
+				if (!this->rebuilt.load(std::memory_order_relaxed)) {
+					this->build(&this->v_items);
+					this->codes.reset();
+					this->rebuilt.store(true, std::memory_order_release);
+				}
+			}
+			return this->v_items;
+		}
+
+		/// Get a copy of the items, without keeping them here.
+		ItemList copy() const
+		{
+			if (!this->rebuilt.load(std::memory_order_acquire)) {
+				std::lock_guard<std::mutex> guard(this->lock);
+				if (this->codes) {
+					ItemList items(ArenaAllocator<Item>(this->arena));
+					this->build(&items);
+					return items;
+				}
+			}
+			return this->v_items;
+		}
+
+		/// Get the code in one cell, which must be inside the grid.
+		unsigned int codeAt(std::size_t cell) const
+		{
+			if (!this->rebuilt.load(std::memory_order_acquire)) {
+				std::lock_guard<std::mutex> guard(this->lock);
+				if (this->codes) return this->codes->at(cell);
+			}
+			// Every cell has an item, so it can be looked up directly
+			if (this->count == this->cells()) return this->v_items[cell].code;
+
+			// Otherwise the items are still in cell order, so search for it
+			auto item = std::lower_bound(this->v_items.begin(), this->v_items.end(),
+				cell, [this](const Item& t, std::size_t c) {
+					return (std::size_t)(t.pos.y * this->width + t.pos.x) < c;
+				});
+			if (
+				(item == this->v_items.end())
+				|| ((std::size_t)(item->pos.y * this->width + item->pos.x) != cell)
+			) {
+				return INVALID_TILECODE;
+			}
+			return item->code;
+		}
+
+		/// Are the codes still held in packed form?
+		bool packed() const
+		{
+			return !this->rebuilt.load(std::memory_order_acquire);
+		}
+
+		std::size_t cells() const
+		{
+			return this->width * this->height;
+		}
+
+		const long width;         ///< Grid width, in cells
+		const long height;        ///< Grid height, in cells
+		const std::size_t count;  ///< Number of items
+
+	private:
+		/// Rebuild the items from the codes.  The caller must hold the lock.
+		void build(ItemList *items) const
+		{
+			std::vector<unsigned int, ArenaAllocator<unsigned int>> values(
+				this->codes->size(), 0, ArenaAllocator<unsigned int>(this->arena));
+			this->codes->unpack(values.data());
+			// Empty cells only have a code if every cell has an item
+			bool skipEmpty = this->count < values.size();
+			// resize() value-initialises, so the unused fields are all zero
+			items->resize(this->count);
+			auto t = items->begin();
+			for (std::size_t i = 0; i < values.size(); i++) {
+				if (skipEmpty && (values[i] == INVALID_TILECODE)) continue;
+				t->type = Item::Type::Default;
+				t->pos.x = i % this->width;
+				t->pos.y = i / this->width;
+				t->code = values[i];
+				t++;
+			}
+			return;
+		}
+
+		MapArena *arena;                                ///< Arena for the items
+		mutable std::mutex lock;                        ///< Guards codes
+		mutable std::shared_ptr<const PackedCodes> codes; ///< Code of each cell
+		mutable ItemList v_items;                       ///< Rebuilt items
+		mutable std::atomic<bool> rebuilt;              ///< Is v_items filled?
+};
+
+SharedItems::SharedItems()
+	:	arena(MapArena::current()),
+		v_generation(0)
+{
+	this->v_items = this->newList();
+}
+
+SharedItems::SharedItems(ItemList items)
+	:	arena(MapArena::current()),
+		v_generation(0)
+{
+	this->v_items = this->newList();
+	*this->v_items = std::move(items);
+}
+
+SharedItems::SharedItems(const std::vector<Item>& items)
+	:	arena(MapArena::current()),
+		v_generation(0)
+{
+	this->v_items = this->newList();
+	this->v_items->assign(items.begin(), items.end());
+}
+
+SharedItems::SharedItems(const SharedItems& other)
+	:	arena(MapArena::current()),
+		v_items(other.v_items),
+		v_packed(other.v_packed),
+		v_generation(0)
+{
+	// The other list may still be changed through the lent reference
+	if (other.v_lent) {
+		this->v_items = this->newList();
+		this->v_items->assign(other.v_lent->begin(), other.v_lent->end());
+	}
+}
+
+SharedItems& SharedItems::operator=(const SharedItems& other)
+{
+	if (this == &other) return *this;
+	if (other.v_lent) {
+		auto items = this->newList();
+		items->assign(other.v_lent->begin(), other.v_lent->end());
+		this->v_items = std::move(items);
+	} else {
+		this->v_items = other.v_items;
+	}
+	this->v_packed = other.v_packed;
+	this->v_lent.reset();
+	this->v_generation++;
+	return *this;
+}
+
+SharedItems& SharedItems::operator=(const std::vector<Item>& items)
+{
+	auto list = this->newList();
+	list->assign(items.begin(), items.end());
+	this->v_items = std::move(list);
+	this->v_packed.reset();
+	this->v_lent.reset();
+	this->v_generation++;
+	return *this;
+}
+
+ConstView<Map2D::Layer::Item> SharedItems::get() const
+{
+	if (this->v_lent) return *this->v_lent;
+	if (this->v_items) return *this->v_items;
+	return this->v_packed->items();
+}
+
+SharedItems::ItemList& SharedItems::edit()
+{
+	assert(!this->v_lent);
+	if (!this->v_items) {
+		// Leave the packed form behind, as it can't be modified
+		auto items = this->newList();
+		*items = this->v_packed->copy();
+		this->v_items = std::move(items);
+		this->v_packed.reset();
+	} else if (this->v_items.use_count() > 1) {
+		// Nobody else can start sharing the list while we hold the only
+		// reference, so it's safe to check the count here without any locking.
+		auto items = this->newList();
+		*items = *this->v_items;
+		this->v_items = std::move(items);
+	}
+	return *this->v_items;
+}
+
+std::vector<Map2D::Layer::Item>& SharedItems::lend()
+{
+	if (!this->v_lent) {
+		auto items = this->get();
+		this->v_lent = std::make_shared<std::vector<Item>>(items.begin(),
+			items.end());
+		this->v_items.reset();
+		this->v_packed.reset();
+	}
+	this->v_generation++;
+	return *this->v_lent;
+}
+
+std::shared_ptr<SharedItems::ItemList> SharedItems::newList() const
+{
+	ArenaAllocator<Item> alloc(this->arena);
+	return std::allocate_shared<ItemList>(alloc, alloc);
+}
+
+std::size_t SharedItems::size() const
+{
+	if (this->v_lent) return this->v_lent->size();
+	if (this->v_items) return this->v_items->size();
+	return this->v_packed->count;
+}
+
+bool SharedItems::pack(const Point& layerSize)
+{
+	if (this->packed()) return true;
+	auto items = this->get();
+	if (items.empty() || (layerSize.x <= 0) || (layerSize.y <= 0)) return false;
+
+	std::size_t width = layerSize.x;
+	std::vector<unsigned int, ArenaAllocator<unsigned int>> codes(
+		width * layerSize.y, INVALID_TILECODE,
+		ArenaAllocator<unsigned int>(this->arena));
+	std::size_t nextCell = 0;
+	bool hasInvalid = false;
+	for (auto& t : items) {
+		if (t.type != Item::Type::Default) return false;
+		if (
+			(t.pos.x < 0) || (t.pos.x >= layerSize.x)
+			|| (t.pos.y < 0) || (t.pos.y >= layerSize.y)
+		) {
+			return false;
+		}
+		std::size_t cell = t.pos.y * width + t.pos.x;
+		// Items out of order or stacked in one cell can't be rebuilt as they were
+		if (cell < nextCell) return false;
+		codes[cell] = t.code;
+		nextCell = cell + 1;
+		if (t.code == INVALID_TILECODE) hasInvalid = true;
+	}
+	// Empty cells are marked with INVALID_TILECODE, so items can't use it too
+	if (hasInvalid && (items.size() < codes.size())) return false;
+
+	auto packedCodes = packCodes(codes.data(), codes.size(), this->arena);
+	if (!packedCodes) return false;
+	auto packed = std::allocate_shared<Packed>(
+		ArenaAllocator<Packed>(this->arena), std::move(packedCodes),
+		layerSize.x, layerSize.y, items.size(), this->arena);
+	// This may free items
+	this->v_packed = std::move(packed);
+	this->v_items.reset();
+	this->v_lent.reset();
+	this->v_generation++;
+	return true;
+}
+
+bool SharedItems::packed() const
+{
+	return this->v_packed && this->v_packed->packed();
+}
+
+unsigned int SharedItems::codeAt(const Point& pos) const
+{
+	if (!this->v_packed) {
+		for (auto& t : this->get()) {
+			if ((t.pos.x == pos.x) && (t.pos.y == pos.y)) return t.code;
+		}
+		return INVALID_TILECODE;
+	}
+	auto& p = *this->v_packed;
+	if ((pos.x < 0) || (pos.x >= p.width) || (pos.y < 0) || (pos.y >= p.height)) {
+		return INVALID_TILECODE;
+	}
+	return p.codeAt(pos.y * p.width + pos.x);
+}
+
+/// Number of recent changes checked when merging a new change into the list.
+#define MAP2D_CHANGE_MERGE_WINDOW 8
+
+/// Do two changed areas overlap or share an edge?
+static bool touching(const Map2D::Change& a, const Map2D::Change& b)
+{
+	return
+		(a.pos.x <= b.pos.x + b.size.x) && (b.pos.x <= a.pos.x + a.size.x)
+		&& (a.pos.y <= b.pos.y + b.size.y) && (b.pos.y <= a.pos.y + a.size.y)
+	;
+}
+
+Map2DCore::Map2DCore()
+	:	updateDepth(0)
+{
+}
+
 Map2DCore::~Map2DCore()
 {
 }
@@ -114,6 +432,11 @@ std::vector<std::shared_ptr<const Map2D::Layer>> Map2DCore::layers() const
 		this->v_layers.begin(), this->v_layers.end());
 }
 
+ConstPtrView<Map2D::Layer> Map2DCore::layerView() const
+{
+	return this->v_layers;
+}
+
 std::vector<std::shared_ptr<Map2D::Path>>& Map2DCore::paths()
 {
 	return this->v_paths;
@@ -127,12 +450,141 @@ Map2D::Background Map2DCore::background(const TilesetCollection& tileset)
 	return bg;
 }
 
+void Map2DCore::addObserver(std::shared_ptr<Observer> observer)
+{
+	this->observers.push_back(observer);
+	return;
+}
+
+void Map2DCore::removeObserver(const Observer *observer)
+{
+	this->observers.erase(
+		std::remove_if(this->observers.begin(), this->observers.end(),
+			[observer](const std::weak_ptr<Observer>& o) {
+				auto p = o.lock();
+				return !p || (p.get() == observer);
+			}
+		),
+		this->observers.end()
+	);
+	return;
+}
+
+void Map2DCore::beginUpdate()
+{
+	this->updateDepth++;
+	return;
+}
+
+void Map2DCore::endUpdate()
+{
+	assert(this->updateDepth > 0);
+	if (this->updateDepth == 0) return;
+	if (--this->updateDepth == 0) this->notifyObservers();
+	return;
+}
+
+void Map2DCore::changed(const Change& change)
+{
+	// Don't bother keeping track of anything if nobody is listening
+	if (this->observers.empty()) return;
+
+	bool merged = false;
+	if (change.type == Change::Type::Items) {
+		// Only look at the last few changes, which is enough to join up the cells
+		// of a brush stroke or a filled block without making big batches slow.
+		auto num = this->pendingChanges.size();
+		auto stop = num - std::min<std::size_t>(num, MAP2D_CHANGE_MERGE_WINDOW);
+		for (auto n = num; n > stop; n--) {
+			auto& i = this->pendingChanges[n - 1];
+			if (
+				(i.type != Change::Type::Items)
+				|| (i.layer != change.layer)
+				|| !touching(i, change)
+			) continue;
+			Point tl, br;
+			tl.x = std::min(i.pos.x, change.pos.x);
+			tl.y = std::min(i.pos.y, change.pos.y);
+			br.x = std::max(i.pos.x + i.size.x, change.pos.x + change.size.x);
+			br.y = std::max(i.pos.y + i.size.y, change.pos.y + change.size.y);
+			i.pos = tl;
+			i.size.x = br.x - tl.x;
+			i.size.y = br.y - tl.y;
+			merged = true;
+			break;
+		}
+	} else if (change.type == Change::Type::Attribute) {
+		for (auto& i : this->pendingChanges) {
+			if (
+				(i.type == Change::Type::Attribute)
+				&& (i.attribute == change.attribute)
+			) {
+				merged = true;
+				break;
+			}
+		}
+	}
+	if (!merged) this->pendingChanges.push_back(change);
+
+	if (this->updateDepth == 0) this->notifyObservers();
+	return;
+}
+
+void Map2DCore::attribute(unsigned int index, int newValue)
+{
+	this->attributes(); // build a lazy list first, so there's something to set
+	this->Map::attribute(index, newValue);
+	Change c = Change();
+	c.type = Change::Type::Attribute;
+	c.attribute = index;
+	this->changed(c);
+	return;
+}
+
+void Map2DCore::attribute(unsigned int index, const std::string& newValue)
+{
+	this->attributes(); // build a lazy list first, so there's something to set
+	this->Map::attribute(index, newValue);
+	Change c = Change();
+	c.type = Change::Type::Attribute;
+	c.attribute = index;
+	this->changed(c);
+	return;
+}
+
+void Map2DCore::notifyObservers()
+{
+	if (this->pendingChanges.empty()) return;
+
+	// Swap the list out first, in case an observer makes further changes
+	std::vector<Change> changes;
+	changes.swap(this->pendingChanges);
+
+	// Take a copy of the observers too, so they can remove themselves
+	auto observers = this->observers;
+	bool expired = false;
+	for (auto& o : observers) {
+		auto p = o.lock();
+		if (p) p->mapChanged(*this, changes);
+		else expired = true;
+	}
+	if (expired) {
+		this->observers.erase(
+			std::remove_if(this->observers.begin(), this->observers.end(),
+				[](const std::weak_ptr<Observer>& o) { return o.expired(); }
+			),
+			this->observers.end()
+		);
+	}
+	return;
+}
+
 Map2D::Background Map2DCore::backgroundFromTilecode(
 	const TilesetCollection& tileset, unsigned int code) const
 {
 	Layer::Item item;
 	item.code = code;
-	auto imgInfo = this->v_layers[0]->imageFromCode(item, tileset);
+	auto imgInfo = this->layerView()[0].imageFromCode(item, tileset);
 
 	Background bg;
 	if (imgInfo.type == Layer::ImageFromCodeInfo::ImageType::Supplied) {
@@ -197,12 +649,18 @@ void Map2DCore::LayerCore::tileSize(const Point& newSize)
 
 std::vector<Map2D::Layer::Item>& Map2DCore::LayerCore::items()
 {
-	return this->v_allItems;
+	return this->v_allItems.lend();
 }
 
 std::vector<Map2D::Layer::Item> Map2DCore::LayerCore::items() const
 {
-	return this->v_allItems;
+	auto items = this->v_allItems.get();
+	return std::vector<Item>(items.begin(), items.end());
+}
+
+ConstView<Map2D::Layer::Item> Map2DCore::LayerCore::itemView() const
+{
+	return this->v_allItems.get();
 }
 
 Map2D::Layer::ImageFromCodeInfo Map2DCore::LayerCore::imageFromCode(
@@ -225,6 +683,79 @@ bool Map2DCore::LayerCore::tilePermittedAt(const Map2D::Layer::Item& item,
 	return true; // permitted here
 }
 
+void Map2DCore::LayerCore::tilePermittedIn(const Map2D::Layer::Item& item,
+	const Point& pos, const Point& size, std::vector<bool> *permitted,
+	unsigned int *maxCount) const
+{
+	assert(permitted);
+	assert(maxCount);
+
+	// Default to asking about each cell in turn, so layers only have to
+	// implement tilePermittedAt().
+	*maxCount = 0;
+	permitted->clear();
+	if ((size.x <= 0) || (size.y <= 0)) return;
+	permitted->resize(size.x * size.y);
+	auto out = permitted->begin();
+	Point cell;
+	for (cell.y = pos.y; cell.y < pos.y + size.y; cell.y++) {
+		for (cell.x = pos.x; cell.x < pos.x + size.x; cell.x++) {
+			*out++ = this->tilePermittedAt(item, cell, maxCount);
+		}
+	}
+	return;
+}
+
+void Map2DCore::LayerCore::itemsPermitted(ConstView<Item> items,
+	std::vector<bool> *permitted, std::vector<unsigned int> *maxCount) const
+{
+	assert(permitted);
+	assert(maxCount);
+
+	permitted->resize(items.size());
+	maxCount->resize(items.size());
+	for (std::size_t i = 0; i < items.size(); i++) {
+		(*permitted)[i] = this->tilePermittedAt(items[i], items[i].pos,
+			&(*maxCount)[i]);
+	}
+	return;
+}
+
+unsigned int Map2DCore::LayerCore::uniqueCodes(unsigned int *maxCount) const
+{
+	return this->countUniqueCodes(this->v_allItems.get(), maxCount);
+}
+
+unsigned int Map2DCore::LayerCore::countUniqueCodes(
+	ConstView<Item> items, unsigned int *maxCount) const
+{
+	assert(maxCount);
+
+	*maxCount = 0; // unlimited
+
+	std::vector<unsigned int> codes;
+	codes.reserve(items.size());
+	for (auto& i : items) codes.push_back(i.code);
+	std::sort(codes.begin(), codes.end());
+	return std::unique(codes.begin(), codes.end()) - codes.begin();
+}
+
+const SharedItems& Map2DCore::LayerCore::sharedItems() const
+{
+	return this->v_allItems;
+}
+
+void Map2DCore::LayerCore::sharedItems(const SharedItems& items)
+{
+	this->v_allItems = items;
+	return;
+}
+
+SharedItems& Map2DCore::LayerCore::editItems()
+{
+	return this->v_allItems;
+}
+
 std::shared_ptr<const gamegraphics::Palette> Map2DCore::LayerCore::palette(
 	const TilesetCollection& tileset) const
 {
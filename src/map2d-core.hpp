@@ -21,17 +21,260 @@
 #ifndef _CAMOTO_GAMEMAPS_MAP2D_CORE_HPP_
 #define _CAMOTO_GAMEMAPS_MAP2D_CORE_HPP_
 
+#include <memory>
+#include <camoto/util.hpp>
+#include <camoto/gamemaps/arena.hpp>
 #include <camoto/gamemaps/map2d.hpp>
+#include <camoto/gamemaps/util.hpp>
 
 namespace camoto {
 namespace gamemaps {
 
+/// Copy-on-write list of the items in a layer.
+/**
+ * Copies of this object share the same underlying vector until one of them
+ * is modified, at which point the modified copy gets its own vector.  This
+ * lets a snapshot of a layer be taken without copying any items.
+ *
+ * The functions mirroring std::vector are there so format handlers can fill
+ * and read the list as if it were a plain vector.  Only the const iterators
+ * are provided, so looping over the list never causes a copy.
+ *
+ * The items are kept in the MapArena that was current when the list was
+ * created, if any (see MapArena::Scope).  Format handlers building a list of
+ * items to hand over in one go can use ItemList to do the same.
+ *
+ * A list that forms a plain grid can also be packed (see pack()), which keeps
+ * only the tile codes in a compressed form.  size() and codeAt() read the
+ * packed codes directly.  Anything needing the whole list rebuilds the items,
+ * and then the packed codes are dropped, so both are never held at once.
+ *
+ * Once lend() has handed out a reference to the items, the caller may keep
+ * using it for as long as it likes, so from then on every copy gets its own
+ * vector straight away instead of sharing one that could still change.  As
+ * Layer::items() returns a plain std::vector, lent items are moved out of
+ * the arena and onto the heap.
+ */
+class SharedItems
+{
+	public:
+		typedef Map2D::Layer::Item Item;
+
+		/// List of items kept in a MapArena.
+		/**
+		 * A default-constructed list uses MapArena::current().
+		 */
+		typedef ArenaVector<Item> ItemList;
+
+		SharedItems();
+
+		/// Take ownership of the given items.
+		explicit SharedItems(ItemList items);
+
+		/// Copy the given items.
+		explicit SharedItems(const std::vector<Item>& items);
+
+		/// Share the other list's items, or copy them if they have been lent.
+		SharedItems(const SharedItems& other);
+
+		/// Share the other list's items, or copy them if they have been lent.
+		/**
+		 * Any reference previously returned by lend() refers to the old items
+		 * and must not be used afterwards.
+		 */
+		SharedItems& operator=(const SharedItems& other);
+
+		/// Replace the list with a copy of the given items.
+		SharedItems& operator=(const std::vector<Item>& items);
+
+		/// Get the items for reading.
+		/**
+		 * If the list is packed, the items are rebuilt on the first call and the
+		 * packed codes are dropped.  This is safe to do from several threads at
+		 * once.
+		 *
+		 * @return View of the items, which is valid until the list is next
+		 *   modified, copied or replaced.
+		 */
+		ConstView<Item> get() const;
+
+		/// Get the items for modification by code outside the layer.
+		/**
+		 * If the list is shared with another copy (such as a snapshot) it is
+		 * copied first, so the other copy isn't affected.  As there's no telling
+		 * how long the reference is kept, copies made from now on no longer
+		 * share the items.  This is what Layer::items() returns, so a reference
+		 * obtained before a snapshot is taken can't be used to change the
+		 * snapshot.
+		 *
+		 * @return Reference to the items, which is valid until the list is
+		 *   replaced by an assignment.
+		 */
+		std::vector<Item>& lend();
+
+		void reserve(std::size_t n)
+		{
+			if (this->v_lent) this->v_lent->reserve(n);
+			else this->edit().reserve(n);
+		}
+
+		template<class... Args>
+		void emplace_back(Args&&... args)
+		{
+			if (this->v_lent) {
+				this->v_lent->emplace_back(std::forward<Args>(args)...);
+			} else {
+				this->edit().emplace_back(std::forward<Args>(args)...);
+			}
+		}
+
+		void push_back(const Item& item)
+		{
+			if (this->v_lent) this->v_lent->push_back(item);
+			else this->edit().push_back(item);
+		}
+
+		Item& back()
+		{
+			if (this->v_lent) return this->v_lent->back();
+			return this->edit().back();
+		}
+
+		void pop_back()
+		{
+			if (this->v_lent) this->v_lent->pop_back();
+			else this->edit().pop_back();
+		}
+
+		/// Get an item for modification.
+		/**
+		 * @return Reference to the item, which is only valid until the next
+		 *   time this object is copied or modified.
+		 */
+		Item& at(std::size_t index)
+		{
+			if (this->v_lent) return this->v_lent->at(index);
+			return this->edit().at(index);
+		}
+
+		std::size_t size() const;
+
+		bool empty() const
+		{
+			return this->size() == 0;
+		}
+
+		ConstView<Item>::const_iterator begin() const
+		{
+			return this->get().begin();
+		}
+
+		ConstView<Item>::const_iterator end() const
+		{
+			return this->get().end();
+		}
+
+		/// Replace the items with a packed copy of their tile codes.
+		/**
+		 * This only works when every item is a Default type inside the layer,
+		 * with at most one item per cell, listed row by row from the top-left.
+		 * Most background layers are loaded like this, including those that
+		 * leave out cells holding the default tile.  Run-length or bit-packed
+		 * storage is used, whichever is smaller for this layer.
+		 *
+		 * Copies sharing the list keep sharing the original, unpacked items.
+		 * A list whose items were rebuilt from an earlier packing is packed
+		 * again.  A list that has been lent is packed too, which takes the
+		 * items back, so the reference returned by lend() must no longer be in
+		 * use.
+		 *
+		 * @param layerSize
+		 *   Width and height of the layer, in tiles.
+		 *
+		 * @return true if the items were packed, false if they don't fit the
+		 *   rules above and have been left alone.
+		 */
+		bool pack(const Point& layerSize);
+
+		/// Are the items currently held in packed form?
+		/**
+		 * @return true until the list is modified, or the items are rebuilt
+		 *   for reading.
+		 */
+		bool packed() const;
+
+		/// Number that changes whenever the items may have been changed.
+		/**
+		 * This goes up each time the list is replaced, packed or lent, so code
+		 * keeping its own index of the items can tell when it needs rebuilding.
+		 * It does not change for edits made through a reference lent earlier.
+		 */
+		unsigned long generation() const
+		{
+			return this->v_generation;
+		}
+
+		/// Get the code of the item in a cell.
+		/**
+		 * While the list is packed this reads the code directly, without
+		 * rebuilding the items.  Otherwise the items are searched in order.
+		 *
+		 * @param pos
+		 *   Cell to look up, in tiles.
+		 *
+		 * @return The item's code, or INVALID_TILECODE if there's no item at pos.
+		 */
+		unsigned int codeAt(const Point& pos) const;
+
+	private:
+		class Packed;
+
+		/// Get the items for modification within the layer.
+		/**
+		 * If the list is shared with another copy it is copied first, and if it
+		 * is packed it is rebuilt.
+		 *
+		 * @pre The list has not been lent, as lent items are kept separately.
+		 */
+		ItemList& edit();
+
+		/// Create an empty list in this object's arena.
+		std::shared_ptr<ItemList> newList() const;
+
+		/// Arena for new lists, or a null pointer for the heap.
+		MapArena *arena;
+
+		/// Items, or a null pointer while the list is packed or lent.
+		std::shared_ptr<ItemList> v_items;
+
+		/// Packed codes, or a null pointer if the list isn't packed.
+		std::shared_ptr<const Packed> v_packed;
+
+		/// Items handed out by lend(), or a null pointer if none have been.
+		std::shared_ptr<std::vector<Item>> v_lent;
+
+		unsigned long v_generation; ///< Value for generation()
+};
+
 /// Common implementation of 2D grid-based Map.
+/**
+ * Maps may be read by several threads at once (see Map), so const functions
+ * in descendent classes must not change any state.  Anything a const function
+ * needs should be prepared in the constructor or flush(), or held in a
+ * function-local static, which C++11 initialises in a thread-safe manner.
+ *
+ * Snapshots (see snapshot()) keep calling a layer's imageFromCode(),
+ * tilePermittedAt(), tilePermittedIn(), itemsPermitted(), palette(),
+ * availableItems() and countUniqueCodes() while the map is being edited, so
+ * these must only use the arguments passed in and data that is fixed once the
+ * layer has been constructed.
+ */
 class Map2DCore: virtual public Map2D
 {
 	public:
 		class LayerCore;
 
+		Map2DCore();
 		virtual ~Map2DCore();
 
 		// These are all default functions so descendent classes don't have to
@@ -43,9 +286,19 @@ class Map2DCore: virtual public Map2D
 		virtual void tileSize(const Point& newSize);
 		virtual std::vector<std::shared_ptr<Map2D::Layer>> layers();
 		virtual std::vector<std::shared_ptr<const Map2D::Layer>> layers() const;
+		virtual ConstPtrView<Map2D::Layer> layerView() const;
 		virtual std::vector<std::shared_ptr<Map2D::Path>>& paths();
 		virtual Background background(const TilesetCollection& tileset)
 			const;
+		virtual void addObserver(std::shared_ptr<Observer> observer);
+		virtual void removeObserver(const Observer *observer);
+		virtual void beginUpdate();
+		virtual void endUpdate();
+		virtual void changed(const Change& change);
+
+		// Report attribute changes to any observers.
+		virtual void attribute(unsigned int index, int newValue);
+		virtual void attribute(unsigned int index, const std::string& newValue);
 
 	protected:
 		/// Use a tilecode for the map background.
@@ -74,6 +327,14 @@ class Map2DCore: virtual public Map2D
 
 		std::vector<std::shared_ptr<Layer>> v_layers; ///< Layers for layers()
 		std::vector<std::shared_ptr<Path>> v_paths; ///< Paths for paths()
+
+	private:
+		/// Send the pending changes to every observer that still exists.
+		void notifyObservers();
+
+		std::vector<std::weak_ptr<Observer>> observers; ///< From addObserver()
+		std::vector<Change> pendingChanges; ///< Held until endUpdate()
+		unsigned int updateDepth;           ///< Nesting level of beginUpdate()
 };
 
 class Map2DCore::LayerCore: virtual public Map2D::Layer
@@ -114,21 +375,78 @@ class Map2DCore::LayerCore: virtual public Map2D::Layer
 
 		virtual std::vector<Item>& items();
 		virtual std::vector<Item> items() const;
+		virtual ConstView<Item> itemView() const;
 		virtual ImageFromCodeInfo imageFromCode(const Map2D::Layer::Item& item,
 			const TilesetCollection& tileset) const;
 		virtual bool tilePermittedAt(const Map2D::Layer::Item& item,
 			const Point& pos, unsigned int *maxCount) const;
+		virtual void tilePermittedIn(const Map2D::Layer::Item& item,
+			const Point& pos, const Point& size, std::vector<bool> *permitted,
+			unsigned int *maxCount) const;
+		virtual void itemsPermitted(ConstView<Item> items,
+			std::vector<bool> *permitted, std::vector<unsigned int> *maxCount)
+			const;
+		virtual unsigned int uniqueCodes(unsigned int *maxCount) const;
 		virtual std::shared_ptr<const gamegraphics::Palette> palette(
 			const TilesetCollection& tileset) const;
 
+		/// Count the unique codes in a list of items.
+		/**
+		 * This is the implementation behind uniqueCodes(), split out so it can be
+		 * run over items that aren't the layer's current ones (e.g. a snapshot).
+		 * Formats with special rules for counting override this rather than
+		 * uniqueCodes().
+		 *
+		 * @param items
+		 *   Items to count.
+		 *
+		 * @param maxCount
+		 *   Same as for uniqueCodes().
+		 *
+		 * @return Same as for uniqueCodes().
+		 */
+		virtual unsigned int countUniqueCodes(ConstView<Item> items,
+			unsigned int *maxCount) const;
+
+		/// Get the layer's items without copying them.
+		const SharedItems& sharedItems() const;
+
+		/// Replace the layer's items with another shared list.
+		/**
+		 * No items are copied; the list is shared until one side modifies it.
+		 */
+		void sharedItems(const SharedItems& items);
+
+		/// Get the layer's items for changing in place.
+		/**
+		 * Unlike items(), this doesn't lend the list (see SharedItems::lend()),
+		 * so snapshots taken between edits keep sharing it.  This is for code
+		 * such as EditJournal that only holds on to the items for the length of
+		 * one edit.
+		 */
+		SharedItems& editItems();
+
 	protected:
 		Point v_layerSize;       ///< Map width and height, in tiles
 		Point v_tileSize;        ///< Tile width and height, in pixels
-		std::vector<Item> v_allItems;
+		SharedItems v_allItems;  ///< Items for items() and itemView()
 
 		std::shared_ptr<const gamegraphics::Palette> pal; ///< Optional palette for layer
 };
 
+/// Create a map and pack its grid layers, for MapType::open().
+/**
+ * Format handlers return their maps through this, so every map is held in
+ * packed form (see packLayers()) until it is edited or its items are read.
+ */
+template<class T, class... Args>
+std::unique_ptr<T> openPacked(Args&&... args)
+{
+	auto map = std::make_unique<T>(std::forward<Args>(args)...);
+	packLayers(*map);
+	return map;
+}
+
 } // namespace gamemaps
 } // namespace camoto
 
@@ -0,0 +1,321 @@
+/**
+ * @file  map2d-snapshot.cpp
+ * @brief Read-only snapshots of Map2D instances.
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <camoto/gamemaps/util.hpp>
+#include "map-core.hpp"
+#include "map2d-core.hpp"
+
+namespace camoto {
+namespace gamemaps {
+
+using namespace camoto::gamegraphics;
+
+/// Frozen copy of a layer's items, drawn using the original layer.
+class Layer_Snapshot: public Map2DCore::LayerCore
+{
+	public:
+		Layer_Snapshot(std::shared_ptr<const Map2D::Layer> source)
+			:	source(source),
+				sourceCore(dynamic_cast<const Map2DCore::LayerCore*>(source.get())),
+				v_title(source->title()),
+				v_caps((Caps)((unsigned int)source->caps()
+					& ~(unsigned int)(Caps::SetOwnSize | Caps::SetOwnTileSize)))
+		{
+			if (this->v_caps & Caps::HasOwnSize) {
+				this->v_layerSize = source->layerSize();
+			}
+			if (this->v_caps & Caps::HasOwnTileSize) {
+				this->v_tileSize = source->tileSize();
+			}
+			if (this->sourceCore) {
+				// Share the item list, it'll be copied if the source gets modified
+				this->sharedItems(this->sourceCore->sharedItems());
+			} else {
+				this->v_allItems = source->items();
+			}
+		}
+
+		virtual std::string title() const
+		{
+			return this->v_title;
+		}
+
+		virtual Caps caps() const
+		{
+			return this->v_caps;
+		}
+
+		virtual ImageFromCodeInfo imageFromCode(const Item& item,
+			const TilesetCollection& tileset) const
+		{
+			return this->source->imageFromCode(item, tileset);
+		}
+
+		virtual bool tilePermittedAt(const Item& item, const Point& pos,
+			unsigned int *maxCount) const
+		{
+			return this->source->tilePermittedAt(item, pos, maxCount);
+		}
+
+		virtual void tilePermittedIn(const Item& item, const Point& pos,
+			const Point& size, std::vector<bool> *permitted,
+			unsigned int *maxCount) const
+		{
+			this->source->tilePermittedIn(item, pos, size, permitted, maxCount);
+		}
+
+		virtual void itemsPermitted(ConstView<Item> items,
+			std::vector<bool> *permitted, std::vector<unsigned int> *maxCount)
+			const
+		{
+			this->source->itemsPermitted(items, permitted, maxCount);
+		}
+
+		virtual unsigned int countUniqueCodes(ConstView<Item> items,
+			unsigned int *maxCount) const
+		{
+			if (this->sourceCore) {
+				return this->sourceCore->countUniqueCodes(items, maxCount);
+			}
+			return this->LayerCore::countUniqueCodes(items, maxCount);
+		}
+
+		virtual std::shared_ptr<const Palette> palette(
+			const TilesetCollection& tileset) const
+		{
+			return this->source->palette(tileset);
+		}
+
+		virtual const std::vector<Item>& availableItems() const
+		{
+			return this->source->availableItems();
+		}
+
+	private:
+		std::shared_ptr<const Map2D::Layer> source;
+		const Map2DCore::LayerCore *sourceCore; ///< source, if it's a LayerCore
+		std::string v_title;
+		Caps v_caps;
+};
+
+/// Frozen copy of a map's settings and layers.
+class Map_Snapshot: public MapCore, public Map2DCore
+{
+	public:
+		Map_Snapshot(std::shared_ptr<const Map2D> source)
+			:	source(source),
+				v_caps((Caps)((unsigned int)source->caps()
+					& ~(unsigned int)(Caps::SetMapSize | Caps::SetTileSize))),
+				v_graphicsFilenames(source->graphicsFilenames())
+		{
+			if (this->v_caps & Caps::HasViewport) {
+				this->v_viewport = source->viewport();
+			}
+			if (this->v_caps & Caps::HasMapSize) {
+				this->v_mapSize = source->mapSize();
+			}
+			if (this->v_caps & Caps::HasTileSize) {
+				this->v_tileSize = source->tileSize();
+			}
+			this->v_attributes = source->attributes();
+			for (auto& l : source->layers()) {
+				this->v_layers.push_back(std::make_shared<Layer_Snapshot>(l));
+			}
+		}
+
+		virtual std::map<ImagePurpose, GraphicsFilename> graphicsFilenames() const
+		{
+			return this->v_graphicsFilenames;
+		}
+
+		virtual void flush()
+		{
+			throw camoto::error("Map snapshots are read-only.  Use restoreSnapshot() "
+				"to copy a snapshot into a map that can be saved.");
+		}
+
+		virtual Caps caps() const
+		{
+			return this->v_caps;
+		}
+
+		virtual Point viewport() const
+		{
+			return this->v_viewport;
+		}
+
+		virtual Point mapSize() const
+		{
+			return this->v_mapSize;
+		}
+
+		virtual Point tileSize() const
+		{
+			return this->v_tileSize;
+		}
+
+		virtual Background background(const TilesetCollection& tileset) const
+		{
+			return this->source->background(tileset);
+		}
+
+	private:
+		std::shared_ptr<const Map2D> source;
+		Caps v_caps;
+		Point v_viewport;
+		Point v_mapSize;
+		Point v_tileSize;
+		std::map<ImagePurpose, GraphicsFilename> v_graphicsFilenames;
+};
+
+static bool samePoint(const Point& a, const Point& b)
+{
+	return (a.x == b.x) && (a.y == b.y);
+}
+
+std::shared_ptr<const Map2D> snapshot(std::shared_ptr<const Map2D> map)
+{
+	return std::make_shared<Map_Snapshot>(map);
+}
+
+/// Copy everything across for restoreSnapshot(), once it has been checked.
+static void restoreContent(Map2D& dest, const Map2D& src,
+	const std::vector<std::shared_ptr<Map2D::Layer>>& destLayers,
+	const std::vector<std::shared_ptr<const Map2D::Layer>>& srcLayers)
+{
+	auto& srcAttr = src.attributes();
+	auto& destAttr = dest.attributes();
+
+	auto destCaps = dest.caps();
+	if (
+		(destCaps & Map2D::Caps::SetMapSize)
+		&& (src.caps() & Map2D::Caps::HasMapSize)
+		&& !samePoint(dest.mapSize(), src.mapSize())
+	) {
+		dest.mapSize(src.mapSize());
+	}
+	if (
+		(destCaps & Map2D::Caps::SetTileSize)
+		&& (src.caps() & Map2D::Caps::HasTileSize)
+		&& !samePoint(dest.tileSize(), src.tileSize())
+	) {
+		dest.tileSize(src.tileSize());
+	}
+
+	for (unsigned int i = 0; i < srcAttr.size(); i++) {
+		auto& a = srcAttr[i];
+		auto& d = destAttr[i];
+		switch (a.type) {
+			case Attribute::Type::Integer:
+				if (d.integerValue != a.integerValue) {
+					dest.attribute(i, a.integerValue);
+				}
+				break;
+			case Attribute::Type::Enum:
+				if (d.enumValue != a.enumValue) {
+					dest.attribute(i, (int)a.enumValue);
+				}
+				break;
+			case Attribute::Type::Filename:
+				if (d.filenameValue != a.filenameValue) {
+					dest.attribute(i, a.filenameValue);
+				}
+				break;
+			case Attribute::Type::Text:
+				if (d.textValue != a.textValue) {
+					dest.attribute(i, a.textValue);
+				}
+				break;
+			case Attribute::Type::Image:
+				if (d.imageIndex != a.imageIndex) {
+					dest.attribute(i, a.imageIndex);
+				}
+				break;
+		}
+	}
+
+	for (unsigned int l = 0; l < srcLayers.size(); l++) {
+		auto& srcLayer = srcLayers[l];
+		auto& destLayer = destLayers[l];
+		auto layerCaps = destLayer->caps();
+		if (
+			(layerCaps & Map2D::Layer::Caps::SetOwnSize)
+			&& (srcLayer->caps() & Map2D::Layer::Caps::HasOwnSize)
+			&& !samePoint(destLayer->layerSize(), srcLayer->layerSize())
+		) {
+			destLayer->layerSize(srcLayer->layerSize());
+		}
+		if (
+			(layerCaps & Map2D::Layer::Caps::SetOwnTileSize)
+			&& (srcLayer->caps() & Map2D::Layer::Caps::HasOwnTileSize)
+			&& !samePoint(destLayer->tileSize(), srcLayer->tileSize())
+		) {
+			destLayer->tileSize(srcLayer->tileSize());
+		}
+
+		auto srcCore = dynamic_cast<const Map2DCore::LayerCore*>(srcLayer.get());
+		auto destCore = dynamic_cast<Map2DCore::LayerCore*>(destLayer.get());
+		if (srcCore && destCore) {
+			destCore->sharedItems(srcCore->sharedItems());
+		} else {
+			destLayer->items() = srcLayer->items();
+		}
+
+		Map2D::Change c = Map2D::Change();
+		c.type = Map2D::Change::Type::Items;
+		c.layer = l;
+		Point tileSize;
+		getLayerDims(dest, *destLayer, &c.size, &tileSize);
+		dest.changed(c);
+	}
+	return;
+}
+
+void restoreSnapshot(Map2D& dest, const Map2D& src)
+{
+	auto srcLayers = src.layers();
+	auto destLayers = dest.layers();
+	if (srcLayers.size() != destLayers.size()) {
+		throw camoto::error("Cannot restore a snapshot into a map with a "
+			"different number of layers.");
+	}
+
+	auto& srcAttr = src.attributes();
+	auto& destAttr = dest.attributes();
+	if (srcAttr.size() != destAttr.size()) {
+		throw camoto::error("Cannot restore a snapshot into a map with a "
+			"different set of attributes.");
+	}
+
+	// Observers get told about everything at once, once the restore is done
+	dest.beginUpdate();
+	try {
+		restoreContent(dest, src, destLayers, srcLayers);
+	} catch (...) {
+		dest.endUpdate();
+		throw;
+	}
+	dest.endUpdate();
+	return;
+}
+
+} // namespace gamemaps
+} // namespace camoto
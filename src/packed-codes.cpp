@@ -0,0 +1,197 @@
+/**
+ * @file  packed-codes.cpp
+ * @brief Compact in-memory storage for grids of tile codes.
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include "packed-codes.hpp"
+
+namespace camoto {
+namespace gamemaps {
+
+PackedCodes::~PackedCodes()
+{
+}
+
+RunLengthCodes::RunLengthCodes(const unsigned int *codes, std::size_t count,
+	MapArena *arena)
+	:	runCode(ArenaAllocator<uint32_t>(arena)),
+		runEnd(ArenaAllocator<uint32_t>(arena))
+{
+	this->count = count;
+	// Size the lists up front, as memory in an arena can't be reused
+	auto runs = RunLengthCodes::bytesFor(codes, count) / (sizeof(uint32_t) * 2);
+	this->runCode.reserve(runs);
+	this->runEnd.reserve(runs);
+	for (std::size_t i = 0; i < count; i++) {
+		if (!this->runCode.empty() && (this->runCode.back() == codes[i])) {
+			this->runEnd.back() = i + 1;
+		} else {
+			this->runCode.push_back(codes[i]);
+			this->runEnd.push_back(i + 1);
+		}
+	}
+}
+
+unsigned int RunLengthCodes::at(std::size_t index) const
+{
+	assert(index < this->count);
+	auto run = std::upper_bound(this->runEnd.begin(), this->runEnd.end(), index);
+	return this->runCode[run - this->runEnd.begin()];
+}
+
+void RunLengthCodes::unpack(unsigned int *out) const
+{
+	std::size_t start = 0;
+	for (std::size_t r = 0; r < this->runCode.size(); r++) {
+		std::fill(out + start, out + this->runEnd[r], this->runCode[r]);
+		start = this->runEnd[r];
+	}
+	return;
+}
+
+std::size_t RunLengthCodes::bytes() const
+{
+	return this->runCode.size() * sizeof(uint32_t) * 2;
+}
+
+std::size_t RunLengthCodes::bytesFor(const unsigned int *codes,
+	std::size_t count)
+{
+	std::size_t runs = 0;
+	for (std::size_t i = 0; i < count; i++) {
+		if ((i == 0) || (codes[i] != codes[i - 1])) runs++;
+	}
+	return runs * sizeof(uint32_t) * 2;
+}
+
+BitPackedCodes::BitPackedCodes(const unsigned int *codes, std::size_t count,
+	MapArena *arena)
+	:	words(ArenaAllocator<uint64_t>(arena))
+{
+	this->count = count;
+	this->bits = BitPackedCodes::bitsFor(codes, count);
+
+	// A layer of nothing but empty cells needs no storage at all
+	if (this->bits == 0) return;
+
+	this->words.resize((this->count * this->bits + 63) / 64);
+	for (std::size_t i = 0; i < count; i++) {
+		uint64_t value = (uint32_t)(codes[i] + 1);
+		auto bit = i * this->bits;
+		auto word = bit / 64, shift = bit % 64;
+		this->words[word] |= value << shift;
+		// Spill the top of the value into the next word
+		if (shift + this->bits > 64) {
+			this->words[word + 1] |= value >> (64 - shift);
+		}
+	}
+}
+
+unsigned int BitPackedCodes::at(std::size_t index) const
+{
+	assert(index < this->count);
+	if (this->bits == 0) return (unsigned int)-1;
+	auto bit = index * this->bits;
+	auto word = bit / 64, shift = bit % 64;
+	uint64_t value = this->words[word] >> shift;
+	if (shift + this->bits > 64) {
+		value |= this->words[word + 1] << (64 - shift);
+	}
+	uint64_t mask = ((uint64_t)1 << this->bits) - 1;
+	return (uint32_t)(value & mask) - 1;
+}
+
+void BitPackedCodes::unpack(unsigned int *out) const
+{
+	if (this->bits == 0) {
+		std::fill(out, out + this->count, (unsigned int)-1);
+		return;
+	}
+
+	// Read each word once, keeping the bits not used yet, rather than working
+	// out where every code starts as at() does.
+	uint64_t mask = ((uint64_t)1 << this->bits) - 1;
+	auto word = this->words.begin();
+	uint64_t pending = 0;   // Unused bits from the last word read, LSB first
+	unsigned int left = 0;  // Number of bits in pending
+	for (std::size_t i = 0; i < this->count; i++) {
+		uint64_t value;
+		if (left >= this->bits) {
+			value = pending & mask;
+			pending >>= this->bits;
+			left -= this->bits;
+		} else {
+			// The code continues into the next word
+			uint64_t next = *word++;
+			value = (pending | (next << left)) & mask;
+			unsigned int used = this->bits - left;
+			pending = next >> used;
+			left = 64 - used;
+		}
+		out[i] = (uint32_t)value - 1;
+	}
+	return;
+}
+
+std::size_t BitPackedCodes::bytes() const
+{
+	return this->words.size() * sizeof(uint64_t);
+}
+
+std::size_t BitPackedCodes::bytesFor(const unsigned int *codes,
+	std::size_t count)
+{
+	auto bits = BitPackedCodes::bitsFor(codes, count);
+	if (bits == 0) return 0;
+	return (count * bits + 63) / 64 * sizeof(uint64_t);
+}
+
+unsigned int BitPackedCodes::bitsFor(const unsigned int *codes,
+	std::size_t count)
+{
+	// Shift every code up by one, so INVALID_TILECODE wraps around to zero
+	uint32_t maxValue = 0;
+	for (std::size_t i = 0; i < count; i++) {
+		maxValue = std::max<uint32_t>(maxValue, codes[i] + 1);
+	}
+	unsigned int bits = 0;
+	while ((bits < 32) && (maxValue >> bits)) bits++;
+	return bits;
+}
+
+std::shared_ptr<const PackedCodes> packCodes(const unsigned int *codes,
+	std::size_t count, MapArena *arena)
+{
+	// Run ends are stored as 32-bit values
+	if (count > UINT32_MAX) return nullptr;
+
+	if (
+		RunLengthCodes::bytesFor(codes, count)
+		< BitPackedCodes::bytesFor(codes, count)
+	) {
+		return std::allocate_shared<RunLengthCodes>(
+			ArenaAllocator<RunLengthCodes>(arena), codes, count, arena);
+	}
+	return std::allocate_shared<BitPackedCodes>(
+		ArenaAllocator<BitPackedCodes>(arena), codes, count, arena);
+}
+
+} // namespace gamemaps
+} // namespace camoto
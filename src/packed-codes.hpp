@@ -0,0 +1,163 @@
+/**
+ * @file  packed-codes.hpp
+ * @brief Compact in-memory storage for grids of tile codes.
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _CAMOTO_GAMEMAPS_PACKED_CODES_HPP_
+#define _CAMOTO_GAMEMAPS_PACKED_CODES_HPP_
+
+#include <memory>
+#include <vector>
+#include <stdint.h>
+#include <camoto/gamemaps/arena.hpp>
+
+namespace camoto {
+namespace gamemaps {
+
+/// Read-only list of tile codes, held in less memory than a plain array.
+class PackedCodes
+{
+	public:
+		virtual ~PackedCodes();
+
+		/// Number of codes in the list.
+		std::size_t size() const
+		{
+			return this->count;
+		}
+
+		/// Get a single code without unpacking the rest of the list.
+		/**
+		 * @param index
+		 *   Position in the list, which must be less than size().
+		 */
+		virtual unsigned int at(std::size_t index) const = 0;
+
+		/// Unpack every code in the list.
+		/**
+		 * @param out
+		 *   Buffer with room for size() codes.
+		 */
+		virtual void unpack(unsigned int *out) const = 0;
+
+		/// Memory used by the packed codes, in bytes.
+		virtual std::size_t bytes() const = 0;
+
+	protected:
+		std::size_t count; ///< Number of codes stored
+};
+
+/// Codes stored as runs of the same value.
+/**
+ * Suits layers that are mostly one tile, such as a sky or an empty
+ * background.  The end of each run is kept alongside its code, so a single
+ * cell can be found with a binary search instead of walking every run.
+ */
+class RunLengthCodes: public PackedCodes
+{
+	public:
+		/// Pack a list of codes.
+		/**
+		 * @param codes
+		 *   Codes to pack.
+		 *
+		 * @param count
+		 *   Number of codes.
+		 *
+		 * @param arena
+		 *   Arena to hold the packed codes, or a null pointer for the heap.
+		 */
+		RunLengthCodes(const unsigned int *codes, std::size_t count,
+			MapArena *arena);
+
+		virtual unsigned int at(std::size_t index) const;
+		virtual void unpack(unsigned int *out) const;
+		virtual std::size_t bytes() const;
+
+		/// Work out the value bytes() would return for a list of codes.
+		static std::size_t bytesFor(const unsigned int *codes, std::size_t count);
+
+	private:
+		typedef std::vector<uint32_t, ArenaAllocator<uint32_t>> List;
+
+		List runCode; ///< Code repeated in each run
+		List runEnd;  ///< Index just past the end of each run
+};
+
+/// Codes stored with only as many bits as the largest code needs.
+/**
+ * Suits layers drawn from a small set of tiles but with no long runs.
+ * INVALID_TILECODE is stored as zero, so empty cells don't force every code
+ * up to 32 bits.
+ */
+class BitPackedCodes: public PackedCodes
+{
+	public:
+		/// Pack a list of codes.
+		/**
+		 * @param codes
+		 *   Codes to pack.
+		 *
+		 * @param count
+		 *   Number of codes.
+		 *
+		 * @param arena
+		 *   Arena to hold the packed codes, or a null pointer for the heap.
+		 */
+		BitPackedCodes(const unsigned int *codes, std::size_t count,
+			MapArena *arena);
+
+		virtual unsigned int at(std::size_t index) const;
+		virtual void unpack(unsigned int *out) const;
+		virtual std::size_t bytes() const;
+
+		/// Work out the value bytes() would return for a list of codes.
+		static std::size_t bytesFor(const unsigned int *codes, std::size_t count);
+
+	private:
+		/// Number of bits needed to store every code in a list.
+		static unsigned int bitsFor(const unsigned int *codes, std::size_t count);
+
+		unsigned int bits;  ///< Width of each code, 0 to 32
+		std::vector<uint64_t, ArenaAllocator<uint64_t>> words; ///< Codes, LSB first
+};
+
+/// Pack a list of codes using whichever storage is smallest for them.
+/**
+ * The size of each kind of storage is worked out first, so only the smaller
+ * one is built.
+ *
+ * @param codes
+ *   Codes to pack.
+ *
+ * @param count
+ *   Number of codes.
+ *
+ * @param arena
+ *   Arena to hold the packed codes, or a null pointer for the heap.
+ *
+ * @return The packed codes, or a null pointer if the list is too long to
+ *   pack.
+ */
+std::shared_ptr<const PackedCodes> packCodes(const unsigned int *codes,
+	std::size_t count, MapArena *arena);
+
+} // namespace gamemaps
+} // namespace camoto
+
+#endif // _CAMOTO_GAMEMAPS_PACKED_CODES_HPP_
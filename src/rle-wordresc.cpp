@@ -0,0 +1,97 @@
+/**
+ * @file  rle-wordresc.cpp
+ * @brief RLE codec used by Word Rescue levels.
+ *
+ * This file format is fully documented on the ModdingWiki:
+ *   http://www.shikadi.net/moddingwiki/Word_Rescue
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <camoto/gamemaps/rle-wordresc.hpp>
+
+/// Longest run that can be stored in a single RLE pair
+#define WR_RLE_MAX_RUN 0xFF
+
+namespace camoto {
+namespace gamemaps {
+
+unsigned long rleDecodeWR(const uint8_t *in, unsigned long lenIn,
+	uint8_t *out, unsigned long lenOut, unsigned long *lenConsumed)
+{
+	unsigned long posIn = 0, posOut = 0;
+	while ((posOut < lenOut) && (posIn + 2 <= lenIn)) {
+		unsigned long num = in[posIn];
+		uint8_t code = in[posIn + 1];
+		posIn += 2;
+
+		// Don't let a corrupted run write past the end of the layer
+		num = std::min(num, lenOut - posOut);
+		memset(out + posOut, code, num);
+		posOut += num;
+	}
+	*lenConsumed = posIn;
+	return posOut;
+}
+
+unsigned long rleReadWR(stream::input& content, std::vector<uint8_t>& out)
+{
+	stream::pos start = content.tellg();
+	stream::len lenIn = content.size() - start;
+	std::vector<uint8_t> in(lenIn);
+	content.read(in.data(), lenIn);
+
+	unsigned long lenConsumed;
+	unsigned long lenDecoded = rleDecodeWR(in.data(), lenIn, out.data(),
+		out.size(), &lenConsumed);
+
+	// Leave the stream just after the RLE data, so the next block can be read
+	content.seekg(start + lenConsumed, stream::start);
+	return lenDecoded;
+}
+
+unsigned long rleEncodeWR(const std::vector<uint8_t>& in,
+	std::vector<uint8_t>& out)
+{
+	auto lenStart = out.size();
+	auto end = in.end();
+	for (auto run = in.begin(); run != end; ) {
+		uint8_t code = *run;
+		auto limit = run + std::min<long>(WR_RLE_MAX_RUN, end - run);
+		// Find where the run ends, no further than the longest run that fits
+		auto next = std::find_if(run + 1, limit,
+			[code](uint8_t c) { return c != code; });
+		out.push_back(next - run);
+		out.push_back(code);
+		run = next;
+	}
+	return out.size() - lenStart;
+}
+
+unsigned long rleWriteWR(stream::output& output,
+	const std::vector<uint8_t>& data)
+{
+	std::vector<uint8_t> rle;
+	rle.reserve(data.size() / 4);
+	unsigned long lenWritten = rleEncodeWR(data, rle);
+	output.write(rle.data(), lenWritten);
+	return lenWritten;
+}
+
+} // namespace gamemaps
+} // namespace camoto
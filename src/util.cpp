@@ -19,7 +19,10 @@
  */
 
 #include <cassert>
+#include <stdint.h>
+#include <unordered_map>
 #include <camoto/gamemaps/util.hpp>
+#include "map2d-core.hpp"
 
 namespace camoto {
 namespace gamemaps {
@@ -56,5 +59,278 @@ void getLayerDims(const Map2D& map, const Map2D::Layer& layer, Point *layerSize,
 	return;
 }
 
+/// Largest gap between the lowest and highest code for a table to be
+/// expanded into a flat array, as a multiple of the number of entries.
+#define REMAP_DENSE_FACTOR 4
+
+/// Smallest flat array always considered worth using, in entries.
+#define REMAP_DENSE_MIN 4096
+
+/// Work out new codes for a layer, then store them if any changed.
+/**
+ * @param lookup
+ *   Called for each item's code.  Returns false if the code is unmapped.
+ */
+template <class Lookup>
+static void remapLayer(Map2D& map, unsigned int layer, Lookup lookup,
+	RemapResult *result)
+{
+	auto layers = map.layers();
+	if (layer >= layers.size()) {
+		throw camoto::error("Tried to remap a layer that doesn't exist.");
+	}
+	auto& l = layers[layer];
+
+	// First pass: gather the new codes without touching the layer
+	auto view = l->itemView();
+	std::vector<unsigned int> newCodes(view.size());
+	std::size_t changed = 0;
+	for (std::size_t i = 0; i < view.size(); i++) {
+		unsigned int code = view[i].code;
+		newCodes[i] = code;
+		if (code == INVALID_TILECODE) continue;
+		if (!lookup(code, &newCodes[i])) {
+			result->unmapped.insert(code);
+			newCodes[i] = code;
+		} else if (newCodes[i] != code) {
+			changed++;
+		}
+	}
+	if (!changed) return;
+
+	// Second pass: write them back
+	auto& items = l->items();
+	assert(items.size() == newCodes.size());
+	for (std::size_t i = 0; i < items.size(); i++) items[i].code = newCodes[i];
+	result->changed += changed;
+
+	Map2D::Change c = Map2D::Change();
+	c.type = Map2D::Change::Type::Items;
+	c.layer = layer;
+	Point tileSize;
+	getLayerDims(map, *l, &c.size, &tileSize);
+	map.changed(c);
+	return;
+}
+
+/// Look up codes in a remap table as quickly as the table allows.
+class RemapTable
+{
+	public:
+		RemapTable(const std::map<unsigned int, unsigned int>& table)
+			:	table(table),
+				first(0)
+		{
+			if (table.empty()) return;
+			unsigned int lo = table.begin()->first;
+			unsigned int hi = table.rbegin()->first;
+			unsigned long span = (unsigned long)hi - lo + 1;
+			if (
+				(span <= REMAP_DENSE_MIN)
+				|| (span <= table.size() * REMAP_DENSE_FACTOR)
+			) {
+				this->first = lo;
+				this->dense.assign(span, 0);
+				this->present.assign(span, false);
+				for (auto& i : table) {
+					this->dense[i.first - lo] = i.second;
+					this->present[i.first - lo] = true;
+				}
+			}
+		}
+
+		bool operator() (unsigned int code, unsigned int *newCode) const
+		{
+			if (!this->present.empty()) {
+				unsigned int offset = code - this->first;
+				if ((code < this->first) || (offset >= this->present.size())) {
+					return false;
+				}
+				if (!this->present[offset]) return false;
+				*newCode = this->dense[offset];
+				return true;
+			}
+			auto i = this->table.find(code);
+			if (i == this->table.end()) return false;
+			*newCode = i->second;
+			return true;
+		}
+
+	private:
+		const std::map<unsigned int, unsigned int>& table;
+		unsigned int first;                 ///< Code at dense[0]
+		std::vector<unsigned int> dense;    ///< New codes, if compact enough
+		std::vector<bool> present;          ///< Which entries of dense are set
+};
+
+RemapResult remapCodes(Map2D& map, unsigned int layer,
+	const std::map<unsigned int, unsigned int>& table)
+{
+	RemapResult result = RemapResult();
+	RemapTable lookup(table);
+	remapLayer(map, layer, std::cref(lookup), &result);
+	return result;
+}
+
+RemapResult remapCodes(Map2D& map,
+	const std::map<unsigned int, unsigned int>& table)
+{
+	RemapResult result = RemapResult();
+	RemapTable lookup(table);
+	auto numLayers = map.layerView().size();
+	map.beginUpdate();
+	try {
+		for (unsigned int l = 0; l < numLayers; l++) {
+			remapLayer(map, l, std::cref(lookup), &result);
+		}
+	} catch (...) {
+		map.endUpdate();
+		throw;
+	}
+	map.endUpdate();
+	return result;
+}
+
+RemapResult transformCodes(Map2D& map, unsigned int layer,
+	const CodeTransform& fn)
+{
+	RemapResult result = RemapResult();
+
+	// Only call the function once per code, as it could be slow
+	std::unordered_map<unsigned int, std::pair<bool, unsigned int>> seen;
+	auto lookup = [&fn, &seen](unsigned int code, unsigned int *newCode) {
+		auto i = seen.find(code);
+		if (i == seen.end()) {
+			std::pair<bool, unsigned int> r(false, code);
+			r.first = fn(code, &r.second);
+			i = seen.emplace(code, r).first;
+		}
+		*newCode = i->second.second;
+		return i->second.first;
+	};
+	remapLayer(map, layer, lookup, &result);
+	return result;
+}
+
+/// Work out a layer's size in tiles, without assuming the map is valid.
+/**
+ * Unlike getLayerDims(), this doesn't need a tile size unless the layer has
+ * its own, so it works on any map a format handler is able to open.
+ *
+ * @return true if layerSize was set, false if the size isn't known.
+ */
+static bool layerSizeForPacking(const Map2D& map, const Map2D::Layer& layer,
+	Point *layerSize)
+{
+	auto mapCaps = map.caps();
+	auto layerCaps = layer.caps();
+	if (layerCaps & Map2D::Layer::Caps::HasOwnSize) {
+		*layerSize = layer.layerSize();
+		return true;
+	}
+	if (!(mapCaps & Map2D::Caps::HasMapSize)) return false;
+	if (layerCaps & Map2D::Layer::Caps::HasOwnTileSize) {
+		// Converting from the map's tiles to the layer's needs both sizes
+		if (!(mapCaps & Map2D::Caps::HasTileSize)) return false;
+		auto mapTileSize = map.tileSize();
+		auto layerTileSize = layer.tileSize();
+		if (
+			(mapTileSize.x <= 0) || (mapTileSize.y <= 0)
+			|| (layerTileSize.x <= 0) || (layerTileSize.y <= 0)
+		) {
+			return false;
+		}
+		Point tileSize;
+		getLayerDims(map, layer, layerSize, &tileSize);
+		return true;
+	}
+	*layerSize = map.mapSize();
+	return true;
+}
+
+unsigned int packLayers(Map2D& map)
+{
+	unsigned int numPacked = 0;
+	for (auto& layer : map.layers()) {
+		auto core = dynamic_cast<Map2DCore::LayerCore*>(layer.get());
+		if (!core) continue;
+		if (core->sharedItems().packed()) {
+			numPacked++;
+			continue;
+		}
+		Point layerSize;
+		if (!layerSizeForPacking(map, *layer, &layerSize)) continue;
+		if ((layerSize.x <= 0) || (layerSize.y <= 0)) continue;
+
+		// Packing goes through a code for every cell, so a grid much larger
+		// than its items (or a corrupt map size) would need more memory to pack
+		// than it saves.
+		uint64_t cells = (uint64_t)layerSize.x * layerSize.y;
+		uint64_t maxCells = (uint64_t)core->sharedItems().size()
+			* (sizeof(Map2D::Layer::Item) / sizeof(unsigned int));
+		if (cells > maxCells) continue;
+
+		if (core->editItems().pack(layerSize)) numPacked++;
+	}
+	return numPacked;
+}
+
+std::vector<PlacementProblem> validate(const Map2D& map, unsigned int layer)
+{
+	std::vector<PlacementProblem> problems;
+	auto layers = map.layerView();
+	if (layer >= layers.size()) {
+		throw camoto::error("Tried to validate a layer that doesn't exist.");
+	}
+	auto& l = layers[layer];
+	auto items = l.itemView();
+
+	Point layerSize, tileSize;
+	getLayerDims(map, l, &layerSize, &tileSize);
+
+	std::vector<bool> permitted;
+	std::vector<unsigned int> maxCount;
+	l.itemsPermitted(items, &permitted, &maxCount);
+
+	std::unordered_map<unsigned int, unsigned int> count;
+	for (std::size_t i = 0; i < items.size(); i++) {
+		auto& item = items[i];
+		PlacementProblem p;
+		p.layer = layer;
+		p.index = i;
+		p.pos = item.pos;
+		p.code = item.code;
+		p.maxCount = maxCount[i];
+
+		if (
+			(item.pos.x < 0) || (item.pos.x >= layerSize.x)
+			|| (item.pos.y < 0) || (item.pos.y >= layerSize.y)
+		) {
+			p.type = PlacementProblem::Type::OutOfBounds;
+			problems.push_back(p);
+		}
+		if (!permitted[i]) {
+			p.type = PlacementProblem::Type::NotPermitted;
+			problems.push_back(p);
+		}
+		if (maxCount[i] && (++count[item.code] > maxCount[i])) {
+			p.type = PlacementProblem::Type::TooMany;
+			problems.push_back(p);
+		}
+	}
+	return problems;
+}
+
+std::vector<PlacementProblem> validate(const Map2D& map)
+{
+	std::vector<PlacementProblem> problems;
+	auto numLayers = map.layerView().size();
+	for (unsigned int l = 0; l < numLayers; l++) {
+		auto p = validate(map, l);
+		problems.insert(problems.end(), p.begin(), p.end());
+	}
+	return problems;
+}
+
 } // namespace gamemaps
 } // namespace camoto
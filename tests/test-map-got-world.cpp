@@ -0,0 +1,124 @@
+/**
+ * @file   test-map-got-world.cpp
+ * @brief  Test code for God of Thunder episodes opened as a single map.
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <camoto/util.hpp> // make_unique
+#include <camoto/gamemaps/util.hpp>
+#include "test-map2d.hpp"
+
+/// Length of one screen
+#define SCREEN_LEN 512
+
+class test_map_got_world: public test_map2d
+{
+	public:
+		test_map_got_world()
+		{
+			this->type = "map2d-got-world";
+			this->pxSize = {10 * 20 * 16, 12 * 12 * 16};
+			this->numLayers = 3;
+			// Items are on screen 11, the second screen of the second row
+			this->mapCode[0].pos = {20 + 0, 12 + 1};
+			this->mapCode[0].code = 0xB1;
+			this->mapCode[1].pos = {20 + 3, 12 + 4};
+			this->mapCode[1].code = 0x04;
+			this->mapCode[2].pos = {20 + 5, 12 + 6};
+			this->mapCode[2].code = 0x01;
+			this->outputWidth = 20;
+		}
+
+		void addTests()
+		{
+			this->test_map2d::addTests();
+
+			// c00: Initial state
+			this->isInstance(MapType::DefinitelyYes, this->initialstate());
+
+			// c01: One screen missing
+			this->isInstance(MapType::DefinitelyNo,
+				this->initialstate().substr(SCREEN_LEN));
+
+			// c02: Background layer code out of range on the last screen
+			{
+				auto data = this->initialstate();
+				data[119 * SCREEN_LEN + 5] = '\xFF';
+				this->isInstance(MapType::DefinitelyNo, data);
+			}
+
+			ADD_MAP2D_TEST(false, &test_map_got_world::test_pack_world);
+		}
+
+		/// A full background spread over every screen can be packed.
+		void test_pack_world()
+		{
+			BOOST_TEST_MESSAGE(this->basename << ": Pack a full world background");
+
+			// Every screen's background is non-default, so the layer is a full grid
+			std::string data;
+			for (int i = 0; i < 120; i++) {
+				auto screen = this->blankScreen();
+				for (int j = 0; j < 240; j++) screen[j] = (char)((i + j) % 3);
+				data += screen;
+			}
+			auto content = std::make_unique<stream::string>();
+			*content << data;
+			auto mapType = MapManager::byCode(this->type);
+			auto map = std::dynamic_pointer_cast<Map2D>(
+				std::shared_ptr<Map>(mapType->open(std::move(content), this->suppData))
+			);
+			BOOST_REQUIRE(map);
+
+			// The screens are decoded out of order, but the items must end up in
+			// row-major order across the whole world.
+			auto items = map->layers()[0]->itemView();
+			BOOST_REQUIRE_EQUAL(items.size(), 200 * 144);
+			BOOST_CHECK_EQUAL(items[1].pos.x, 1);
+			BOOST_CHECK_EQUAL(items[20].pos.x, 20);
+			BOOST_CHECK_EQUAL(items[20].pos.y, 0);
+			BOOST_CHECK_EQUAL(items[20].code, 10 % 3);
+
+			// Only the background is a full grid
+			BOOST_CHECK_EQUAL(packLayers(*map), 1);
+		}
+
+		/// One empty screen.
+		std::string blankScreen()
+		{
+			return std::string(240, '\xB0')
+				+ STRING_WITH_NULLS("\xB0\x00")
+				+ std::string(SCREEN_LEN - 240 - 2, '\x00');
+		}
+
+		virtual std::string initialstate()
+		{
+			std::string data;
+			for (int i = 0; i < 120; i++) data += this->blankScreen();
+
+			auto screen = 11 * SCREEN_LEN;
+			data[screen + 20] = '\xB1'; // background tile at (0,1)
+			data[screen + 242] = '\x05'; // actor code + 1
+			data[screen + 242 + 16] = '\x53'; // actor at (3,4)
+			data[screen + 322] = '\x02'; // object code + 1
+			data[screen + 322 + 30] = '\x05'; // object X
+			data[screen + 322 + 90] = '\x06'; // object Y
+			return data;
+		}
+};
+
+IMPLEMENT_TESTS(map_got_world);
@@ -0,0 +1,173 @@
+/**
+ * @file   test-map-native.cpp
+ * @brief  Test code for the native interchange map format.
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test-map2d.hpp"
+
+class test_map_native: public test_map2d
+{
+	public:
+		test_map_native()
+		{
+			this->type = "map2d-native";
+			this->pxSize = {4 * 8, 2 * 8};
+			this->numLayers = 2;
+			this->mapCode[0].pos = {1, 0};
+			this->mapCode[0].code = 0x02;
+			this->mapCode[1].pos = {2, 1};
+			this->mapCode[1].code = 0x05;
+
+			{
+				this->attributes.emplace_back();
+				auto& a = this->attributes.back();
+				a.type = Attribute::Type::Integer;
+				a.integerValue = 3;
+			}
+		}
+
+		void addTests()
+		{
+			this->test_map2d::addTests();
+
+			// c00: Initial state
+			this->isInstance(MapType::DefinitelyYes, this->initialstate());
+
+			// c01: Too short to hold the header
+			this->isInstance(MapType::DefinitelyNo, STRING_WITH_NULLS(
+				"Camoto2D" "\x01\x00"
+			));
+
+			// c02: Bad signature
+			this->isInstance(MapType::DefinitelyNo,
+				"Camoto3D" + this->initialstate().substr(8));
+
+			// c03: Unsupported version
+			{
+				auto data = this->initialstate();
+				data[8] = '\x02';
+				this->isInstance(MapType::DefinitelyNo, data);
+			}
+
+			// c04: Section table runs past the end of the file
+			this->isInstance(MapType::DefinitelyNo,
+				this->initialstate().substr(0, 16 + 6 * 12 - 1));
+
+			// c05: Last section runs past the end of the file
+			{
+				auto data = this->initialstate();
+				this->isInstance(MapType::DefinitelyNo,
+					data.substr(0, data.length() - 1));
+			}
+
+			// i01: Layer uses an unknown encoding
+			{
+				auto data = this->initialstate();
+				data[156 + 6 + 4 + 8 + 8] = '\x07';
+				this->invalidContent(data);
+			}
+
+			// a00: Change the integer attribute
+			this->changeAttribute(0, 5, this->mapWithLives(5));
+		}
+
+		virtual std::string initialstate()
+		{
+			return this->mapWithLives(3);
+		}
+
+		/// Encode a 32-bit little-endian value.
+		static std::string u32(uint32_t v)
+		{
+			std::string s(4, '\0');
+			for (int i = 0; i < 4; i++) s[i] = (char)((v >> (i * 8)) & 0xFF);
+			return s;
+		}
+
+		/// Encode a length-prefixed string.
+		static std::string str(const std::string& s)
+		{
+			return u32(s.length()) + s;
+		}
+
+		/// Plain tile, as stored in an item table.
+		static std::string tile(int x, int y, unsigned int code)
+		{
+			return u32(0) + u32(x) + u32(y) + u32(code);
+		}
+
+		/// Build the test map, with the given value for the one attribute.
+		std::string mapWithLives(int lives)
+		{
+			std::string info = u32(0x0A) // HasMapSize | HasTileSize
+				+ u32(0) + u32(0)   // viewport
+				+ u32(4) + u32(2)   // map size
+				+ u32(8) + u32(8);  // tile size
+
+			std::string gfx = u32(0);
+
+			std::string attr = u32(1)
+				+ u32(0) // Attribute::Type::Integer
+				+ str("Lives") + str("")
+				+ u32(lives) + u32(0) + u32(9);
+
+			std::string bg = str("BG")
+				+ u32(0)            // caps
+				+ u32(0) + u32(0)   // layer size
+				+ u32(0) + u32(0)   // tile size
+				+ u32(0)            // dense grid
+				+ u32(4) + u32(2)
+				+ u32(1) + u32(2) + u32(1) + u32(1)
+				+ u32(1) + u32(1) + u32(1) + u32(1)
+				+ u32(2) + tile(0, 0, 1) + tile(0, 0, 2);
+
+			std::string sprites = str("Sprites")
+				+ u32(0)
+				+ u32(0) + u32(0)
+				+ u32(0) + u32(0)
+				+ u32(1)            // item table
+				+ u32(1) + tile(2, 1, 5)
+				+ u32(1) + tile(0, 0, 5);
+
+			std::string paths = u32(0);
+
+			std::vector<std::pair<std::string, std::string>> sections = {
+				{"INFO", info},
+				{"GFX ", gfx},
+				{"ATTR", attr},
+				{"LAYR", bg},
+				{"LAYR", sprites},
+				{"PATH", paths},
+			};
+			std::string table, body;
+			unsigned int offset = 16 + sections.size() * 12;
+			for (auto& s : sections) {
+				while (offset % 4) {
+					body += '\0';
+					offset++;
+				}
+				table += s.first + u32(offset) + u32(s.second.length());
+				body += s.second;
+				offset += s.second.length();
+			}
+			return STRING_WITH_NULLS("Camoto2D" "\x01\x00" "\x06\x00" "\x00\x00\x00\x00")
+				+ table + body;
+		}
+};
+
+IMPLEMENT_TESTS(map_native);
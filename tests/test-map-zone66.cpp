@@ -0,0 +1,80 @@
+/**
+ * @file   test-map-zone66.cpp
+ * @brief  Test code for Zone 66 maps.
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test-map2d.hpp"
+
+class test_suppx1_map_zone66: public test_map2d
+{
+	public:
+		test_suppx1_map_zone66()
+		{
+			this->type = "map2d-zone66.x1";
+		}
+
+		virtual std::string initialstate()
+		{
+			return STRING_WITH_NULLS(
+				"\x04\x00" "\x00\x00"
+				"\x00\x00" "\x00\x00" "\x05\x00" "\x05\x00"
+				"\x00\x00\x00\x00"
+				"\x00\x00\x00\x00"
+			);
+		}
+};
+
+class test_map_zone66: public test_map2d
+{
+	public:
+		test_map_zone66()
+		{
+			this->type = "map2d-zone66";
+			this->pxSize = {256 * 32, 256 * 32};
+			this->numLayers = 1;
+			this->mapCode[0].pos = {0, 0};
+			this->mapCode[0].code = 0x05;
+			this->suppResult[SuppItem::Extra1] = std::make_shared<test_suppx1_map_zone66>();
+
+			// Cosmo maps have no signature and are nearly the same size
+			this->skipInstDetect.push_back("map2d-cosmo");
+		}
+
+		void addTests()
+		{
+			this->test_map2d::addTests();
+
+			// c00: Initial state
+			this->isInstance(MapType::PossiblyYes, this->initialstate());
+
+			// c01: Wrong length
+			this->isInstance(MapType::DefinitelyNo, STRING_WITH_NULLS(
+				"\x02"
+				) + std::string(256 * 256 - 2, '\x00')
+			);
+		}
+
+		virtual std::string initialstate()
+		{
+			return STRING_WITH_NULLS(
+				"\x02"
+			) + std::string(256 * 256 - 1, '\x00');
+		}
+};
+
+IMPLEMENT_TESTS(map_zone66);
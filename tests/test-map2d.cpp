@@ -18,9 +18,26 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <functional>
 #include <iomanip>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+#include <utime.h>
 #include <camoto/util.hpp>
+#include <camoto/gamemaps/arena.hpp>
+#include <camoto/gamemaps/cache.hpp>
+#include <camoto/gamemaps/diff.hpp>
+#include <camoto/gamemaps/fingerprint.hpp>
+#include <camoto/gamemaps/journal.hpp>
+#include <camoto/gamemaps/lint.hpp>
+#include <camoto/gamemaps/util.hpp>
 #include "test-map2d.hpp"
 
 using namespace camoto;
@@ -49,7 +66,23 @@ void test_map2d::addTests()
 	ADD_MAP2D_TEST(false, &test_map2d::test_write);
 	ADD_MAP2D_TEST(false, &test_map2d::test_codelist);
 	ADD_MAP2D_TEST(false, &test_map2d::test_codelist_valid);
+	ADD_MAP2D_TEST(false, &test_map2d::test_uniquecodes);
 	ADD_MAP2D_TEST(false, &test_map2d::test_attributes);
+	ADD_MAP2D_TEST(false, &test_map2d::test_concurrent_read);
+	ADD_MAP2D_TEST(false, &test_map2d::test_snapshot);
+	ADD_MAP2D_TEST(false, &test_map2d::test_journal);
+	ADD_MAP2D_TEST(false, &test_map2d::test_observer);
+	ADD_MAP2D_TEST(false, &test_map2d::test_region);
+	ADD_MAP2D_TEST(false, &test_map2d::test_validate);
+	ADD_MAP2D_TEST(false, &test_map2d::test_lint);
+	ADD_MAP2D_TEST(false, &test_map2d::test_find_replace);
+	ADD_MAP2D_TEST(false, &test_map2d::test_remap);
+	ADD_MAP2D_TEST(false, &test_map2d::test_diff);
+	ADD_MAP2D_TEST(false, &test_map2d::test_fingerprint);
+	ADD_MAP2D_TEST(false, &test_map2d::test_cache);
+	ADD_MAP2D_TEST(false, &test_map2d::test_pack);
+	ADD_MAP2D_TEST(false, &test_map2d::test_fill_limit);
+	ADD_MAP2D_TEST(false, &test_map2d::test_arena);
 	//if (this->create) {
 		// TODO
 	//}
@@ -443,6 +476,7 @@ void test_map2d::test_getsize()
 	BOOST_REQUIRE_EQUAL(dims.x, this->pxSize.x);
 	BOOST_REQUIRE_EQUAL(dims.y, this->pxSize.y);
 	BOOST_REQUIRE_EQUAL(layerCount, this->numLayers);
+	BOOST_REQUIRE_EQUAL(this->map->layerView().size(), layerCount);
 }
 
 void test_map2d::test_read()
@@ -471,6 +505,15 @@ void test_map2d::test_read()
 			"Unable to find tile in layer " << l
 			<< " (counting from layer 0) at position " << target.x << "," << target.y);
 		BOOST_TEST_MESSAGE("Found tile in layer " << l);
+
+		// Make sure the read-only view sees the same items
+		auto& allItems = layer->items();
+		auto view = layer->itemView();
+		BOOST_REQUIRE_EQUAL(view.size(), allItems.size());
+		if (!view.empty()) {
+			BOOST_REQUIRE_MESSAGE(&view[0] == &allItems[0],
+				"itemView() for layer #" << l << " returned a copy of the items");
+		}
 		l++;
 	}
 }
@@ -496,7 +539,13 @@ void test_map2d::test_codelist()
 	BOOST_TEST_MESSAGE("Checking map codes are all in allowed tile list");
 	unsigned int l = 0;
 	for (auto& layer : this->map->layers()) {
-		auto allowed = layer->availableItems();
+		auto& allowed = layer->availableItems();
+
+		// The list should be cached rather than rebuilt on each call
+		BOOST_REQUIRE_MESSAGE(&allowed == &layer->availableItems(),
+			"availableItems() returned a different list on the second call for "
+			"layer " << (l+1));
+
 		for (auto& i : layer->items()) {
 			bool found = false;
 			for (auto& j : allowed) {
@@ -530,6 +579,29 @@ void test_map2d::test_codelist_valid()
 	}
 }
 
+void test_map2d::test_uniquecodes()
+{
+	BOOST_TEST_MESSAGE("Checking unique tile code count");
+	unsigned int l = 0;
+	for (auto& layer : this->map->layerView()) {
+		std::set<unsigned int> codes;
+		for (auto& i : layer.itemView()) codes.insert(i.code);
+
+		unsigned int maxCount = (unsigned int)-1;
+		auto count = layer.uniqueCodes(&maxCount);
+		BOOST_REQUIRE_NE(maxCount, (unsigned int)-1);
+
+		// Formats may leave out codes that are always present (e.g. a default
+		// tile), so the count can be lower but never higher.
+		BOOST_CHECK_LE(count, codes.size());
+		if (maxCount) {
+			BOOST_CHECK_MESSAGE(count <= maxCount,
+				"Layer " << l << " has more unique codes than it can store");
+		}
+		l++;
+	}
+}
+
 void test_map2d::test_attributes()
 {
 	BOOST_TEST_MESSAGE(this->basename << ": Test attributes");
@@ -572,3 +644,810 @@ void test_map2d::test_attributes()
 		i++;
 	}
 }
+
+/// Describe everything the const interface reports about a map.
+/**
+ * Each thread in test_concurrent_read() produces one of these, and they must
+ * all match.  A fresh (empty) TilesetCollection is used for each call, as
+ * tilesets themselves can't be shared between threads.
+ *
+ * The caps that allow resizing are left out, as snapshots never have them.
+ */
+static std::string describeMap(const Map2D& map)
+{
+	std::ostringstream out;
+	TilesetCollection tilesets;
+
+	out << "caps=" << ((unsigned int)map.caps()
+		& ~(unsigned int)(Map2D::Caps::SetMapSize | Map2D::Caps::SetTileSize));
+	if (map.caps() & Map2D::Caps::HasMapSize) {
+		auto size = map.mapSize();
+		out << " size=" << size.x << "x" << size.y;
+	}
+	out << " bg=" << (int)map.background(tilesets).att;
+	for (auto& i : map.graphicsFilenames()) {
+		out << " gfx" << (int)i.first << "=" << i.second.filename
+			<< ":" << i.second.type;
+	}
+	for (auto& a : map.attributes()) {
+		out << " attr=" << a.name << ":";
+		switch (a.type) {
+			case Attribute::Type::Integer: out << a.integerValue; break;
+			case Attribute::Type::Enum: out << a.enumValue; break;
+			case Attribute::Type::Filename: out << a.filenameValue; break;
+			case Attribute::Type::Text: out << a.textValue; break;
+			default: break;
+		}
+	}
+
+	for (auto& layer : map.layers()) {
+		out << "\nlayer " << layer->title() << " caps="
+			<< ((unsigned int)layer->caps() & ~(unsigned int)(
+				Map2D::Layer::Caps::SetOwnSize | Map2D::Layer::Caps::SetOwnTileSize));
+		unsigned long sum = 0;
+		for (auto& i : layer->itemView()) {
+			sum += i.code + i.pos.x * 3 + i.pos.y * 7;
+		}
+		auto items = layer->items();
+		out << " items=" << items.size() << " sum=" << sum;
+		if (!items.empty()) {
+			out << " img=" << (int)layer->imageFromCode(items[0], tilesets).type;
+		}
+		auto& available = layer->availableItems();
+		out << " available=" << available.size() << "@" << &available;
+		unsigned int maxCount;
+		out << " unique=" << layer->uniqueCodes(&maxCount) << "/" << maxCount;
+	}
+	return out.str();
+}
+
+void test_map2d::test_concurrent_read()
+{
+	BOOST_TEST_MESSAGE(this->basename << ": Read from multiple threads at once");
+
+	std::shared_ptr<const Map2D> map = this->map;
+	auto expected = describeMap(*map);
+
+	// Run this under ThreadSanitizer (configure --enable-tsan) to check for
+	// data races as well as wrong results.
+	const unsigned int numThreads = 4;
+	std::vector<std::string> results(numThreads);
+	std::vector<std::thread> threads;
+	for (unsigned int t = 0; t < numThreads; t++) {
+		threads.emplace_back([map, &results, t]() {
+			for (int n = 0; n < 8; n++) {
+				results[t] = describeMap(*map);
+			}
+		});
+	}
+	for (auto& t : threads) t.join();
+
+	for (unsigned int t = 0; t < numThreads; t++) {
+		BOOST_CHECK_MESSAGE(results[t] == expected,
+			"Thread " << t << " saw different data:\n" << results[t]
+			<< "\nExpected:\n" << expected);
+	}
+}
+
+void test_map2d::test_snapshot()
+{
+	BOOST_TEST_MESSAGE(this->basename << ": Snapshot is unaffected by edits");
+
+	auto expected = describeMap(*this->map);
+	auto snap = snapshot(this->map);
+	BOOST_REQUIRE_EQUAL(describeMap(*snap), expected);
+
+	// Remove the known tile from each layer of the live map
+	unsigned int l = 0;
+	for (auto& layer : this->map->layers()) {
+		auto& items = layer->items();
+		auto target = this->mapCode[l].pos;
+		items.erase(
+			std::remove_if(items.begin(), items.end(),
+				[&target](const Map2D::Layer::Item& i) {
+					return (i.pos.x == target.x) && (i.pos.y == target.y);
+				}
+			),
+			items.end()
+		);
+		l++;
+	}
+	BOOST_CHECK_NE(describeMap(*this->map), expected);
+	BOOST_CHECK_EQUAL(describeMap(*snap), expected);
+
+	// Rolling back to the snapshot should save the original data again
+	restoreSnapshot(*this->map, *snap);
+	BOOST_CHECK_EQUAL(describeMap(*this->map), expected);
+	this->checkData(&test_map2d::initialstate,
+		"Error saving map after restoring a snapshot - data is different to "
+		"original"
+	);
+
+	// Saving only reads the items, so the layers are still shared afterwards
+	auto liveLayers = this->map->layers();
+	auto snapLayers = snap->layers();
+	for (unsigned int i = 0; i < liveLayers.size(); i++) {
+		BOOST_CHECK_MESSAGE(
+			liveLayers[i]->itemView().begin() == snapLayers[i]->itemView().begin(),
+			"Saving the map made layer " << i << " copy its items"
+		);
+	}
+
+	// A reference from items() taken before a snapshot can't change the snapshot
+	std::vector<std::vector<Map2D::Layer::Item> *> lentItems;
+	for (auto& layer : liveLayers) lentItems.push_back(&layer->items());
+	auto lentSnap = snapshot(this->map);
+	for (auto items : lentItems) {
+		for (auto& i : *items) i.code++;
+	}
+	BOOST_CHECK_EQUAL(describeMap(*lentSnap), expected);
+}
+
+void test_map2d::test_journal()
+{
+	BOOST_TEST_MESSAGE(this->basename << ": Undo and redo edits made through a "
+		"journal");
+
+	auto original = describeMap(*this->map);
+	EditJournal journal(this->map);
+	BOOST_REQUIRE(!journal.canUndo());
+
+	// Clear the known tile on every layer as one step
+	journal.beginGroup();
+	for (unsigned int l = 0; l < this->numLayers; l++) {
+		journal.setCell(l, this->mapCode[l].pos, INVALID_TILECODE);
+	}
+	journal.endGroup();
+	auto cleared = describeMap(*this->map);
+	BOOST_CHECK_NE(cleared, original);
+
+	// Then put a different code back one tile further along, and move the
+	// first item on the first layer, as separate steps
+	for (unsigned int l = 0; l < this->numLayers; l++) {
+		Point pos = this->mapCode[l].pos;
+		pos.x++;
+		journal.setCell(l, pos, this->mapCode[l].code + 1);
+	}
+	if (!this->map->layers()[0]->itemView().empty()) {
+		journal.moveItem(0, 0, {0, 0});
+	}
+	auto edited = describeMap(*this->map);
+
+	while (journal.canUndo()) journal.undo();
+	BOOST_CHECK_EQUAL(describeMap(*this->map), original);
+	BOOST_REQUIRE(journal.canRedo());
+
+	// The first redo should restore the whole group
+	journal.redo();
+	BOOST_CHECK_EQUAL(describeMap(*this->map), cleared);
+	while (journal.canRedo()) journal.redo();
+	BOOST_CHECK_EQUAL(describeMap(*this->map), edited);
+
+	while (journal.canUndo()) journal.undo();
+	this->checkData(&test_map2d::initialstate,
+		"Error saving map after undoing all edits - data is different to "
+		"original"
+	);
+
+	// The journal doesn't lend the items out, so snapshots taken after an edit
+	// share them instead of each taking a copy
+	journal.setCell(0, this->mapCode[0].pos, INVALID_TILECODE);
+	auto snap1 = snapshot(this->map);
+	auto snap2 = snapshot(this->map);
+	auto layers1 = snap1->layers(), layers2 = snap2->layers();
+	for (unsigned int i = 0; i < layers1.size(); i++) {
+		BOOST_CHECK_MESSAGE(
+			layers1[i]->itemView().begin() == layers2[i]->itemView().begin(),
+			"Snapshots of layer " << i << " taken after a journal edit don't "
+			"share their items"
+		);
+	}
+}
+
+/// Observer that keeps every batch of changes it is sent.
+class RecordChanges: public Map2D::Observer
+{
+	public:
+		virtual void mapChanged(const Map2D& map,
+			const std::vector<Map2D::Change>& changes)
+		{
+			this->batches.push_back(changes);
+		}
+
+		std::vector<std::vector<Map2D::Change>> batches;
+};
+
+/// Is the given cell on the given layer inside any of the changed areas?
+static bool reported(const std::vector<Map2D::Change>& changes,
+	unsigned int layer, const Point& pos)
+{
+	for (auto& c : changes) {
+		if (
+			(c.type == Map2D::Change::Type::Items)
+			&& (c.layer == layer)
+			&& (pos.x >= c.pos.x) && (pos.x < c.pos.x + c.size.x)
+			&& (pos.y >= c.pos.y) && (pos.y < c.pos.y + c.size.y)
+		) return true;
+	}
+	return false;
+}
+
+void test_map2d::test_observer()
+{
+	BOOST_TEST_MESSAGE(this->basename << ": Observers are told which cells "
+		"changed");
+
+	auto observer = std::make_shared<RecordChanges>();
+	this->map->addObserver(observer);
+
+	EditJournal journal(this->map);
+	journal.beginGroup();
+	for (unsigned int l = 0; l < this->numLayers; l++) {
+		journal.setCell(l, this->mapCode[l].pos, this->mapCode[l].code + 1);
+	}
+	BOOST_CHECK_EQUAL(observer->batches.size(), 0);
+	journal.endGroup();
+
+	// The whole group should arrive as one batch
+	BOOST_REQUIRE_EQUAL(observer->batches.size(), 1);
+	for (unsigned int l = 0; l < this->numLayers; l++) {
+		BOOST_CHECK_MESSAGE(
+			reported(observer->batches[0], l, this->mapCode[l].pos),
+			"Change to layer " << l << " was not reported"
+		);
+	}
+
+	journal.undo();
+	BOOST_REQUIRE_EQUAL(observer->batches.size(), 2);
+	for (unsigned int l = 0; l < this->numLayers; l++) {
+		BOOST_CHECK(reported(observer->batches[1], l, this->mapCode[l].pos));
+	}
+
+	// Once released, the observer must no longer be called
+	std::weak_ptr<RecordChanges> gone = observer;
+	observer.reset();
+	BOOST_CHECK(gone.expired());
+	journal.redo();
+	journal.undo();
+
+	this->checkData(&test_map2d::initialstate,
+		"Error saving map after undoing an observed edit - data is different to "
+		"original"
+	);
+}
+
+/// Does a copied block contain the given code at the given cell?
+static bool regionHas(const EditJournal::Region& region, const Point& pos,
+	unsigned int code)
+{
+	for (auto& i : region.items) {
+		if ((i.pos.x == pos.x) && (i.pos.y == pos.y) && (i.code == code)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void test_map2d::test_region()
+{
+	BOOST_TEST_MESSAGE(this->basename << ": Copy, clear and paste a block of "
+		"tiles");
+
+	EditJournal journal(this->map);
+	for (unsigned int l = 0; l < this->numLayers; l++) {
+		// Take a 3x3 block with the known tile in the middle
+		Point origin = this->mapCode[l].pos;
+		origin.x--;
+		origin.y--;
+		Point centre = {1, 1};
+		auto block = journal.copyRegion(l, origin, {3, 3});
+		BOOST_REQUIRE_MESSAGE(regionHas(block, centre, this->mapCode[l].code),
+			"Known tile on layer " << l << " was not copied");
+
+		journal.clearRegion(l, origin, {3, 3});
+		auto empty = journal.copyRegion(l, origin, {3, 3});
+		BOOST_CHECK_MESSAGE(empty.items.empty(),
+			"Layer " << l << " still has items after clearing the block");
+
+		journal.pasteRegion(l, origin, block, false);
+		auto pasted = journal.copyRegion(l, origin, {3, 3});
+		BOOST_CHECK(regionHas(pasted, centre, this->mapCode[l].code));
+
+		// A block with no area is a mistake by the caller, not an empty paste
+		EditJournal::Region flat;
+		flat.size = {0, 3};
+		BOOST_CHECK_THROW(journal.pasteRegion(l, origin, flat, false),
+			stream::error);
+
+		// Fill and shift should also be reversible.  Only one cell is filled, as
+		// some tiles are limited to one instance per level.
+		journal.fillRegion(l, this->mapCode[l].pos, {1, 1},
+			this->mapCode[l].code);
+		journal.shiftRegion(l, origin, {3, 3}, {1, 0});
+	}
+
+	while (journal.canUndo()) journal.undo();
+	this->checkData(&test_map2d::initialstate,
+		"Error saving map after undoing region edits - data is different to "
+		"original"
+	);
+}
+
+void test_map2d::test_validate()
+{
+	BOOST_TEST_MESSAGE(this->basename << ": Validate item placement");
+
+	auto layers = this->map->layers();
+	auto problems = validate(*this->map);
+	for (auto& p : problems) {
+		BOOST_REQUIRE_LT(p.layer, layers.size());
+		BOOST_CHECK_LT(p.index, layers[p.layer]->itemView().size());
+	}
+
+	// Push the known tile on the first layer just past the edge
+	Point layerSize, tileSize;
+	getLayerDims(*this->map, *layers[0], &layerSize, &tileSize);
+	auto& items = layers[0]->items();
+	std::size_t index = items.size();
+	for (std::size_t i = 0; i < items.size(); i++) {
+		auto& pos = items[i].pos;
+		if ((pos.x == this->mapCode[0].pos.x) && (pos.y == this->mapCode[0].pos.y)) {
+			index = i;
+			break;
+		}
+	}
+	BOOST_REQUIRE_LT(index, items.size());
+	items[index].pos.x = layerSize.x;
+
+	bool found = false;
+	for (auto& p : validate(*this->map, 0)) {
+		if ((p.type == PlacementProblem::Type::OutOfBounds) && (p.index == index)) {
+			found = true;
+		}
+	}
+	BOOST_CHECK_MESSAGE(found, "Item outside the layer was not reported");
+
+	items[index].pos = this->mapCode[0].pos;
+	BOOST_CHECK_EQUAL(validate(*this->map).size(), problems.size());
+}
+
+/// Get a path in the temporary directory for a file written by a test.
+/**
+ * The process ID is included, so test runs happening at the same time don't
+ * use each other's files.
+ */
+static std::string tempPath(const std::string& name)
+{
+	const char *dir = std::getenv("TMPDIR");
+	if (!dir || !*dir) dir = "/tmp";
+	return createString(dir << "/" << name << "." << getpid());
+}
+
+void test_map2d::test_lint()
+{
+	BOOST_TEST_MESSAGE(this->basename << ": Lint map files on disk");
+
+	// Missing files should be reported rather than throwing
+	auto missing = lint(
+		std::vector<std::string>{tempPath(this->basename + ".missing")},
+		this->type, 2);
+	BOOST_REQUIRE_EQUAL(missing.size(), 1);
+	BOOST_CHECK(missing[0].type == LintIssue::Type::Unreadable);
+
+	// Formats needing supplemental files would need those written out too
+	if (!this->suppResult.empty()) return;
+
+	std::string filename = tempPath(this->basename + ".lint-test");
+	{
+		std::ofstream file(filename, std::ios::binary);
+		auto data = this->initialstate();
+		file.write(data.data(), data.size());
+	}
+	auto issues = lint(std::vector<std::string>{filename, filename}, this->type,
+		2);
+
+	for (auto& i : issues) {
+		BOOST_CHECK_MESSAGE(
+			(i.type != LintIssue::Type::Unreadable)
+			&& (i.type != LintIssue::Type::NotInstance)
+			&& (i.type != LintIssue::Type::Truncated)
+			&& (i.type != LintIssue::Type::OpenFailed),
+			"Unable to lint initialstate: " << i.message
+		);
+	}
+
+	// A truncated file, checked alongside good ones by several threads, must
+	// be reported against that file without stopping the run or affecting the
+	// others, whatever the handler throws.
+	std::string truncated = tempPath(this->basename + ".lint-truncated");
+	{
+		std::ofstream file(truncated, std::ios::binary);
+		auto data = this->initialstate();
+		file.write(data.data(), data.size() / 2);
+	}
+	std::vector<LintIssue> mixed;
+	BOOST_CHECK_NO_THROW(
+		mixed = lint(std::vector<std::string>{
+			truncated, filename, truncated, filename}, this->type, 4)
+	);
+	std::remove(truncated.c_str());
+	std::remove(filename.c_str());
+
+	for (auto& i : mixed) {
+		if (i.filename == truncated) continue;
+		BOOST_CHECK_EQUAL(i.filename, filename);
+		BOOST_CHECK_MESSAGE(
+			(i.type != LintIssue::Type::Unreadable)
+			&& (i.type != LintIssue::Type::NotInstance)
+			&& (i.type != LintIssue::Type::Truncated)
+			&& (i.type != LintIssue::Type::OpenFailed),
+			"Truncated file affected linting initialstate: " << i.message
+		);
+	}
+}
+
+void test_map2d::test_find_replace()
+{
+	BOOST_TEST_MESSAGE(this->basename << ": Find and replace tile codes");
+
+	EditJournal journal(this->map);
+	for (unsigned int l = 0; l < this->numLayers; l++) {
+		auto code = this->mapCode[l].code;
+		auto found = journal.findCode(l, code);
+		BOOST_CHECK_MESSAGE(
+			std::find_if(found.begin(), found.end(), [this, l](const Point& p) {
+				return (p.x == this->mapCode[l].pos.x)
+					&& (p.y == this->mapCode[l].pos.y);
+			}) != found.end(),
+			"Known tile on layer " << l << " was not found"
+		);
+
+		auto before = journal.countCode(l, code);
+		BOOST_CHECK_GE(before, found.size());
+		BOOST_CHECK_EQUAL(journal.codeUsage(l)[code], before);
+
+		auto otherBefore = journal.countCode(l, code + 1);
+		auto changed = journal.replaceCode(l, code, code + 1);
+		BOOST_CHECK_EQUAL(journal.countCode(l, code), before - changed);
+		BOOST_CHECK_EQUAL(journal.countCode(l, code + 1), otherBefore + changed);
+	}
+
+	while (journal.canUndo()) journal.undo();
+	this->checkData(&test_map2d::initialstate,
+		"Error saving map after undoing a replace - data is different to "
+		"original"
+	);
+
+	// Indices built before the items were changed elsewhere must be rebuilt
+	for (unsigned int l = 0; l < this->numLayers; l++) {
+		auto code = this->mapCode[l].code;
+		journal.countCode(l, code);
+		auto shifted = transformCodes(*this->map, l,
+			[](unsigned int code, unsigned int *newCode) {
+				*newCode = code + 1;
+				return true;
+			}
+		);
+		BOOST_REQUIRE_GE(shifted.changed, 1);
+
+		EditJournal fresh(this->map);
+		BOOST_CHECK_EQUAL(journal.countCode(l, code), fresh.countCode(l, code));
+		BOOST_CHECK_EQUAL(journal.countCode(l, code + 1),
+			fresh.countCode(l, code + 1));
+	}
+}
+
+void test_map2d::test_remap()
+{
+	BOOST_TEST_MESSAGE(this->basename << ": Remap tile codes");
+
+	// An empty table maps nothing, so every code in use is reported
+	auto none = remapCodes(*this->map, {});
+	BOOST_CHECK_EQUAL(none.changed, 0);
+	for (unsigned int l = 0; l < this->numLayers; l++) {
+		BOOST_CHECK_MESSAGE(none.unmapped.count(this->mapCode[l].code),
+			"Code on layer " << l << " was not reported as unmapped");
+	}
+
+	// Shift every code up by one and back again
+	for (unsigned int l = 0; l < this->numLayers; l++) {
+		auto up = transformCodes(*this->map, l,
+			[](unsigned int code, unsigned int *newCode) {
+				*newCode = code + 1;
+				return true;
+			}
+		);
+		BOOST_CHECK(up.unmapped.empty());
+		BOOST_CHECK_GE(up.changed, 1);
+
+		std::map<unsigned int, unsigned int> down;
+		for (auto& i : this->map->layers()[l]->itemView()) {
+			if (i.code != INVALID_TILECODE) down[i.code] = i.code - 1;
+		}
+		auto back = remapCodes(*this->map, l, down);
+		BOOST_CHECK(back.unmapped.empty());
+		BOOST_CHECK_EQUAL(back.changed, up.changed);
+	}
+
+	this->checkData(&test_map2d::initialstate,
+		"Error saving map after remapping codes there and back - data is "
+		"different to original"
+	);
+}
+
+void test_map2d::test_diff()
+{
+	BOOST_TEST_MESSAGE(this->basename << ": Diff two versions of a map and patch "
+		"one into the other");
+
+	auto original = snapshot(this->map);
+	BOOST_CHECK(diff(*original, *this->map).empty());
+
+	EditJournal journal(this->map);
+	journal.beginGroup();
+	for (unsigned int l = 0; l < this->numLayers; l++) {
+		journal.setCell(l, this->mapCode[l].pos, INVALID_TILECODE);
+	}
+	journal.endGroup();
+	auto edited = describeMap(*this->map);
+
+	auto patch = diff(*original, *this->map);
+	BOOST_REQUIRE_EQUAL(patch.cells.size(), this->numLayers);
+	for (unsigned int l = 0; l < this->numLayers; l++) {
+		auto& c = patch.cells[l];
+		BOOST_CHECK_EQUAL(c.layer, l);
+		BOOST_CHECK_EQUAL(c.pos.x, this->mapCode[l].pos.x);
+		BOOST_CHECK_EQUAL(c.pos.y, this->mapCode[l].pos.y);
+		BOOST_CHECK(c.after.empty());
+	}
+
+	// Patch the map back to where it started, as a single undo step
+	journal.applyPatch(patch.inverse());
+	BOOST_CHECK(diff(*original, *this->map).empty());
+
+	// The same patch shouldn't apply twice
+	BOOST_CHECK_THROW(journal.applyPatch(patch.inverse()), camoto::error);
+
+	journal.undo();
+	BOOST_CHECK_EQUAL(describeMap(*this->map), edited);
+	journal.redo();
+
+	this->checkData(&test_map2d::initialstate,
+		"Error saving map after patching it back to its original state - data "
+		"is different to original"
+	);
+}
+
+void test_map2d::test_fingerprint()
+{
+	BOOST_TEST_MESSAGE(this->basename << ": Fingerprint layers and keep the "
+		"hash up to date while editing");
+
+	auto original = fingerprint(*this->map);
+	BOOST_CHECK_EQUAL(fingerprint(*snapshot(this->map)), original);
+
+	EditJournal journal(this->map);
+	BOOST_CHECK_EQUAL(journal.fingerprint(), original);
+
+	for (unsigned int l = 0; l < this->numLayers; l++) {
+		auto before = journal.fingerprint(l);
+		journal.setCell(l, this->mapCode[l].pos, INVALID_TILECODE);
+		auto after = journal.fingerprint(l);
+		BOOST_CHECK_NE(after, before);
+		BOOST_CHECK_EQUAL(after, fingerprint(*this->map, l));
+	}
+	BOOST_CHECK_NE(journal.fingerprint(), original);
+
+	while (journal.canUndo()) journal.undo();
+	BOOST_CHECK_EQUAL(journal.fingerprint(), original);
+	BOOST_CHECK_EQUAL(fingerprint(*this->map), original);
+
+	// Changes made outside the journal, through Layer::items() or by restoring
+	// a snapshot, are picked up by the journal's next query
+	auto snap = snapshot(this->map);
+	for (unsigned int l = 0; l < this->numLayers; l++) {
+		auto code = this->mapCode[l].code;
+		journal.countCode(l, code);
+		journal.fingerprint(l);
+
+		auto target = this->mapCode[l].pos;
+		for (auto& i : this->map->layers()[l]->items()) {
+			if ((i.pos.x == target.x) && (i.pos.y == target.y)) i.code++;
+		}
+
+		EditJournal fresh(this->map);
+		BOOST_CHECK_EQUAL(journal.fingerprint(l), fingerprint(*this->map, l));
+		BOOST_CHECK_EQUAL(journal.countCode(l, code), fresh.countCode(l, code));
+		BOOST_CHECK_EQUAL(journal.findCode(l, code + 1).size(),
+			fresh.findCode(l, code + 1).size());
+	}
+	BOOST_CHECK_NE(journal.fingerprint(), original);
+
+	restoreSnapshot(*this->map, *snap);
+	BOOST_CHECK_EQUAL(journal.fingerprint(), original);
+	EditJournal fresh(this->map);
+	for (unsigned int l = 0; l < this->numLayers; l++) {
+		auto code = this->mapCode[l].code;
+		BOOST_CHECK_EQUAL(journal.countCode(l, code), fresh.countCode(l, code));
+	}
+}
+
+void test_map2d::test_cache()
+{
+	BOOST_TEST_MESSAGE(this->basename << ": Open through the map cache");
+
+	auto mapType = MapManager::byCode(this->type);
+	auto original = fingerprint(*this->map);
+
+	std::string dir = tempPath(this->basename + ".cache-test");
+	MapCache cache(dir, 0);
+	cache.clear();
+
+	// Leftover from a process that stopped while writing an entry
+	std::string abandoned = dir + "/0.c2d.tmp1-0";
+	const char *partial = "partial";
+	std::ofstream(abandoned.c_str()) << partial;
+	struct utimbuf old = {0, 0};
+	utime(abandoned.c_str(), &old);
+	BOOST_CHECK_EQUAL(cache.size(), strlen(partial));
+
+	bool hit = true;
+	std::shared_ptr<const Map2D> maps[2];
+	for (int i = 0; i < 2; i++) {
+		// Every open needs its own copy of the files
+		this->resetSuppData(false);
+		this->populateSuppData();
+		auto content = std::make_unique<stream::string>();
+		*content << this->initialstate();
+
+		maps[i] = cache.open(*mapType, std::move(content), this->suppData, &hit);
+		BOOST_REQUIRE(maps[i]);
+		BOOST_CHECK_EQUAL(hit, i == 1);
+		BOOST_CHECK_EQUAL(fingerprint(*maps[i]), original);
+	}
+	BOOST_CHECK(!std::ifstream(abandoned.c_str()));
+	BOOST_CHECK_GT(cache.size(), 0);
+
+	// A hit must behave the same as a miss
+	auto layers0 = maps[0]->layers(), layers1 = maps[1]->layers();
+	BOOST_REQUIRE_EQUAL(layers0.size(), layers1.size());
+	for (unsigned int l = 0; l < layers0.size(); l++) {
+		BOOST_CHECK(layers0[l]->caps() == layers1[l]->caps());
+		BOOST_CHECK_EQUAL(layers0[l]->availableItems().size(),
+			layers1[l]->availableItems().size());
+	}
+
+	std::ofstream(abandoned.c_str()) << "partial";
+	cache.clear();
+	BOOST_CHECK_EQUAL(cache.size(), 0);
+	std::remove(dir.c_str());
+}
+
+void test_map2d::test_pack()
+{
+	BOOST_TEST_MESSAGE(this->basename << ": Pack grid layers in memory");
+
+	auto expected = describeMap(*this->map);
+	auto original = fingerprint(*this->map);
+
+	auto numPacked = packLayers(*this->map);
+	BOOST_CHECK_EQUAL(describeMap(*this->map), expected);
+	BOOST_CHECK_EQUAL(fingerprint(*this->map), original);
+
+	this->checkData(&test_map2d::initialstate,
+		"Error saving map after packing its layers - data is different to "
+		"original"
+	);
+
+	// Reading the items unpacked them again, so they can be packed again
+	BOOST_CHECK_EQUAL(packLayers(*this->map), numPacked);
+	BOOST_CHECK_EQUAL(describeMap(*this->map), expected);
+
+	// Layers whose items were fetched with items() are packed too
+	for (auto& layer : this->map->layers()) layer->items();
+	BOOST_CHECK_EQUAL(packLayers(*this->map), numPacked);
+	BOOST_CHECK_EQUAL(describeMap(*this->map), expected);
+
+	// Editing unpacks the layer again
+	EditJournal journal(this->map);
+	journal.setCell(0, this->mapCode[0].pos, INVALID_TILECODE);
+	BOOST_CHECK_NE(fingerprint(*this->map), original);
+	journal.undo();
+	BOOST_CHECK_EQUAL(describeMap(*this->map), expected);
+}
+
+void test_map2d::test_fill_limit()
+{
+	BOOST_TEST_MESSAGE(this->basename << ": Filling counts tiles already placed "
+		"towards the limit");
+
+	EditJournal journal(this->map);
+	auto layers = this->map->layers();
+	for (unsigned int l = 0; l < layers.size(); l++) {
+		auto& layer = layers[l];
+		Point layerSize, tileSize;
+		getLayerDims(*this->map, *layer, &layerSize, &tileSize);
+		for (auto& t : layer->availableItems()) {
+			if (t.type != Map2D::Layer::Item::Type::Default) continue;
+			unsigned int maxCount = 0;
+			layer->tilePermittedAt(t, {0, 0}, &maxCount);
+			if (maxCount == 0) continue; // unlimited
+
+			auto existing = journal.countCode(l, t.code);
+			if (existing >= maxCount) continue;
+			std::size_t room = maxCount - existing;
+
+			// Find enough cells, not already holding the code, to go one past the
+			// limit
+			std::set<std::pair<long, long>> holding;
+			for (auto& i : layer->itemView()) {
+				if (i.code == t.code) holding.insert({i.pos.x, i.pos.y});
+			}
+			std::vector<Point> cells;
+			Point cell;
+			for (cell.y = 0; cell.y < layerSize.y; cell.y++) {
+				for (cell.x = 0; cell.x < layerSize.x; cell.x++) {
+					if (holding.count({cell.x, cell.y})) continue;
+					unsigned int cellMax;
+					if (layer->tilePermittedAt(t, cell, &cellMax)) cells.push_back(cell);
+					if (cells.size() > room) break;
+				}
+				if (cells.size() > room) break;
+			}
+			if (cells.size() <= room) continue;
+
+			// Each fill on its own is small enough, but together they reach the
+			// limit, so the next one must be refused
+			for (std::size_t i = 0; i < room; i++) {
+				journal.fillRegion(l, cells[i], {1, 1}, t.code);
+			}
+			BOOST_CHECK_EQUAL(journal.countCode(l, t.code), maxCount);
+			BOOST_CHECK_THROW(journal.fillRegion(l, cells[room], {1, 1}, t.code),
+				camoto::error);
+			BOOST_CHECK_EQUAL(journal.countCode(l, t.code), maxCount);
+
+			// Filling a cell that already holds the code adds nothing
+			BOOST_CHECK_NO_THROW(journal.fillRegion(l, cells[0], {1, 1}, t.code));
+		}
+	}
+
+	while (journal.canUndo()) journal.undo();
+	this->checkData(&test_map2d::initialstate,
+		"Error saving map after undoing limited fills - data is different to "
+		"original"
+	);
+}
+
+void test_map2d::test_arena()
+{
+	BOOST_TEST_MESSAGE(this->basename << ": Open a map in a memory arena");
+
+	auto mapType = MapManager::byCode(this->type);
+	auto expected = describeMap(*this->map);
+	auto original = fingerprint(*this->map);
+
+	MapArena arena;
+	{
+		this->resetSuppData(false);
+		this->populateSuppData();
+		auto content = std::make_unique<stream::string>();
+		*content << this->initialstate();
+
+		auto map = std::shared_ptr<Map>(
+			mapType->openInArena(std::move(content), this->suppData, arena));
+		auto map2d = std::dynamic_pointer_cast<Map2D>(map);
+		BOOST_REQUIRE(map2d);
+		BOOST_CHECK_GT(arena.size(), 0);
+		BOOST_CHECK_EQUAL(fingerprint(*map2d), original);
+		BOOST_CHECK_EQUAL(describeMap(*map2d), expected);
+
+		// Items lent out through items() move to the heap, but still work
+		auto layers = map2d->layers();
+		if (!layers.empty() && !layers[0]->items().empty()) {
+			auto& item = layers[0]->items()[0];
+			item.code++;
+			BOOST_CHECK_EQUAL(layers[0]->itemView()[0].code, item.code);
+		}
+	}
+	// The map has gone, so the arena can be released
+}
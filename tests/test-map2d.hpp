@@ -64,7 +64,23 @@ class test_map2d: public test_main
 		void test_write();
 		void test_codelist();
 		void test_codelist_valid();
+		void test_uniquecodes();
 		void test_attributes();
+		void test_concurrent_read();
+		void test_snapshot();
+		void test_journal();
+		void test_observer();
+		void test_region();
+		void test_validate();
+		void test_lint();
+		void test_find_replace();
+		void test_remap();
+		void test_diff();
+		void test_fingerprint();
+		void test_cache();
+		void test_pack();
+		void test_fill_limit();
+		void test_arena();
 
 	protected:
 		/// Initial state.
@@ -0,0 +1,101 @@
+/**
+ * @file   test-rle-wordresc.cpp
+ * @brief  Test code for the Word Rescue RLE codec.
+ *
+ * Copyright (C) 2010-2015 Adam Nielsen <malvineous@shikadi.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <camoto/stream_string.hpp>
+#include <camoto/gamemaps/rle-wordresc.hpp>
+#include "tests.hpp"
+
+using namespace camoto;
+using namespace camoto::gamemaps;
+
+BOOST_AUTO_TEST_SUITE(rle_wordresc)
+
+BOOST_AUTO_TEST_CASE(empty)
+{
+	BOOST_TEST_MESSAGE("Encode and decode nothing");
+
+	std::vector<uint8_t> in, out;
+	BOOST_CHECK_EQUAL(rleEncodeWR(in, out), 0);
+	BOOST_CHECK(out.empty());
+
+	uint8_t cells[4] = {9, 9, 9, 9};
+	unsigned long lenConsumed = 1;
+	BOOST_CHECK_EQUAL(rleDecodeWR(nullptr, 0, cells, sizeof(cells),
+		&lenConsumed), 0);
+	BOOST_CHECK_EQUAL(lenConsumed, 0);
+	BOOST_CHECK_EQUAL(cells[0], 9);
+}
+
+BOOST_AUTO_TEST_CASE(long_run)
+{
+	BOOST_TEST_MESSAGE("Split runs longer than 255 cells");
+
+	std::vector<uint8_t> in(300, 0x07), rle;
+	in.push_back(0x08);
+	BOOST_CHECK_EQUAL(rleEncodeWR(in, rle), 6);
+	const uint8_t expected[] = {0xFF, 0x07, 0x2D, 0x07, 0x01, 0x08};
+	BOOST_CHECK(rle == std::vector<uint8_t>(expected,
+		expected + sizeof(expected)));
+
+	std::vector<uint8_t> out(in.size());
+	unsigned long lenConsumed;
+	BOOST_CHECK_EQUAL(rleDecodeWR(rle.data(), rle.size(), out.data(),
+		out.size(), &lenConsumed), in.size());
+	BOOST_CHECK_EQUAL(lenConsumed, rle.size());
+	BOOST_CHECK(out == in);
+}
+
+BOOST_AUTO_TEST_CASE(truncated)
+{
+	BOOST_TEST_MESSAGE("Stop decoding when the input runs out");
+
+	// The last pair is missing its code byte
+	const uint8_t rle[] = {0x02, 0x05, 0x03};
+	uint8_t cells[8] = {};
+	unsigned long lenConsumed;
+	BOOST_CHECK_EQUAL(rleDecodeWR(rle, sizeof(rle), cells, sizeof(cells),
+		&lenConsumed), 2);
+	BOOST_CHECK_EQUAL(lenConsumed, 2);
+	BOOST_CHECK_EQUAL(cells[1], 0x05);
+	BOOST_CHECK_EQUAL(cells[2], 0x00);
+
+	// Reading from a stream leaves the unused byte behind
+	auto content = std::make_unique<stream::string>();
+	content->write(rle, sizeof(rle));
+	content->seekg(0, stream::start);
+	std::vector<uint8_t> out(8);
+	BOOST_CHECK_EQUAL(rleReadWR(*content, out), 2);
+	BOOST_CHECK_EQUAL(content->tellg(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(overrun)
+{
+	BOOST_TEST_MESSAGE("Cut a run short at the end of the output");
+
+	const uint8_t rle[] = {0x02, 0x05, 0xFF, 0x06, 0x01, 0x07};
+	uint8_t cells[6] = {};
+	unsigned long lenConsumed;
+	BOOST_CHECK_EQUAL(rleDecodeWR(rle, sizeof(rle), cells, 5, &lenConsumed), 5);
+	BOOST_CHECK_EQUAL(lenConsumed, 4);
+	BOOST_CHECK_EQUAL(cells[4], 0x06);
+	BOOST_CHECK_EQUAL(cells[5], 0x00);
+}
+
+BOOST_AUTO_TEST_SUITE_END()